@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/asmtowasm.dir/src/main.cpp.o"
+  "CMakeFiles/asmtowasm.dir/src/main.cpp.o.d"
+  "asmtowasm"
+  "asmtowasm.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/asmtowasm.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
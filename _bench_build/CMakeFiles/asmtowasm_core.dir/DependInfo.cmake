@@ -0,0 +1,32 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/assembly_lifter.cpp" "CMakeFiles/asmtowasm_core.dir/src/assembly_lifter.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/assembly_lifter.cpp.o.d"
+  "/root/repo/src/assembly_parser.cpp" "CMakeFiles/asmtowasm_core.dir/src/assembly_parser.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/assembly_parser.cpp.o.d"
+  "/root/repo/src/calling_convention.cpp" "CMakeFiles/asmtowasm_core.dir/src/calling_convention.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/calling_convention.cpp.o.d"
+  "/root/repo/src/control_flow.cpp" "CMakeFiles/asmtowasm_core.dir/src/control_flow.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/control_flow.cpp.o.d"
+  "/root/repo/src/inline_analysis.cpp" "CMakeFiles/asmtowasm_core.dir/src/inline_analysis.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/inline_analysis.cpp.o.d"
+  "/root/repo/src/instruction_table.cpp" "CMakeFiles/asmtowasm_core.dir/src/instruction_table.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/instruction_table.cpp.o.d"
+  "/root/repo/src/ir_verifier.cpp" "CMakeFiles/asmtowasm_core.dir/src/ir_verifier.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/ir_verifier.cpp.o.d"
+  "/root/repo/src/line_scanner.cpp" "CMakeFiles/asmtowasm_core.dir/src/line_scanner.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/line_scanner.cpp.o.d"
+  "/root/repo/src/mapped_file.cpp" "CMakeFiles/asmtowasm_core.dir/src/mapped_file.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/mapped_file.cpp.o.d"
+  "/root/repo/src/parse_cache.cpp" "CMakeFiles/asmtowasm_core.dir/src/parse_cache.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/parse_cache.cpp.o.d"
+  "/root/repo/src/stack_frame.cpp" "CMakeFiles/asmtowasm_core.dir/src/stack_frame.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/stack_frame.cpp.o.d"
+  "/root/repo/src/strength_reduction.cpp" "CMakeFiles/asmtowasm_core.dir/src/strength_reduction.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/strength_reduction.cpp.o.d"
+  "/root/repo/src/symbol_table.cpp" "CMakeFiles/asmtowasm_core.dir/src/symbol_table.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/symbol_table.cpp.o.d"
+  "/root/repo/src/wasm_generator.cpp" "CMakeFiles/asmtowasm_core.dir/src/wasm_generator.cpp.o" "gcc" "CMakeFiles/asmtowasm_core.dir/src/wasm_generator.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
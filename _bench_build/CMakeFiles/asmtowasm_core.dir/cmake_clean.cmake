@@ -0,0 +1,37 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/asmtowasm_core.dir/src/assembly_lifter.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/assembly_lifter.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/assembly_parser.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/assembly_parser.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/calling_convention.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/calling_convention.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/control_flow.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/control_flow.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/inline_analysis.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/inline_analysis.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/instruction_table.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/instruction_table.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/ir_verifier.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/ir_verifier.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/line_scanner.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/line_scanner.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/mapped_file.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/mapped_file.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/parse_cache.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/parse_cache.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/stack_frame.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/stack_frame.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/strength_reduction.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/strength_reduction.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/symbol_table.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/symbol_table.cpp.o.d"
+  "CMakeFiles/asmtowasm_core.dir/src/wasm_generator.cpp.o"
+  "CMakeFiles/asmtowasm_core.dir/src/wasm_generator.cpp.o.d"
+  "libasmtowasm_core.a"
+  "libasmtowasm_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/asmtowasm_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
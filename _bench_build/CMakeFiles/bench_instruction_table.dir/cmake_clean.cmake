@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_instruction_table.dir/bench/bench_instruction_table.cpp.o"
+  "CMakeFiles/bench_instruction_table.dir/bench/bench_instruction_table.cpp.o.d"
+  "bench_instruction_table"
+  "bench_instruction_table.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_instruction_table.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_lifecycle.dir/bench/bench_lifecycle.cpp.o"
+  "CMakeFiles/bench_lifecycle.dir/bench/bench_lifecycle.cpp.o.d"
+  "bench_lifecycle"
+  "bench_lifecycle.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_lifecycle.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_line_scanner.dir/bench/bench_line_scanner.cpp.o"
+  "CMakeFiles/bench_line_scanner.dir/bench/bench_line_scanner.cpp.o.d"
+  "bench_line_scanner"
+  "bench_line_scanner.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_line_scanner.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
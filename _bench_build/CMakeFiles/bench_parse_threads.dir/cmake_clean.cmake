@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_parse_threads.dir/bench/bench_parse_threads.cpp.o"
+  "CMakeFiles/bench_parse_threads.dir/bench/bench_parse_threads.cpp.o.d"
+  "bench_parse_threads"
+  "bench_parse_threads.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_parse_threads.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
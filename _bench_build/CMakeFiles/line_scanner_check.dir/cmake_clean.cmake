@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/line_scanner_check.dir/tests/line_scanner_check.cpp.o"
+  "CMakeFiles/line_scanner_check.dir/tests/line_scanner_check.cpp.o.d"
+  "line_scanner_check"
+  "line_scanner_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/line_scanner_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/parse_cache_check.dir/tests/parse_cache_check.cpp.o"
+  "CMakeFiles/parse_cache_check.dir/tests/parse_cache_check.cpp.o.d"
+  "parse_cache_check"
+  "parse_cache_check.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/parse_cache_check.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
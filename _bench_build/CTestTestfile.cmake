@@ -0,0 +1,10 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_bench_build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(line_scanner_check "/root/repo/_bench_build/line_scanner_check")
+set_tests_properties(line_scanner_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;86;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(parse_cache_check "/root/repo/_bench_build/parse_cache_check")
+set_tests_properties(parse_cache_check PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;86;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,79 @@
+#pragma once
+
+// ベンチマーク共通の入力生成と計時
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#define ASMTOWASM_BENCH_TSC 1
+#endif
+
+namespace asmtowasm::bench
+{
+
+  // 関数、ラベル、コメント、メモリオペランドを含むアセンブリをtargetBytes程度生成
+  // 関数は互いに独立（CALLとジャンプは同じ関数内のラベルだけを参照）
+  inline std::string generateAssembly(size_t targetBytes)
+  {
+    static const char *const kBody[] = {
+        "    mov %eax, 10          # カウンタを初期化\n",
+        "    mov %ebx, 0\n",
+        "    add %ebx, %eax\n",
+        "    mov %edx, (%esi+%ebx*4)  # 配列の要素\n",
+        "    movl 8(%esi,%ecx,4), %edi\n",
+        "    sub %eax, 1\n",
+        "    mul %ecx, 3\n",
+        "    mov -4(%ebp), %ecx\n",
+        "    cmp %eax, 0\n",
+    };
+    std::string text;
+    text.reserve(targetBytes + 256);
+    for (size_t function = 0; text.size() < targetBytes; ++function)
+    {
+      const std::string name = "fn" + std::to_string(function);
+      text += name + ":\n";
+      for (size_t line = 0; line < 3 * (sizeof(kBody) / sizeof(kBody[0])); ++line)
+      {
+        text += kBody[(line + function) % (sizeof(kBody) / sizeof(kBody[0]))];
+      }
+      text += "    jle " + name + "_done\n";
+      text += "    add %eax, 0x1f\n";
+      text += name + "_done:\n";
+      text += "    ret %eax\n\n";
+    }
+    text += "main:\n    mov %eax, 0\n    ret\n";
+    return text;
+  }
+
+  // ファイルの内容（読めなければ空）
+  inline std::string readFile(const std::string &filename)
+  {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+  }
+
+  // タイムスタンプカウンタ（x86以外では0）
+  // 不変TSCの刻みは基準周波数なので、ターボ時のコアのサイクル数とは一致しない
+  inline uint64_t readCycles()
+  {
+#ifdef ASMTOWASM_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  inline double secondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+} // namespace asmtowasm::bench
@@ -0,0 +1,196 @@
+// InstructionTable（列指向）と以前の命令ごとの構造体配列のメモリ量と走査速度
+//   bench_instruction_table [入力ファイル] [繰り返し回数]
+// 入力ファイルを省略すると8 MiBのアセンブリを生成する
+
+#include "assembly_parser.h"
+#include "bench_common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // 生存中のヒープのバイト数（割り当てごとに先頭へサイズを置いて数える）
+  size_t liveHeapBytes = 0;
+  constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+  void *allocate(size_t size)
+  {
+    void *block = std::malloc(size + kHeaderSize);
+    if (!block)
+    {
+      throw std::bad_alloc();
+    }
+    *static_cast<size_t *>(block) = size;
+    liveHeapBytes += size;
+    return static_cast<char *>(block) + kHeaderSize;
+  }
+
+  void release(void *pointer) noexcept
+  {
+    if (!pointer)
+    {
+      return;
+    }
+    void *block = static_cast<char *>(pointer) - kHeaderSize;
+    liveHeapBytes -= *static_cast<size_t *>(block);
+    std::free(block);
+  }
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, size_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { release(pointer); }
+
+namespace
+{
+  using namespace asmtowasm;
+
+  // 以前のレイアウト: 命令ごとにオペランドのvectorとラベル文字列、オペランドごとに元の文字列
+  struct LegacyOperand
+  {
+    OperandType type;
+    RegisterId reg;
+    int64_t immediate;
+    MemoryOperand memory;
+    std::string value;
+  };
+
+  struct LegacyInstruction
+  {
+    InstructionType type;
+    std::vector<LegacyOperand> operands;
+    std::string label;
+  };
+
+  // オペランドの元の表記（以前のパーサーが保持していた文字列の代わり）
+  std::string operandText(const InstructionTable &table, const Operand &operand)
+  {
+    switch (operand.type)
+    {
+    case OperandType::REGISTER:
+      return registerName(operand.reg);
+    case OperandType::IMMEDIATE:
+      return std::to_string(operand.immediate);
+    case OperandType::LABEL:
+      return std::string(table.symbolName(operand.symbol));
+    case OperandType::MEMORY:
+      return table.formatOperand(operand);
+    }
+    return {};
+  }
+
+  std::vector<LegacyInstruction> toLegacy(const InstructionTable &table)
+  {
+    std::vector<LegacyInstruction> instructions;
+    instructions.reserve(table.size());
+    for (InstructionView view : table)
+    {
+      LegacyInstruction instruction{view.type(), {}, std::string(view.label())};
+      instruction.operands.reserve(view.operands().size());
+      for (const Operand &operand : view.operands())
+      {
+        instruction.operands.push_back(
+            {operand.type, operand.reg, operand.immediate, operand.memory, operandText(table, operand)});
+      }
+      instructions.push_back(std::move(instruction));
+    }
+    return instructions;
+  }
+
+  // 解析パスと同じく全命令・全オペランドを読む
+  uint64_t walk(const InstructionTable &table)
+  {
+    uint64_t sum = 0;
+    for (InstructionView view : table)
+    {
+      sum += static_cast<uint64_t>(view.type()) + view.hasLabel();
+      for (const Operand &operand : view.operands())
+      {
+        sum += static_cast<uint64_t>(operand.type) + static_cast<uint64_t>(operand.reg) +
+               static_cast<uint64_t>(operand.immediate) + static_cast<uint64_t>(operand.memory.displacement);
+      }
+    }
+    return sum;
+  }
+
+  uint64_t walk(const std::vector<LegacyInstruction> &instructions)
+  {
+    uint64_t sum = 0;
+    for (const LegacyInstruction &instruction : instructions)
+    {
+      sum += static_cast<uint64_t>(instruction.type) + !instruction.label.empty();
+      for (const LegacyOperand &operand : instruction.operands)
+      {
+        sum += static_cast<uint64_t>(operand.type) + static_cast<uint64_t>(operand.reg) +
+               static_cast<uint64_t>(operand.immediate) + static_cast<uint64_t>(operand.memory.displacement);
+      }
+    }
+    return sum;
+  }
+
+  // 全命令の走査を繰り返した最速の1回（秒）
+  template <typename Instructions>
+  double measureWalk(const Instructions &instructions, int repeats, uint64_t &checksum)
+  {
+    double best = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      checksum = walk(instructions);
+      const double seconds = bench::secondsSince(start);
+      best = r == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const std::string text = argc > 1 ? bench::readFile(argv[1]) : bench::generateAssembly(8 << 20);
+  const int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+  // パーサーのログは計測から外す
+  std::streambuf *output = std::cout.rdbuf(nullptr);
+  AssemblyParser parser;
+  parser.setThreadCount(1);
+  const bool parsed = parser.parseBuffer(text.data(), text.size());
+  std::cout.rdbuf(output);
+  if (!parsed)
+  {
+    std::cerr << "パースエラー: " << parser.getErrorMessage() << "\n";
+    return 1;
+  }
+
+  // どちらもコピーを作り、その間に増えたヒープを数える（記号表を含む）
+  size_t before = liveHeapBytes;
+  const InstructionTable table = parser.getInstructions();
+  const size_t tableBytes = liveHeapBytes - before;
+
+  before = liveHeapBytes;
+  const std::vector<LegacyInstruction> legacy = toLegacy(table);
+  const size_t legacyBytes = liveHeapBytes - before;
+
+  uint64_t tableSum = 0;
+  uint64_t legacySum = 0;
+  const double tableSeconds = measureWalk(table, repeats, tableSum);
+  const double legacySeconds = measureWalk(legacy, repeats, legacySum);
+
+  std::printf("入力: %zu バイト, %zu 命令, 走査は繰り返し %d 回（最速値）\n", text.size(), table.size(), repeats);
+  std::printf("%-18s  %10s  %12s  %10s\n", "layout", "heap MiB", "bytes/instr", "walk ms");
+  std::printf("%-18s  %10.1f  %12.1f  %10.2f\n", "legacy (AoS)", legacyBytes / 1048576.0,
+              legacyBytes / double(std::max<size_t>(1, legacy.size())), legacySeconds * 1e3);
+  std::printf("%-18s  %10.1f  %12.1f  %10.2f\n", "InstructionTable", tableBytes / 1048576.0,
+              tableBytes / double(std::max<size_t>(1, table.size())), tableSeconds * 1e3);
+  std::printf("メモリ %.1fx 削減, 走査 %.2fx 高速%s\n", legacyBytes / double(std::max<size_t>(1, tableBytes)),
+              legacySeconds / tableSeconds, tableSum == legacySum ? "" : "  (チェックサム不一致)");
+  return 0;
+}
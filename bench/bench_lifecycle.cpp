@@ -0,0 +1,209 @@
+// 小さな入力ごとのリフト+生成の遅延: 毎回新しいインスタンス（cold）と compile() での再利用（warm）
+//   bench_lifecycle [入力ディレクトリ|-] [ラウンド数] [-O0|-O1|-O2|-O3|-Os]
+// ディレクトリを渡すとその中の .asm をすべて使い（例: examples）、省略すると大きさの違う入力を生成する
+// 計時の前に、再利用したインスタンスの出力が新しいインスタンスの出力と一致するかを確かめる
+
+#include "assembly_lifter.h"
+#include "assembly_parser.h"
+#include "bench_common.h"
+#include "wasm_generator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  using namespace asmtowasm;
+
+  struct Snippet
+  {
+    std::string name;
+    std::string text;
+  };
+
+  std::vector<Snippet> loadSnippets(const char *directory)
+  {
+    std::vector<Snippet> snippets;
+    if (directory)
+    {
+      for (const auto &entry : std::filesystem::directory_iterator(directory))
+      {
+        if (entry.path().extension() == ".asm")
+        {
+          snippets.push_back({entry.path().filename().string(), bench::readFile(entry.path().string())});
+        }
+      }
+      std::sort(snippets.begin(), snippets.end(),
+                [](const Snippet &a, const Snippet &b) { return a.name < b.name; });
+      return snippets;
+    }
+    for (size_t i = 0; i < 32; ++i)
+    {
+      snippets.push_back({"generated" + std::to_string(i), bench::generateAssembly(256 + 192 * i)});
+    }
+    return snippets;
+  }
+
+  bool parseLevel(const std::string &arg, OptimizationLevel &level)
+  {
+    if (arg == "-O0")
+      level = OptimizationLevel::O0;
+    else if (arg == "-O1")
+      level = OptimizationLevel::O1;
+    else if (arg == "-O2")
+      level = OptimizationLevel::O2;
+    else if (arg == "-O3")
+      level = OptimizationLevel::O3;
+    else if (arg == "-Os")
+      level = OptimizationLevel::Os;
+    else
+      return false;
+    return true;
+  }
+
+  // 1つの入力をリフトして生成し、テキスト形式とバイナリを返す
+  // warmなら compile()（reset()してから生成）、coldなら新しいインスタンスとして生成する
+  bool translate(AssemblyLifter &lifter, WasmGenerator &generator, const AssemblyParser &parser, bool warm,
+                 const std::string &binaryPath, std::string &output)
+  {
+    const bool lifted = warm ? lifter.compile(parser.getInstructions(), parser.getLabels())
+                             : lifter.liftToLLVM(parser.getInstructions(), parser.getLabels());
+    if (!lifted)
+    {
+      return false;
+    }
+    const bool generated = warm ? generator.compile(lifter.getModule(), &parser.getInstructions().symbols())
+                                : generator.generateWasm(lifter.getModule(), &parser.getInstructions().symbols());
+    if (!generated || !generator.writeWasmToFile(binaryPath))
+    {
+      return false;
+    }
+    output = generator.getWastString() + bench::readFile(binaryPath);
+    return true;
+  }
+
+  void printStats(const char *name, std::vector<double> microseconds)
+  {
+    std::sort(microseconds.begin(), microseconds.end());
+    double sum = 0;
+    for (double value : microseconds)
+    {
+      sum += value;
+    }
+    std::printf("%-5s  %6zu  %10.0f  %10.0f  %10.0f\n", name, microseconds.size(), sum / microseconds.size(),
+                microseconds[microseconds.size() / 2], microseconds[microseconds.size() * 9 / 10]);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const char *directory = argc > 1 && std::string(argv[1]) != "-" ? argv[1] : nullptr;
+  const int rounds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+  OptimizationLevel level = OptimizationLevel::O0;
+  if (argc > 3 && !parseLevel(argv[3], level))
+  {
+    std::cerr << "エラー: 不明な最適化レベル: " << argv[3] << "\n";
+    return 1;
+  }
+
+  const std::vector<Snippet> snippets = loadSnippets(directory);
+  if (snippets.empty())
+  {
+    std::cerr << "エラー: 入力がありません\n";
+    return 1;
+  }
+  std::vector<AssemblyParser> parsers(snippets.size());
+  const std::string binaryPath = (std::filesystem::temp_directory_path() / "bench_lifecycle.wasm").string();
+
+  // パーサー、リフター、生成器のログは計測から外す
+  std::streambuf *output = std::cout.rdbuf(nullptr);
+  auto fail = [&](const char *what, const Snippet &snippet, const std::string &message)
+  {
+    std::cout.rdbuf(output);
+    std::cerr << what << " (" << snippet.name << "): " << message << "\n";
+    return 1;
+  };
+
+  // 新しいインスタンスでの出力
+  std::vector<std::string> expected(snippets.size());
+  for (size_t i = 0; i < snippets.size(); ++i)
+  {
+    if (!parsers[i].parseString(snippets[i].text))
+    {
+      return fail("パースエラー", snippets[i], parsers[i].getErrorMessage());
+    }
+    AssemblyLifter lifter;
+    lifter.setOptimizationLevel(level);
+    WasmGenerator generator;
+    if (!translate(lifter, generator, parsers[i], false, binaryPath, expected[i]))
+    {
+      return fail("変換エラー", snippets[i], lifter.getErrorMessage() + generator.getErrorMessage());
+    }
+  }
+
+  // 1組のインスタンスを順番を混ぜて3周再利用し、前のジョブの状態が漏れていないか確かめる
+  AssemblyLifter warmLifter;
+  warmLifter.setOptimizationLevel(level);
+  WasmGenerator warmGenerator;
+  std::vector<size_t> order;
+  for (int pass = 0; pass < 3; ++pass)
+  {
+    for (size_t i = 0; i < snippets.size(); ++i)
+    {
+      order.push_back(i);
+    }
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(1));
+  size_t mismatches = 0;
+  for (size_t i : order)
+  {
+    std::string actual;
+    if (!translate(warmLifter, warmGenerator, parsers[i], true, binaryPath, actual) || actual != expected[i])
+    {
+      ++mismatches;
+    }
+  }
+  std::filesystem::remove(binaryPath);
+
+  // 入力ごとのリフト+生成（テキスト形式まで）の遅延
+  std::vector<double> cold;
+  std::vector<double> warm;
+  for (int round = 0; round < rounds; ++round)
+  {
+    for (const AssemblyParser &parser : parsers)
+    {
+      auto start = std::chrono::steady_clock::now();
+      {
+        AssemblyLifter lifter;
+        lifter.setOptimizationLevel(level);
+        WasmGenerator generator;
+        lifter.liftToLLVM(parser.getInstructions(), parser.getLabels());
+        generator.generateWasm(lifter.getModule(), &parser.getInstructions().symbols());
+        volatile size_t size = generator.getWastString().size();
+        (void)size;
+      }
+      cold.push_back(bench::secondsSince(start) * 1e6);
+
+      start = std::chrono::steady_clock::now();
+      warmLifter.compile(parser.getInstructions(), parser.getLabels());
+      warmGenerator.compile(warmLifter.getModule(), &parser.getInstructions().symbols());
+      volatile size_t size = warmGenerator.getWastString().size();
+      (void)size;
+      warm.push_back(bench::secondsSince(start) * 1e6);
+    }
+  }
+  std::cout.rdbuf(output);
+
+  std::printf("入力: %zu 個, %d ラウンド\n", snippets.size(), rounds);
+  std::printf("再利用の出力の不一致: %zu / %zu（テキスト形式とバイナリ）\n", mismatches, order.size());
+  std::printf("%-5s  %6s  %10s  %10s  %10s\n", "", "jobs", "mean us", "p50 us", "p90 us");
+  printStats("cold", cold);
+  printStats("warm", warm);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+// 行スキャナの分類カーネル（AVX2 / SSE2 / スカラー）ごとのバイト/サイクル
+//   bench_line_scanner [入力ファイル] [繰り返し回数]
+// 入力ファイルを省略すると8 MiBのアセンブリを生成する
+
+#include "bench_common.h"
+#include "line_scanner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  using namespace asmtowasm;
+
+  struct Result
+  {
+    double bytesPerCycle = 0;
+    double gigabytesPerSecond = 0;
+  };
+
+  // 繰り返しのうち最速の1回
+  template <typename Body>
+  Result measure(size_t bytes, int repeats, Body body)
+  {
+    Result best;
+    for (int r = 0; r < repeats; ++r)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      const uint64_t cycles = bench::readCycles();
+      body();
+      const uint64_t elapsedCycles = bench::readCycles() - cycles;
+      const double seconds = bench::secondsSince(start);
+      best.bytesPerCycle = std::max(best.bytesPerCycle, elapsedCycles ? bytes / double(elapsedCycles) : 0.0);
+      best.gigabytesPerSecond = std::max(best.gigabytesPerSecond, bytes / seconds / 1e9);
+    }
+    return best;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  std::string text = argc > 1 ? bench::readFile(argv[1]) : bench::generateAssembly(8 << 20);
+  const int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+  if (text.empty())
+  {
+    std::cerr << "エラー: 入力が空です\n";
+    return 1;
+  }
+  // 分類だけの計測はブロック単位なので、末尾を64バイトに揃える
+  const size_t blockBytes = text.size() / LineScanner::kBlockSize * LineScanner::kBlockSize;
+
+  std::printf("入力: %zu バイト, 繰り返し %d 回（最速値、サイクルはTSCの刻み）\n", text.size(), repeats);
+  std::printf("%-8s  %13s  %9s  %14s  %11s\n", "kernel", "classify B/c", "GB/s", "scan B/c", "GB/s");
+  uint64_t checksum = 0;
+  for (const char *name : {"avx2", "sse2", "scalar"})
+  {
+    if (!LineScanner::useKernel(name))
+    {
+      std::printf("%-8s  (このCPUでは使えません)\n", name);
+      continue;
+    }
+
+    // 64バイトブロックの文字種分類だけ
+    const Result classify = measure(blockBytes, repeats, [&]()
+                                    {
+                                      BlockMasks masks;
+                                      for (size_t offset = 0; offset < blockBytes; offset += LineScanner::kBlockSize)
+                                      {
+                                        LineScanner::classifyBlock(text.data() + offset, masks);
+                                        checksum += masks.newline ^ masks.blank;
+                                      }
+                                    });
+
+    // パーサーと同じ行とトークンへの分割
+    const Result scan = measure(text.size(), repeats, [&]()
+                                {
+                                  LineScanner scanner(text.data(), text.size());
+                                  std::vector<std::string_view> tokens;
+                                  while (scanner.nextLine(tokens))
+                                  {
+                                    checksum += tokens.size();
+                                  }
+                                });
+
+    std::printf("%-8s  %13.2f  %9.2f  %14.2f  %11.2f\n", name, classify.bytesPerCycle, classify.gigabytesPerSecond,
+                scan.bytesPerCycle, scan.gigabytesPerSecond);
+  }
+  std::printf("(checksum %llu)\n", static_cast<unsigned long long>(checksum));
+  return 0;
+}
@@ -0,0 +1,70 @@
+// --parse-threads 1..N の並列パースの速度向上
+//   bench_parse_threads [入力ファイル] [最大スレッド数] [繰り返し回数]
+// 入力ファイルを省略すると32 MiBのアセンブリを生成する（最大スレッド数の既定はハードウェアの並列度）
+
+#include "assembly_parser.h"
+#include "bench_common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[])
+{
+  using namespace asmtowasm;
+
+  const std::string text = argc > 1 && std::string(argv[1]) != "-" ? bench::readFile(argv[1])
+                                                                    : bench::generateAssembly(32 << 20);
+  const unsigned maxThreads =
+      argc > 2 ? std::max(1, std::atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+  const int repeats = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+  if (text.size() < AssemblyParser::kParallelParseThreshold)
+  {
+    std::cerr << "警告: 入力が " << AssemblyParser::kParallelParseThreshold
+              << " バイト未満のため、すべて逐次パースになります\n";
+  }
+
+  std::printf("入力: %zu バイト, 繰り返し %d 回（最速値）, ハードウェアの並列度 %u\n", text.size(), repeats,
+              std::thread::hardware_concurrency());
+  std::printf("%7s  %9s  %8s  %8s  %12s\n", "threads", "ms", "MB/s", "speedup", "instructions");
+
+  // パーサーのログは計測から外す
+  std::streambuf *output = std::cout.rdbuf(nullptr);
+  double baseline = 0;
+  size_t baselineInstructions = 0;
+  for (unsigned threads = 1; threads <= maxThreads; ++threads)
+  {
+    double best = 0;
+    size_t instructions = 0;
+    for (int r = 0; r < repeats; ++r)
+    {
+      AssemblyParser parser;
+      parser.setThreadCount(threads);
+      const auto start = std::chrono::steady_clock::now();
+      if (!parser.parseBuffer(text.data(), text.size()))
+      {
+        std::cout.rdbuf(output);
+        std::cerr << "パースエラー: " << parser.getErrorMessage() << "\n";
+        return 1;
+      }
+      const double seconds = bench::secondsSince(start);
+      best = r == 0 ? seconds : std::min(best, seconds);
+      instructions = parser.getInstructions().size();
+    }
+    if (threads == 1)
+    {
+      baseline = best;
+      baselineInstructions = instructions;
+    }
+
+    std::cout.rdbuf(output);
+    std::printf("%7u  %9.1f  %8.1f  %7.2fx  %12zu%s\n", threads, best * 1e3, text.size() / best / 1e6, baseline / best,
+                instructions, instructions == baselineInstructions ? "" : "  (逐次と不一致)");
+    std::cout.rdbuf(nullptr);
+  }
+  std::cout.rdbuf(output);
+  return 0;
+}
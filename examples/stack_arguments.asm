@@ -0,0 +1,30 @@
+# スタックで引数を渡す（cdecl）
+# 呼び出し元が引数をPUSHして呼び、戻ってから add %esp で取り除く
+# 呼び出し先は 4(%esp) から引数を読む（0(%esp) は戻りアドレスのスロット）
+
+main:
+    push 30            # 第2引数
+    push 12            # 第1引数
+    call diff
+    add %esp, 8        # 引数を取り除く（スタックポインタは元に戻る）
+    push %eax
+    call twice
+    add %esp, 4
+    ret %eax           # 結果: 2 * (12 - 30) = -36
+
+diff:
+    # 引数: 4(%esp) (a), 8(%esp) (b)
+    # 戻り値: %eax (a - b)
+    mov %eax, 4(%esp)
+    mov %ecx, 8(%esp)
+    sub %eax, %ecx
+    ret
+
+twice:
+    # %ebpのフレームから引数を読む
+    push %ebp
+    mov %ebp, %esp
+    mov %eax, 8(%ebp)
+    add %eax, %eax
+    pop %ebp
+    ret
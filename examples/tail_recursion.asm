@@ -0,0 +1,22 @@
+# 末尾位置の自己再帰
+# count(n, acc): n が 0 以下になるまで acc に n を足し、n を1ずつ減らして自分を呼ぶ
+# --enable-tail-call なしでは入口直後のループヘッダーへの分岐になり（%eax と %ebx はphiで受ける）、
+# 付けると return_call になる
+
+main:
+    mov %eax, 10       # n
+    mov %ebx, 0        # acc
+    call count
+    ret %ebx           # 結果: 55
+
+count:
+    # 引数: %eax (n), %ebx (acc)
+    # 戻り値: %ebx (acc + n + (n-1) + ... + 1)
+    cmp %eax, 0
+    jle done
+    add %ebx, %eax
+    sub %eax, 1
+    call count         # 末尾呼び出し
+    ret
+done:
+    ret
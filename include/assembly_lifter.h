@@ -1,6 +1,11 @@
 #pragma once
 
 #include "assembly_parser.h"
+#include "calling_convention.h"
+#include "control_flow.h"
+#include "inline_analysis.h"
+#include "ir_verifier.h"
+#include "stack_frame.h"
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
@@ -11,16 +16,38 @@
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/IRBuilder.h>
-#include <llvm/IR/Verifier.h>
+#include <llvm/IR/ValueHandle.h>
 #include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <iosfwd>
 #include <memory>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace asmtowasm
 {
 
+  // 最適化レベル（-O0 … -O3、-Os）
+  enum class OptimizationLevel
+  {
+    O0, // 最適化しない
+    O1,
+    O2,
+    O3,
+    Os // サイズ優先
+  };
+
+  // 呼び出し元へインライン展開した関数（CLIの報告用）
+  struct InlinedFunction
+  {
+    std::string name;
+    uint32_t size = 0;      // 本体の命令数
+    uint32_t callSites = 0; // 展開したCALLの数
+  };
+
   // Assemblyリフタークラス
   class AssemblyLifter
   {
@@ -28,76 +55,276 @@ namespace asmtowasm
     AssemblyLifter();
     ~AssemblyLifter() = default;
 
-    // AssemblyコードからLLVM IRを生成
-    bool liftToLLVM(const std::vector<Instruction> &instructions,
-                    const std::map<std::string, size_t> &labels);
+    // AssemblyコードからLLVM IRを生成（新しいインスタンスか、reset()の後に呼ぶ）
+    bool liftToLLVM(const InstructionTable &instructions,
+                    const LabelTable &labels);
+
+    // 前のジョブのモジュールと解析結果を捨てる
+    // LLVMContext（型と定数）とIRBuilder、設定（最適化レベル、スレッド数など）は次のジョブへ引き継ぐ
+    // 以前のgetModule()のモジュールは破棄される
+    void reset();
+
+    // reset()してからliftToLLVM（1つのインスタンスで小さな入力を繰り返しリフトする用途）
+    bool compile(const InstructionTable &instructions, const LabelTable &labels);
 
     // LLVMモジュールを取得
     llvm::Module *getModule() const { return module_.get(); }
 
+    // liftToLLVMの最後に適用する最適化レベル（既定は-O0）
+    void setOptimizationLevel(OptimizationLevel level) { optimizationLevel_ = level; }
+
+    // 関数ごとの並列リフトに使うスレッド数（0はハードウェアの並列度、1は逐次リフト）
+    void setThreadCount(unsigned threadCount) { threadCount_ = threadCount; }
+
+    // Wasmの末尾呼び出し（return_call）を使うか（使わなければ自己再帰の末尾呼び出しはループにする）
+    void setTailCallEnabled(bool enabled) { tailCallEnabled_ = enabled; }
+
+    // 小さな葉関数をCALLの位置へインライン展開するか（既定は展開する）
+    void setInliningEnabled(bool enabled) { inliningEnabled_ = enabled; }
+
+    // IRを検証するタイミング（既定はWasm生成へ渡す直前に一度）
+    // 検証のスレッド数はsetThreadCountと共有する
+    void setVerifyMode(VerifyMode mode) { verifyMode_ = mode; }
+
+    // liftToLLVMでインライン展開した関数（関数の記号順）
+    const std::vector<InlinedFunction> &getInlinedFunctions() const { return inlinedFunctions_; }
+
+    // 並列リフトに切り替える命令数の下限
+    static constexpr size_t kParallelLiftThreshold = 1 << 14;
+
     // エラーメッセージを取得
     const std::string &getErrorMessage() const { return errorMessage_; }
 
   private:
+    // レジスタ以外にリフターが保持する状態（レジスタファイルでは汎用レジスタの後ろに並ぶ）
+    enum class PseudoRegister : uint8_t
+    {
+      CMP_LHS, // 直前のCMPの左オペランド
+      CMP_RHS, // 直前のCMPの右オペランド
+      COUNT
+    };
+    static constexpr size_t kRegisterSlotCount = kFullRegisterCount + static_cast<size_t>(PseudoRegister::COUNT);
+
+    // レジスタファイル: 汎用レジスタと擬似レジスタの値（サブレジスタは格納先のスロットを共有、未定義はnull）
+    // スロットの型はgetRegisterType()（64ビットレジスタを使う入力ではi64、それ以外はi32）
+    using RegisterFile = std::array<llvm::WeakTrackingVH, kRegisterSlotCount>;
+
+    // SSA構築用のブロックごとの状態
+    // 変数の番号はレジスタファイルのスロット、その後ろに昇格したスタックのスロットが続く
+    struct BlockState
+    {
+      RegisterFile definitions;                                       // ブロック末尾でのレジスタファイル
+      std::vector<llvm::WeakTrackingVH> stackSlots;                   // ブロック末尾でのスタックのスロット
+      std::vector<std::pair<size_t, llvm::PHINode *>> incompletePhis; // 封鎖前に作ったオペランドなしのphi
+      uint64_t walk = 0;   // 最後に通過した読み出しの番号（循環の検出用）
+      bool placed = false; // ブロックの先頭まで命令を読み進めたか
+      bool sealed = false; // 先行ブロックがすべて確定したか
+    };
+
     std::unique_ptr<llvm::LLVMContext> context_;
     std::unique_ptr<llvm::Module> module_;
     std::unique_ptr<llvm::IRBuilder<>> builder_;
-    std::map<std::string, llvm::Value *> registers_;    // レジスタ名 -> LLVM Value
-    std::map<std::string, llvm::BasicBlock *> blocks_;  // ラベル名 -> BasicBlock
-    std::map<std::string, llvm::Function *> functions_; // 関数名 -> LLVM Function
+    const InstructionTable *table_ = nullptr;   // リフト中の命令テーブル
+    std::vector<llvm::Function *> functions_;   // 記号ID -> LLVM Function（末尾はラベルのないmain用）
+    uint32_t mainSymbol_ = SymbolTable::kNone;  // mainの記号ID
+    std::unordered_map<llvm::BasicBlock *, BlockState> blockStates_; // 現在の関数のブロック
+    std::unordered_set<llvm::PHINode *> pendingPhis_; // オペランドを集めている途中のphi
+    std::vector<llvm::WeakTrackingVH> trivialPhiCandidates_; // 自明になったか調べ直すphi
+    uint64_t walkCounter_ = 0;                        // 先行ブロックをたどる読み出しの通し番号
+    std::vector<bool> callTargets_;                   // 記号ID -> CALL先（関数）か
+    std::vector<FunctionRange> functionRanges_;       // 関数ごとの命令範囲（命令順、入口より前の命令はmainの範囲）
+    std::shared_ptr<const std::vector<FunctionCfg>> controlFlow_; // 範囲ごとのCFG（並列リフトのワーカーと共有）
+    const FunctionCfg *currentGraph_ = nullptr;       // リフト中の関数のCFG
+    uint32_t currentBlock_ = 0;                       // リフト中のCFGのブロック番号
+    std::vector<llvm::BasicBlock *> cfgBlocks_;       // CFGのブロック番号 -> BasicBlock（作るまではnull）
+    std::vector<uint32_t> pendingEdges_;              // CFGのブロック番号 -> まだリフトしていない入る辺の数
+    std::vector<CallingConvention> conventions_;      // 記号ID -> レジスタの受け渡し（末尾はラベルのないmain用）
+    std::shared_ptr<const StackLayout> stackLayout_;  // PUSH/POPのフレーム解析（並列リフトのワーカーと共有）
+    std::shared_ptr<const std::vector<InlineBody>> inlineBodies_; // 記号ID -> 展開する本体（並列リフトのワーカーと共有）
+    std::vector<InlinedFunction> inlinedFunctions_;
+    uint32_t currentSymbol_ = SymbolTable::kNone;     // リフト中の関数の記号ID
+    OptimizationLevel optimizationLevel_ = OptimizationLevel::O0;
+    unsigned threadCount_ = 0;
+    VerifyMode verifyMode_ = VerifyMode::Final;
+    bool tailCallEnabled_ = false;
+    bool wideRegisters_ = false;                      // 入力が64ビットレジスタを使う（スロットとスタックをi64にする）
+    bool inliningEnabled_ = true;
+    bool selfTailLoop_ = false;                       // リフト中の関数の自己再帰の末尾呼び出しを入口へのジャンプにする
+    std::ostream *log_;                               // 診断出力先（並列リフトのワーカーはバッファへ）
     std::string errorMessage_;
 
-    // レジスタの値を取得または作成
-    llvm::Value *getOrCreateRegister(const std::string &regName);
+    // レジスタの現在の値を読む/書く（挿入中のブロックでのSSA値）
+    // 64ビットレジスタ（32ビットの入力では32ビットレジスタも）はスロットの値そのもの
+    // 32ビットレジスタはi32で読み、書き込みは上位32ビットを0にする（x86-64と同じ）
+    // 16/8ビットのサブレジスタは切り出してi32に符号拡張し、書き込みは該当ビットだけを置き換える
+    llvm::Value *readRegister(RegisterId reg);
+    llvm::Value *readRegister(PseudoRegister reg);
+    void writeRegister(RegisterId reg, llvm::Value *value);
+    void writeRegister(PseudoRegister reg, llvm::Value *value);
+    static size_t registerSlot(RegisterId reg)
+    {
+      return static_cast<size_t>(registerAlias(reg).full) - static_cast<size_t>(RegisterId::RAX);
+    }
+    static size_t registerSlot(PseudoRegister reg)
+    {
+      return kFullRegisterCount + static_cast<size_t>(reg);
+    }
+    const char *slotName(size_t slot) const;
+
+    // 格納先のスロットの値を読む/書く
+    // %espはモジュール全体で共有するシャドウスタックのスタックポインタ（グローバル）を読み書きする
+    llvm::Value *readRegisterSlot(RegisterId reg);
+    void writeRegisterSlot(RegisterId reg, llvm::Value *value);
+
+    // 格納先の64ビットレジスタの名前（32ビットの入力では%eaxのように32ビットの名前）
+    const char *fullRegisterName(RegisterId full) const;
+
+    // シャドウスタックの1スロットのバイト数（スロットの型の幅）
+    uint32_t stackSlotSize() const { return wideRegisters_ ? 8 : 4; }
+
+    // 昇格したスタックのスロットのSSA変数の番号
+    static size_t stackSlotVariable(uint32_t slot) { return kRegisterSlotCount + slot; }
+
+    // オンザフライのSSA構築（Braunらの方式）
+    // 各ブロックでのレジスタの定義を記録し、定義のないブロックでは先行ブロックをたどって読む
+    // 合流点のphiは読み出し時に作り、オペランドが1種類しかなければ取り除く
+    BlockState &blockState(llvm::BasicBlock *block) { return blockStates_[block]; }
+    static llvm::WeakTrackingVH &definition(BlockState &state, size_t slot);
+    void writeVariable(size_t slot, llvm::BasicBlock *block, llvm::Value *value);
+    llvm::Value *readVariable(size_t slot, llvm::BasicBlock *block);
+    llvm::PHINode *createPhi(size_t slot, llvm::BasicBlock *block);
+    llvm::Value *tryRemoveTrivialPhi(llvm::PHINode *phi);
+
+    // 取り除いたphiの利用者で自明になったものを取り除く
+    // （命令のリフト中は読み出した値を保持しているので、命令の合間に呼ぶ）
+    void removeTrivialPhis();
 
-    // オペランドからLLVM Valueを取得
-    llvm::Value *getOperandValue(const Operand &operand);
+    // ブロックの先行ブロックが確定した: 保留中のphiのオペランドを埋める
+    void sealBlock(llvm::BasicBlock *block);
+
+    // CFGのブロックへの辺を1本リフトした（配置済みで、入る辺がすべてそろえば封鎖）
+    void addEdge(uint32_t block);
+
+    // 命令列を関数ごとの範囲に分ける
+    void collectFunctionRanges();
+
+    // 関数の記号がすべて異なるか（同じ関数を2度開始する入力は逐次リフトする）
+    bool hasUniqueFunctions() const;
+
+    // 関数ごとの表を空にする
+    void resetFunctionState();
+
+    // 定数（関数とグローバルを含む）の利用者の並びを、利用する命令のモジュール内の順に揃える
+    // 定数はコンテキストで共有されるので、並びはリフトの順や塊のリンク順で変わり、最適化パスの結果に影響する
+    void canonicalizeUseLists();
+
+    // 空のモジュールを作る（出力先はwasm32）
+    void createModule();
+
+    // functionRanges_[first, last) の関数をこの順にリフト
+    bool liftFunctions(size_t first, size_t last);
+
+    // 関数の塊をワーカーごとに独立したLLVMContextでリフトし、結果をmodule_へリンク
+    bool liftFunctionsParallel(unsigned threadCount);
+
+    // 関数の開始と終了
+    llvm::Function *beginFunction(uint32_t symbol, const std::string &entryName);
+    void finishFunction();
+
+    // CFGのブロックを命令順にリフト（到達しないブロックは読み飛ばす）
+    bool liftBlocks(const FunctionCfg &graph);
+
+    // 先行ブロックがすでに確定した新しいブロックを作る（関数から戻る条件分岐の行き先）
+    llvm::BasicBlock *createSealedBlock(const char *name);
+
+    // オペランドからLLVM Valueを取得（typeの幅で読む: レジスタは符号拡張か切り捨て、メモリはその幅で読み込む）
+    llvm::Value *getOperandValue(const Operand &operand, llvm::Type *type);
 
     // 命令をLLVM IRに変換
-    bool liftInstruction(const Instruction &instruction, size_t index);
+    bool liftInstruction(InstructionView instruction, size_t index);
 
     // 算術命令をリフト
-    bool liftArithmeticInstruction(const Instruction &instruction);
+    bool liftArithmeticInstruction(InstructionView instruction);
 
     // 移動命令をリフト
-    bool liftMoveInstruction(const Instruction &instruction);
+    bool liftMoveInstruction(InstructionView instruction);
 
     // 比較命令をリフト
-    bool liftCompareInstruction(const Instruction &instruction);
+    bool liftCompareInstruction(InstructionView instruction);
 
     // ジャンプ命令をリフト
-    bool liftJumpInstruction(const Instruction &instruction);
+    bool liftJumpInstruction(InstructionView instruction);
 
-    // 関数呼び出し命令をリフト
-    bool liftCallInstruction(const Instruction &instruction);
+    // CALLの直後にオペランドのないRETが続き、呼び出し先の戻り値がそのまま現在の関数の戻り値になるか
+    bool isTailCall(const CfgBlock &block, size_t index) const;
+
+    // 関数呼び出し命令をリフト（末尾位置の呼び出しはtail/musttailを付けてそのまま戻る）
+    bool liftCallInstruction(InstructionView instruction, size_t index);
+
+    // CALLの位置に呼び出し先の本体の命令をリフト（レジスタはそのまま呼び出し元のSSA値として流れる）
+    bool liftInlinedCall(uint32_t symbol);
 
     // 戻り命令をリフト
-    bool liftReturnInstruction(const Instruction &instruction);
+    bool liftReturnInstruction(InstructionView instruction);
+
+    // スタック操作命令をリフト（昇格した関数ではスロットのSSA値、それ以外はシャドウスタックのメモリ）
+    bool liftStackInstruction(InstructionView instruction, size_t index);
+
+    // シャドウスタックのスタックポインタ（並列リフトのワーカーでは宣言だけを作り、リンク後に定義する）
+    llvm::GlobalVariable *getStackPointer();
+    void defineStackPointer();
+
+    // スタックポインタにdeltaバイトを足す
+    void adjustStackPointer(int64_t delta);
+
+    // CFGのブロック番号からBasicBlockを取得または作成
+    llvm::BasicBlock *getOrCreateBlock(uint32_t block);
 
-    // スタック操作命令をリフト
-    bool liftStackInstruction(const Instruction &instruction);
+    // 関数を取得または作成（引数と戻り値は推論した呼び出し規約のレジスタ）
+    llvm::Function *getOrCreateFunction(uint32_t symbol);
 
-    // ラベルからBasicBlockを取得または作成
-    llvm::BasicBlock *getOrCreateBlock(const std::string &labelName);
+    // 現在の関数から戻る（mainは0を、他の関数は戻り値のレジスタを返す）
+    void createReturn();
 
-    // 関数を取得または作成
-    llvm::Function *getOrCreateFunction(const std::string &funcName);
+    // 記号IDの名前（ラベルのないmainはその名前）
+    std::string symbolName(uint32_t symbol) const;
 
-    // 整数型を取得
+    // 整数型を取得（32ビットの演算とアドレス）
     llvm::Type *getIntType() const;
 
+    // レジスタファイルのスロットの型（i32、64ビットレジスタを使う入力ではi64）
+    llvm::Type *getRegisterType() const;
+
+    // 命令の演算の型（64ビットレジスタのオペランドがあればi64、それ以外はi32）
+    llvm::Type *operationType(InstructionView instruction) const;
+
+    // 値を型の幅に符号拡張または切り捨て
+    llvm::Value *fitToType(llvm::Value *value, llvm::Type *type);
+
     // ポインタ型を取得
-    llvm::Type *getPtrType() const;
+    llvm::Type *getPtrType(llvm::Type *elementType) const;
 
-    // メモリアドレスを計算
+    // メモリアドレスを計算（base + index*scale + displacement の正規形）
     llvm::Value *calculateMemoryAddress(const Operand &operand);
 
-    // フラグレジスタを管理
-    llvm::Value *getFlagRegister(const std::string &flagName);
-    void setFlagRegister(const std::string &flagName, llvm::Value *value);
+    // メモリオペランドの指す値を読む/書く（読み込みはtypeの幅、書き込みは値の幅）
+    llvm::Value *loadMemory(const Operand &operand, llvm::Type *type);
+    void storeMemory(const Operand &operand, llvm::Value *value);
+
+    // CMPのオペランドを記録し、条件ジャンプで必要な比較だけを生成する（フラグは作らない）
+    void recordComparison(llvm::Value *left, llvm::Value *right);
+    llvm::Value *materializeCondition(InstructionType jump);
+
+    // 擬似レジスタの名前
+    static const char *pseudoRegisterName(PseudoRegister reg);
+
+    // 最適化レベルに応じたLLVMの標準パイプラインを適用（--verify=each-passではパスごとに検証し、失敗ならfalse）
+    bool applyOptimizationPasses();
 
-    // 最適化パスを適用
-    void applyOptimizationPasses();
+    // モジュールの定義済みの関数を検証（stageはログと診断に出す検証の時点）
+    bool verifyModule(const std::string &stage);
+    // 検証の失敗をログに出し、エラーメッセージを設定
+    void reportVerifyFailure(const VerifyFailure &failure, const std::string &stage);
   };
 
 } // namespace asmtowasm
@@ -1,63 +1,24 @@
 #pragma once
 
+#include "instruction_table.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
+#include <functional>
+#include <iosfwd>
 #include <memory>
 
 namespace asmtowasm
 {
 
-  // Assembly命令の種類
-  enum class InstructionType
+  // 関数の命令範囲（関数はmainまたはCALL先のラベルから次の関数の手前まで）
+  struct FunctionRange
   {
-    ADD,    // 加算
-    SUB,    // 減算
-    MUL,    // 乗算
-    DIV,    // 除算
-    MOV,    // 移動
-    CMP,    // 比較
-    JMP,    // 無条件ジャンプ
-    JE,     // 等しい場合のジャンプ
-    JNE,    // 等しくない場合のジャンプ
-    JL,     // 小さい場合のジャンプ
-    JG,     // 大きい場合のジャンプ
-    JLE,    // 小さいか等しい場合のジャンプ
-    JGE,    // 大きいか等しい場合のジャンプ
-    CALL,   // 関数呼び出し
-    RET,    // 関数から戻る
-    PUSH,   // スタックにプッシュ
-    POP,    // スタックからポップ
-    LABEL,  // ラベル
-    UNKNOWN // 不明な命令
-  };
-
-  // オペランドの種類
-  enum class OperandType
-  {
-    REGISTER,  // レジスタ
-    IMMEDIATE, // 即値
-    MEMORY,    // メモリアドレス
-    LABEL      // ラベル
-  };
-
-  // オペランド
-  struct Operand
-  {
-    OperandType type;
-    std::string value;
-
-    Operand(OperandType t, const std::string &v) : type(t), value(v) {}
-  };
-
-  // Assembly命令
-  struct Instruction
-  {
-    InstructionType type;
-    std::vector<Operand> operands;
-    std::string label; // ラベルがある場合
-
-    Instruction(InstructionType t) : type(t) {}
+    uint32_t symbol = SymbolTable::kNone; // 関数ラベルの記号ID（最初の関数より前の命令はkNone）
+    size_t begin = 0;                     // 命令範囲 [begin, end)
+    size_t end = 0;
+    bool removed = false;                 // 変更通知で、関数でなくなった
   };
 
   // Assemblyパーサークラス
@@ -67,40 +28,123 @@ namespace asmtowasm
     AssemblyParser();
     ~AssemblyParser() = default;
 
-    // Assemblyファイルをパース
+    // Assemblyファイルをパース（mmapしたバッファを直接トークン化）
     bool parseFile(const std::string &filename);
 
     // Assembly文字列をパース
     bool parseString(const std::string &assemblyCode);
 
+    // メモリ上のAssemblyバッファをパース（コピーせずにトークン化）
+    // 大きな入力は行境界で分割し、複数スレッドで並列にパースする
+    bool parseBuffer(const char *data, size_t size);
+
+    // ストリーミング入力: チャンクを順に与え、最後にfinish()を呼ぶ
+    // 行の途中で切れたチャンクは次のfeed()まで内部にバッファする
+    bool feed(std::string_view chunk);
+    bool finish();
+
+    // 増分パース: 文書全体をパースし、行ごとの結果を保持する
+    bool loadDocument(std::string_view text);
+
+    // 編集を適用: startLine行目（0始まり）からremovedCount行をnewTextの行で置き換える
+    // 影響する行だけを再パースし、instructions_とlabels_をその場で更新する
+    // changedFunctionsには命令範囲か内容が変わった関数（新しい範囲）が入る
+    bool applyEdit(size_t startLine, size_t removedCount, std::string_view newText,
+                   std::vector<FunctionRange> *changedFunctions = nullptr);
+
+    // 増分パース中の文書の行数
+    size_t getLineCount() const { return lineRecords_.size(); }
+
+    // 関数ごとの命令範囲（命令順）
+    std::vector<FunctionRange> getFunctionRanges() const;
+
+    // 完成した命令を受け取るコールバック
+    // 設定すると命令はコールバックへ渡され、instructions_には保持されない
+    // （ラベルの命令インデックスはストリーム先頭からの通し番号、ビューは呼び出し中のみ有効）
+    using InstructionCallback = std::function<void(InstructionView)>;
+    void setInstructionCallback(InstructionCallback callback) { callback_ = std::move(callback); }
+
+    // パース結果のキャッシュディレクトリ（空なら無効）
+    // 設定するとparseFileは内容が同じソースのテキストパースを省略する
+    void setCacheDirectory(const std::string &directory) { cacheDirectory_ = directory; }
+
+    // 並列パースに使うスレッド数（0はハードウェアの並列度、1は逐次パース）
+    void setThreadCount(unsigned threadCount) { threadCount_ = threadCount; }
+
+    // 並列パースに切り替える入力サイズの下限（バイト）
+    static constexpr size_t kParallelParseThreshold = 1 << 20;
+
     // パースされた命令のリストを取得
-    const std::vector<Instruction> &getInstructions() const { return instructions_; }
+    const InstructionTable &getInstructions() const { return instructions_; }
 
-    // ラベルのマップを取得
-    const std::map<std::string, size_t> &getLabels() const { return labels_; }
+    // ラベル表を取得（記号IDはgetInstructions().symbols()のもの）
+    const LabelTable &getLabels() const { return labels_; }
 
     // エラーメッセージを取得
     const std::string &getErrorMessage() const { return errorMessage_; }
 
   private:
-    std::vector<Instruction> instructions_;
-    std::map<std::string, size_t> labels_; // ラベル名 -> 命令インデックス
+    InstructionTable instructions_;
+    LabelTable labels_;                    // 記号ID -> 命令インデックス
     std::string errorMessage_;
+    std::vector<std::string_view> tokens_; // 行ごとのトークン（容量を再利用）
+    std::vector<Operand> operandScratch_;  // 行ごとのオペランド（容量を再利用）
+    unsigned threadCount_ = 0;
+    std::string cacheDirectory_;
+    InstructionCallback callback_;
+    std::string pendingLine_;  // feed()で未完の行
+    size_t streamLineNumber_ = 0;
+    size_t emittedCount_ = 0;  // コールバックへ渡し済みの命令数
+    std::ostream *log_;                     // 診断出力先（チャンク用パーサーはバッファへ）
+
+    // 増分パース用の行ごとの結果
+    struct LineRecord
+    {
+      bool hasInstruction = false;          // 命令（LABEL命令を含む）を生成したか
+      uint32_t labelId = SymbolTable::kNone; // 定義したラベル
+    };
+    std::vector<LineRecord> lineRecords_;
+    std::vector<uint32_t> callCounts_; // 記号ID -> CALLで参照される回数
+    bool incremental_ = false;
+
+    // [first, first+count) の命令のCALL先の参照回数を増減
+    void countCalls(size_t first, size_t count, int delta);
+
+    // 次に追加される命令のストリーム先頭からのインデックス
+    size_t nextInstructionIndex() const { return emittedCount_ + instructions_.size(); }
+
+    // 別途パースした命令テーブルとラベルを末尾に追加（ラベルのインデックスは再配置）
+    void appendParsed(InstructionTable &&table, const LabelTable &labels);
+
+    // 完成した命令をコールバックへ渡す
+    void flushToCallback();
+
+    // バッファを行ごとにパース（lineNumberは処理した行数、失敗時はその行番号）
+    bool parseLines(const char *data, size_t size, size_t &lineNumber);
+
+    // バッファをチャンクに分割して並列にパースし、結果を結合
+    bool parseBufferParallel(const char *data, size_t size, unsigned threadCount);
 
     // 命令タイプを文字列から解析
-    InstructionType parseInstructionType(const std::string &instruction);
+    InstructionType parseInstructionType(std::string_view instruction);
 
     // オペランドを解析
-    Operand parseOperand(const std::string &operand);
+    bool parseOperand(std::string_view text, Operand &operand);
 
-    // 行を解析
-    bool parseLine(const std::string &line);
+    // メモリオペランドの括弧内を解析
+    bool parseMemoryOperand(std::string_view text, MemoryOperand &memory);
 
-    // 文字列のトリム
-    std::string trim(const std::string &str);
+    // tokens_[firstToken]以降をオペランドとしてoperandScratch_に解析
+    bool parseOperands(size_t firstToken);
 
-    // コメントを除去
-    std::string removeComments(const std::string &line);
+    // 1行を解析（行スキャナでトークン化してからparseTokens）
+    bool parseLine(std::string_view line);
+
+    // tokens_に分割済みの1行を解析
+    bool parseTokens();
+
+    // 文字列のトリム
+    std::string_view trim(std::string_view str);
   };
 
 } // namespace asmtowasm
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "assembly_parser.h"
+#include "control_flow.h"
+#include "instruction_table.h"
+#include <cstdint>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // 汎用レジスタの集合（ビットiはRAX+i番目のレジスタ、サブレジスタは格納先のビット）
+  using RegisterMask = uint32_t;
+  static_assert(kFullRegisterCount <= 32, "レジスタの集合がRegisterMaskに収まりません");
+
+  // レジスタの集合のビット（サブレジスタは格納先の64ビットレジスタ）
+  constexpr RegisterMask registerBit(RegisterId reg)
+  {
+    const RegisterId full = registerAlias(reg).full;
+    if (full == RegisterId::NONE)
+    {
+      return 0;
+    }
+    return RegisterMask(1) << (static_cast<size_t>(full) - static_cast<size_t>(RegisterId::RAX));
+  }
+
+  // 集合のレジスタをRAXから順に列挙（格納先の64ビットレジスタとして渡す）
+  template <typename Visitor>
+  void forEachRegister(RegisterMask mask, Visitor visit)
+  {
+    for (size_t i = 0; i < kFullRegisterCount; ++i)
+    {
+      if (mask & (RegisterMask(1) << i))
+      {
+        visit(static_cast<RegisterId>(static_cast<size_t>(RegisterId::RAX) + i));
+      }
+    }
+  }
+
+  // 関数のレジスタによる受け渡し
+  struct CallingConvention
+  {
+    RegisterMask params = 0;   // 入口の値を読むレジスタ（引数）
+    RegisterMask results = 0;  // 戻るときに呼び出し元へ返すレジスタ（戻り値）
+    RegisterMask clobbers = 0; // 関数と呼び出し先が書き換えうるレジスタ
+  };
+
+  // 関数ごとの呼び出し規約の推論
+  // 関数内の生存区間解析と、関数間の不動点反復で求める:
+  //   引数     = 入口で生きているレジスタ（呼び出し先の引数と、返すレジスタの読み出しを含む）
+  //   戻り値   = 書き換えうるレジスタのうち、いずれかの呼び出し元で呼び出し後に生きているもの
+  // CALLは呼び出し先の引数を読み、書き換えうるレジスタを定義する（返さないものは呼び出し後に死んでいる）
+  // mainは外部から呼ばれる入口なので引数も戻り値も持たない（入口で未定義のレジスタは0）
+  class CallingConventionAnalysis
+  {
+  public:
+    explicit CallingConventionAnalysis(const InstructionTable &table) : table_(table) {}
+
+    // 関数ごとの命令範囲とそのCFGから推論し、記号ID -> 規約の表を返す（末尾はラベルのないmain用）
+    // 到達しないブロックの命令は規約に影響しない
+    std::vector<CallingConvention> run(const std::vector<FunctionRange> &ranges,
+                                       const std::vector<FunctionCfg> &graphs, uint32_t mainSymbol);
+
+  private:
+    // 命令ごとのレジスタの読み書き（CALLとRETは規約に依存するので別扱い）
+    struct RegisterEffect
+    {
+      RegisterMask uses = 0;
+      RegisterMask defs = 0;
+    };
+
+    const InstructionTable &table_;
+    uint32_t mainSymbol_ = SymbolTable::kNone;
+    std::vector<CallingConvention> conventions_;
+    std::vector<RegisterMask> demanded_; // 記号ID -> 呼び出し後に生きているレジスタ
+    std::vector<RegisterMask> live_;     // 解析中の範囲の命令ごとの入口での生存レジスタ
+    std::vector<RegisterMask> liveOut_;  // 解析中の範囲のブロックごとの出口での生存レジスタ
+
+    // 命令の読み書きするレジスタ
+    static RegisterEffect effectOf(InstructionView inst);
+
+    // オペランドが読むレジスタ（メモリオペランドはアドレス計算のレジスタ）
+    static RegisterMask operandUses(const Operand &operand);
+
+    // CALL先の記号ID（ラベルでなければkNone）
+    static uint32_t callTarget(InstructionView inst);
+
+    // 範囲の生存区間を解析し、関数の引数と呼び出し先の要求を更新
+    // 入口で生きているレジスタを返す
+    RegisterMask analyzeRange(const FunctionRange &range, const FunctionCfg &graph, uint32_t symbol,
+                              std::vector<uint32_t> &changedCallees);
+  };
+
+} // namespace asmtowasm
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "assembly_parser.h"
+#include "instruction_table.h"
+#include <cstdint>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // 関数内の基本ブロック（命令の連続した範囲で、途中から入ることも途中で抜けることもない）
+  struct CfgBlock
+  {
+    static constexpr uint32_t kNone = UINT32_MAX;     // 辺がない
+    static constexpr uint32_t kExit = UINT32_MAX - 1; // 関数から戻る辺
+
+    size_t begin = 0; // 命令範囲 [begin, end)
+    size_t end = 0;
+    uint32_t taken = kNone;       // ジャンプ先のブロック（末尾がジャンプの場合）
+    uint32_t fallthrough = kNone; // 次の命令へ落ちる先のブロック（範囲の終わりならkExit）
+    uint32_t predecessors = 0;    // 到達するブロックからの辺の数（同じブロックからの2本は2と数える）
+    bool reachable = false;       // 入口から到達する
+
+    // 後続ブロックを taken、fallthrough の順に列挙（kExitも渡す）
+    template <typename Visitor>
+    void forEachSuccessor(Visitor visit) const
+    {
+      if (taken != kNone)
+      {
+        visit(taken);
+      }
+      if (fallthrough != kNone)
+      {
+        visit(fallthrough);
+      }
+    }
+  };
+
+  // 関数の命令範囲ごとの制御フローグラフ
+  struct FunctionCfg
+  {
+    std::vector<CfgBlock> blocks;                 // 命令順（先頭が入口）
+    uint32_t duplicateLabel = SymbolTable::kNone; // 範囲内で2度定義されたラベル
+  };
+
+  // リフトの前に命令列から基本ブロックを切り出す
+  // リーダーは範囲の先頭、範囲内からジャンプされるラベル、ジャンプ/RETの次の命令
+  // 関数外のラベルと、関数自身のラベルへのジャンプは関数から戻る辺（kExit）になる
+  // 入口から到達しないブロックはreachable=falseのまま残し、解析とリフトでは読み飛ばす
+  class ControlFlowAnalysis
+  {
+  public:
+    ControlFlowAnalysis(const InstructionTable &table, const LabelTable &labels)
+        : table_(table), labels_(labels) {}
+
+    // 関数の命令範囲ごとのCFG（rangesと同じ順）
+    std::vector<FunctionCfg> run(const std::vector<FunctionRange> &ranges);
+
+  private:
+    const InstructionTable &table_;
+    const LabelTable &labels_;
+    std::vector<uint32_t> blockOf_; // 解析中の範囲の命令 -> 始まるブロック（リーダーでなければkNone）
+
+    FunctionCfg build(const FunctionRange &range);
+
+    // ジャンプ先の命令番号（範囲外や関数自身のラベルなら範囲の終わり）
+    size_t jumpTarget(const FunctionRange &range, InstructionView inst) const;
+  };
+
+  // ブロックを終える命令か（ジャンプとRET）
+  inline bool endsBlock(InstructionType type)
+  {
+    return (type >= InstructionType::JMP && type <= InstructionType::JGE) || type == InstructionType::RET;
+  }
+
+} // namespace asmtowasm
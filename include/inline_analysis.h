@@ -0,0 +1,48 @@
+#pragma once
+
+#include "assembly_parser.h"
+#include "control_flow.h"
+#include "instruction_table.h"
+#include <cstdint>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // 呼び出し元へ展開できる関数の本体
+  struct InlineBody
+  {
+    size_t begin = 0; // 展開する命令範囲 [begin, end)（末尾のRETは含まない）
+    size_t end = 0;
+    uint32_t size = 0;      // 本体の命令数（ラベルだけの行は数えない）
+    uint32_t callSites = 0; // 到達するブロックにあるCALLの数
+    bool inlined = false;   // CALLを本体の命令で置き換える
+  };
+
+  // 葉関数のインライン展開の判定
+  // 命令列と関数の範囲だけで決めるので、最適化パイプライン（-O0）によらずリフト時に展開できる
+  // 展開するのは次をすべて満たす関数:
+  //   範囲が1つで、到達するブロックが1つ（ジャンプを含まない）、オペランドのないRETか範囲の終わりで戻る、
+  //   CALLとPUSH/POPを含まない（呼び出し元のフレームと呼び出し先を変えない）、mainではない
+  // そのうち本体が kAlwaysInlineSize 命令以下か、命令数 × 呼び出し回数が kGrowthBudget 以下のもの
+  // 返されないレジスタへの書き込みは呼び出し後に読まれないので、展開しても呼び出し元の値は変わらない
+  class InlineAnalysis
+  {
+  public:
+    static constexpr uint32_t kAlwaysInlineSize = 4; // 呼び出し回数によらず展開する本体の命令数
+    static constexpr uint32_t kGrowthBudget = 32;    // 展開で増やしてよい命令数（1関数あたり）
+
+    explicit InlineAnalysis(const InstructionTable &table) : table_(table) {}
+
+    // 記号ID -> 本体の表を返す（末尾はラベルのないmain用）
+    std::vector<InlineBody> run(const std::vector<FunctionRange> &ranges, const std::vector<FunctionCfg> &graphs,
+                                uint32_t mainSymbol);
+
+  private:
+    const InstructionTable &table_;
+
+    // 範囲が展開できる葉関数なら本体の範囲と命令数を設定してtrue
+    bool extractBody(const FunctionRange &range, const FunctionCfg &graph, InlineBody &body) const;
+  };
+
+} // namespace asmtowasm
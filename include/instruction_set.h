@@ -0,0 +1,422 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace asmtowasm
+{
+
+  // Assembly命令の種類
+  enum class InstructionType
+  {
+    ADD,    // 加算
+    SUB,    // 減算
+    MUL,    // 乗算
+    DIV,    // 除算
+    MOV,    // 移動
+    CMP,    // 比較
+    JMP,    // 無条件ジャンプ
+    JE,     // 等しい場合のジャンプ
+    JNE,    // 等しくない場合のジャンプ
+    JL,     // 小さい場合のジャンプ
+    JG,     // 大きい場合のジャンプ
+    JLE,    // 小さいか等しい場合のジャンプ
+    JGE,    // 大きいか等しい場合のジャンプ
+    CALL,   // 関数呼び出し
+    RET,    // 関数から戻る
+    PUSH,   // スタックにプッシュ
+    POP,    // スタックからポップ
+    LABEL,  // ラベル
+    UNKNOWN // 不明な命令
+  };
+
+  // アーキテクチャレジスタ（64/32/16/下位8ビットは同じ並びの16個ずつ、最後に上位8ビットの4個）
+  enum class RegisterId : uint8_t
+  {
+    NONE,
+    // 64ビット
+    RAX,
+    RBX,
+    RCX,
+    RDX,
+    RSI,
+    RDI,
+    RBP,
+    RSP,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+    // 32ビット
+    EAX,
+    EBX,
+    ECX,
+    EDX,
+    ESI,
+    EDI,
+    EBP,
+    ESP,
+    R8D,
+    R9D,
+    R10D,
+    R11D,
+    R12D,
+    R13D,
+    R14D,
+    R15D,
+    // 16ビット
+    AX,
+    BX,
+    CX,
+    DX,
+    SI,
+    DI,
+    BP,
+    SP,
+    R8W,
+    R9W,
+    R10W,
+    R11W,
+    R12W,
+    R13W,
+    R14W,
+    R15W,
+    // 下位8ビット
+    AL,
+    BL,
+    CL,
+    DL,
+    SIL,
+    DIL,
+    BPL,
+    SPL,
+    R8B,
+    R9B,
+    R10B,
+    R11B,
+    R12B,
+    R13B,
+    R14B,
+    R15B,
+    // 上位8ビット
+    AH,
+    BH,
+    CH,
+    DH,
+    COUNT
+  };
+
+  // 名前を最大8文字まで1語に詰めたキー（英字は小文字に正規化）
+  // switchのcase定数として使えるため、比較の連鎖ではなく定数時間の分岐で解決できる
+  constexpr uint64_t packName(std::string_view name)
+  {
+    if (name.empty() || name.size() > 8)
+    {
+      return 0;
+    }
+    uint64_t key = 0;
+    for (char c : name)
+    {
+      if (c >= 'A' && c <= 'Z')
+      {
+        c = static_cast<char>(c - 'A' + 'a');
+      }
+      key = (key << 8) | static_cast<unsigned char>(c);
+    }
+    return key;
+  }
+
+  // ニーモニックを命令タイプに変換（大文字小文字を区別しない）
+  constexpr InstructionType decodeMnemonic(std::string_view mnemonic)
+  {
+    switch (packName(mnemonic))
+    {
+    case packName("add"):
+    case packName("addl"):
+    case packName("addq"):
+      return InstructionType::ADD;
+    case packName("sub"):
+    case packName("subl"):
+    case packName("subq"):
+      return InstructionType::SUB;
+    case packName("mul"):
+    case packName("mull"):
+    case packName("mulq"):
+      return InstructionType::MUL;
+    case packName("div"):
+    case packName("divl"):
+    case packName("divq"):
+      return InstructionType::DIV;
+    case packName("mov"):
+    case packName("movl"):
+    case packName("movq"):
+      return InstructionType::MOV;
+    case packName("cmp"):
+    case packName("cmpl"):
+    case packName("cmpq"):
+      return InstructionType::CMP;
+    case packName("jmp"):
+      return InstructionType::JMP;
+    case packName("je"):
+    case packName("jz"):
+      return InstructionType::JE;
+    case packName("jne"):
+    case packName("jnz"):
+      return InstructionType::JNE;
+    case packName("jl"):
+    case packName("jnge"):
+      return InstructionType::JL;
+    case packName("jg"):
+    case packName("jnle"):
+      return InstructionType::JG;
+    case packName("jle"):
+    case packName("jng"):
+      return InstructionType::JLE;
+    case packName("jge"):
+    case packName("jnl"):
+      return InstructionType::JGE;
+    case packName("call"):
+    case packName("calll"):
+    case packName("callq"):
+      return InstructionType::CALL;
+    case packName("ret"):
+    case packName("retl"):
+    case packName("retq"):
+      return InstructionType::RET;
+    case packName("push"):
+    case packName("pushl"):
+    case packName("pushq"):
+      return InstructionType::PUSH;
+    case packName("pop"):
+    case packName("popl"):
+    case packName("popq"):
+      return InstructionType::POP;
+    default:
+      return InstructionType::UNKNOWN;
+    }
+  }
+
+  // レジスタ名を識別子に変換（先頭の%は省略可、大文字小文字を区別しない）
+  constexpr RegisterId decodeRegister(std::string_view name)
+  {
+    if (!name.empty() && name[0] == '%')
+    {
+      name.remove_prefix(1);
+    }
+
+    switch (packName(name))
+    {
+    case packName("rax"):
+      return RegisterId::RAX;
+    case packName("rbx"):
+      return RegisterId::RBX;
+    case packName("rcx"):
+      return RegisterId::RCX;
+    case packName("rdx"):
+      return RegisterId::RDX;
+    case packName("rsi"):
+      return RegisterId::RSI;
+    case packName("rdi"):
+      return RegisterId::RDI;
+    case packName("rbp"):
+      return RegisterId::RBP;
+    case packName("rsp"):
+      return RegisterId::RSP;
+    case packName("r8"):
+      return RegisterId::R8;
+    case packName("r9"):
+      return RegisterId::R9;
+    case packName("r10"):
+      return RegisterId::R10;
+    case packName("r11"):
+      return RegisterId::R11;
+    case packName("r12"):
+      return RegisterId::R12;
+    case packName("r13"):
+      return RegisterId::R13;
+    case packName("r14"):
+      return RegisterId::R14;
+    case packName("r15"):
+      return RegisterId::R15;
+    case packName("eax"):
+      return RegisterId::EAX;
+    case packName("ebx"):
+      return RegisterId::EBX;
+    case packName("ecx"):
+      return RegisterId::ECX;
+    case packName("edx"):
+      return RegisterId::EDX;
+    case packName("esi"):
+      return RegisterId::ESI;
+    case packName("edi"):
+      return RegisterId::EDI;
+    case packName("ebp"):
+      return RegisterId::EBP;
+    case packName("esp"):
+      return RegisterId::ESP;
+    case packName("r8d"):
+      return RegisterId::R8D;
+    case packName("r9d"):
+      return RegisterId::R9D;
+    case packName("r10d"):
+      return RegisterId::R10D;
+    case packName("r11d"):
+      return RegisterId::R11D;
+    case packName("r12d"):
+      return RegisterId::R12D;
+    case packName("r13d"):
+      return RegisterId::R13D;
+    case packName("r14d"):
+      return RegisterId::R14D;
+    case packName("r15d"):
+      return RegisterId::R15D;
+    case packName("ax"):
+      return RegisterId::AX;
+    case packName("bx"):
+      return RegisterId::BX;
+    case packName("cx"):
+      return RegisterId::CX;
+    case packName("dx"):
+      return RegisterId::DX;
+    case packName("si"):
+      return RegisterId::SI;
+    case packName("di"):
+      return RegisterId::DI;
+    case packName("bp"):
+      return RegisterId::BP;
+    case packName("sp"):
+      return RegisterId::SP;
+    case packName("r8w"):
+      return RegisterId::R8W;
+    case packName("r9w"):
+      return RegisterId::R9W;
+    case packName("r10w"):
+      return RegisterId::R10W;
+    case packName("r11w"):
+      return RegisterId::R11W;
+    case packName("r12w"):
+      return RegisterId::R12W;
+    case packName("r13w"):
+      return RegisterId::R13W;
+    case packName("r14w"):
+      return RegisterId::R14W;
+    case packName("r15w"):
+      return RegisterId::R15W;
+    case packName("al"):
+      return RegisterId::AL;
+    case packName("bl"):
+      return RegisterId::BL;
+    case packName("cl"):
+      return RegisterId::CL;
+    case packName("dl"):
+      return RegisterId::DL;
+    case packName("sil"):
+      return RegisterId::SIL;
+    case packName("dil"):
+      return RegisterId::DIL;
+    case packName("bpl"):
+      return RegisterId::BPL;
+    case packName("spl"):
+      return RegisterId::SPL;
+    case packName("r8b"):
+      return RegisterId::R8B;
+    case packName("r9b"):
+      return RegisterId::R9B;
+    case packName("r10b"):
+      return RegisterId::R10B;
+    case packName("r11b"):
+      return RegisterId::R11B;
+    case packName("r12b"):
+      return RegisterId::R12B;
+    case packName("r13b"):
+      return RegisterId::R13B;
+    case packName("r14b"):
+      return RegisterId::R14B;
+    case packName("r15b"):
+      return RegisterId::R15B;
+    case packName("ah"):
+      return RegisterId::AH;
+    case packName("bh"):
+      return RegisterId::BH;
+    case packName("ch"):
+      return RegisterId::CH;
+    case packName("dh"):
+      return RegisterId::DH;
+    default:
+      return RegisterId::NONE;
+    }
+  }
+
+  // 汎用レジスタの数（RegisterIdではRAX〜R15の順に並び、32/16/下位8ビットのレジスタも同じ並び）
+  constexpr size_t kFullRegisterCount = 16;
+
+  // サブレジスタが占める位置: 格納先の64ビットレジスタと、その中のビット位置と幅
+  struct RegisterAlias
+  {
+    RegisterId full;
+    uint8_t shift;
+    uint8_t bits;
+  };
+
+  // %eax/%ax/%al/%ahは%raxの下位32ビット/下位16ビット/下位8ビット/8〜15ビット目（他のレジスタも同様）
+  constexpr RegisterAlias registerAlias(RegisterId reg)
+  {
+    if (reg == RegisterId::NONE || reg >= RegisterId::COUNT)
+    {
+      return {RegisterId::NONE, 0, 0};
+    }
+    const auto index = static_cast<uint8_t>(reg) - static_cast<uint8_t>(RegisterId::RAX);
+    const auto full = static_cast<RegisterId>(static_cast<uint8_t>(RegisterId::RAX) + index % kFullRegisterCount);
+    switch (index / kFullRegisterCount)
+    {
+    case 0:
+      return {reg, 0, 64};
+    case 1:
+      return {full, 0, 32};
+    case 2:
+      return {full, 0, 16};
+    case 3:
+      return {full, 0, 8};
+    default:
+      return {full, 8, 8};
+    }
+  }
+  static_assert(static_cast<size_t>(RegisterId::R15) - static_cast<size_t>(RegisterId::RAX) + 1 == kFullRegisterCount,
+                "64ビットレジスタの数がRegisterIdと一致していません");
+  static_assert(registerAlias(RegisterId::R15D).full == RegisterId::R15 &&
+                    registerAlias(RegisterId::SP).full == RegisterId::RSP &&
+                    registerAlias(RegisterId::R8B).full == RegisterId::R8 &&
+                    registerAlias(RegisterId::DH).full == RegisterId::RDX && registerAlias(RegisterId::DH).shift == 8,
+                "サブレジスタの並びがRegisterIdと一致していません");
+
+  // 64ビットレジスタの下位32ビットのレジスタ（%rax -> %eax、%r8 -> %r8d）
+  constexpr RegisterId lowerHalf(RegisterId full)
+  {
+    return static_cast<RegisterId>(static_cast<uint8_t>(full) + kFullRegisterCount);
+  }
+
+  // レジスタの正規名（%付き小文字）
+  constexpr const char *registerName(RegisterId reg)
+  {
+    constexpr const char *names[] = {
+        "",
+        "%rax", "%rbx", "%rcx", "%rdx", "%rsi", "%rdi", "%rbp", "%rsp",
+        "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15",
+        "%eax", "%ebx", "%ecx", "%edx", "%esi", "%edi", "%ebp", "%esp",
+        "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d",
+        "%ax", "%bx", "%cx", "%dx", "%si", "%di", "%bp", "%sp",
+        "%r8w", "%r9w", "%r10w", "%r11w", "%r12w", "%r13w", "%r14w", "%r15w",
+        "%al", "%bl", "%cl", "%dl", "%sil", "%dil", "%bpl", "%spl",
+        "%r8b", "%r9b", "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b",
+        "%ah", "%bh", "%ch", "%dh"};
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(RegisterId::COUNT),
+                  "レジスタ名の表がRegisterIdと一致していません");
+    return reg < RegisterId::COUNT ? names[static_cast<size_t>(reg)] : "";
+  }
+
+} // namespace asmtowasm
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "instruction_set.h"
+#include "symbol_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // オペランドの種類
+  enum class OperandType : uint8_t
+  {
+    REGISTER,  // レジスタ
+    IMMEDIATE, // 即値
+    MEMORY,    // メモリアドレス
+    LABEL      // ラベル
+  };
+
+  // メモリオペランド: base + index*scale + displacement
+  struct MemoryOperand
+  {
+    RegisterId base = RegisterId::NONE;
+    RegisterId index = RegisterId::NONE;
+    uint8_t scale = 1;
+    int64_t displacement = 0;
+  };
+
+  // オペランド（パース時にデコード済み、文字列を持たない）
+  struct Operand
+  {
+    OperandType type = OperandType::LABEL;
+    RegisterId reg = RegisterId::NONE;  // REGISTER
+    int64_t immediate = 0;              // IMMEDIATE
+    MemoryOperand memory;               // MEMORY
+    uint32_t symbol = SymbolTable::kNone; // LABEL: 記号ID
+  };
+
+  class InstructionTable;
+
+  // 命令が持つオペランドの範囲
+  class OperandSpan
+  {
+  public:
+    OperandSpan(const Operand *data, size_t size) : data_(data), size_(size) {}
+
+    const Operand &operator[](size_t i) const { return data_[i]; }
+    const Operand *begin() const { return data_; }
+    const Operand *end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+  private:
+    const Operand *data_;
+    size_t size_;
+  };
+
+  // 命令テーブル内の1命令を指す軽量ビュー
+  class InstructionView
+  {
+  public:
+    InstructionView(const InstructionTable *table, size_t index) : table_(table), index_(index) {}
+
+    InstructionType type() const;
+    OperandSpan operands() const;
+    bool hasLabel() const { return labelId() != SymbolTable::kNone; }
+    uint32_t labelId() const;
+    std::string_view label() const;
+    size_t index() const { return index_; }
+
+  private:
+    const InstructionTable *table_;
+    size_t index_;
+  };
+
+  // 列指向の命令テーブル
+  // 命令種別・オペランド範囲・ラベルIDを列ごとの配列に、オペランドを1本の配列にまとめて持つ
+  class InstructionTable
+  {
+  public:
+    InstructionTable() { operandBegin_.push_back(0); }
+
+    // 命令を追加
+    void append(InstructionType type, uint32_t labelId, const Operand *operands, size_t operandCount);
+
+    // 別テーブルの命令を末尾に追加（記号IDはこのテーブルのものに付け替える）
+    // 戻り値は相手の記号ID -> このテーブルの記号ID
+    std::vector<uint32_t> appendTable(const InstructionTable &other);
+
+    // [first, first+count) の命令を別テーブルの命令で置き換える（記号IDは付け替える）
+    // 戻り値は相手の記号ID -> このテーブルの記号ID
+    std::vector<uint32_t> replaceRange(size_t first, size_t count, const InstructionTable &other);
+
+    // [first, first+other.size()) の命令が別テーブルの命令と同じか（記号は名前で比較）
+    bool rangeEquals(size_t first, const InstructionTable &other) const;
+
+    // 命令だけを消去（記号表は保持）
+    void clearInstructions();
+
+    // 記号表ごと消去
+    void clear();
+
+    size_t size() const { return types_.size(); }
+    bool empty() const { return types_.empty(); }
+    InstructionView operator[](size_t i) const { return InstructionView(this, i); }
+
+    // 記号表
+    SymbolTable &symbols() { return symbols_; }
+    const SymbolTable &symbols() const { return symbols_; }
+    std::string_view symbolName(uint32_t id) const { return symbols_.name(id); }
+
+    // 診断用にオペランドを文字列化
+    std::string formatOperand(const Operand &operand) const;
+
+    // 範囲for用のイテレータ
+    class iterator
+    {
+    public:
+      iterator(const InstructionTable *table, size_t index) : table_(table), index_(index) {}
+      InstructionView operator*() const { return InstructionView(table_, index_); }
+      iterator &operator++()
+      {
+        ++index_;
+        return *this;
+      }
+      bool operator!=(const iterator &other) const { return index_ != other.index_; }
+
+    private:
+      const InstructionTable *table_;
+      size_t index_;
+    };
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+  private:
+    friend class InstructionView;
+    friend class ParseCache;
+
+    std::vector<InstructionType> types_;
+    std::vector<uint32_t> operandBegin_; // 命令iのオペランドは[operandBegin_[i], operandBegin_[i+1])
+    std::vector<uint32_t> labelIds_;
+    std::vector<Operand> operands_;      // 全命令のオペランド
+    SymbolTable symbols_;
+  };
+
+  // ラベル表: 記号ID -> 命令インデックス（命令テーブルの記号表と同じIDで引く）
+  class LabelTable
+  {
+  public:
+    static constexpr size_t kUndefined = SIZE_MAX;
+
+    // ラベルを定義（同名の再定義は後勝ち）
+    void define(uint32_t symbol, size_t index)
+    {
+      if (symbol >= targets_.size())
+      {
+        targets_.resize(static_cast<size_t>(symbol) + 1, kUndefined);
+      }
+      if (targets_[symbol] == kUndefined)
+      {
+        ++count_;
+      }
+      targets_[symbol] = index;
+    }
+
+    // ラベルの定義を取り消す
+    void undefine(uint32_t symbol)
+    {
+      if (contains(symbol))
+      {
+        targets_[symbol] = kUndefined;
+        --count_;
+      }
+    }
+
+    // from以降の命令を指すラベルをdeltaだけずらす
+    void shiftFrom(size_t from, ptrdiff_t delta)
+    {
+      for (size_t &target : targets_)
+      {
+        if (target != kUndefined && target >= from)
+        {
+          target = static_cast<size_t>(static_cast<ptrdiff_t>(target) + delta);
+        }
+      }
+    }
+
+    // ラベルの命令インデックス（未定義ならkUndefined）
+    size_t find(uint32_t symbol) const { return symbol < targets_.size() ? targets_[symbol] : kUndefined; }
+    bool contains(uint32_t symbol) const { return find(symbol) != kUndefined; }
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    void clear()
+    {
+      targets_.clear();
+      count_ = 0;
+    }
+
+    // 定義済みのラベルを記号ID順に列挙
+    template <typename Visitor>
+    void forEach(Visitor visit) const
+    {
+      for (uint32_t id = 0; id < targets_.size(); ++id)
+      {
+        if (targets_[id] != kUndefined)
+        {
+          visit(id, targets_[id]);
+        }
+      }
+    }
+
+  private:
+    std::vector<size_t> targets_;
+    size_t count_ = 0;
+  };
+
+  inline InstructionType InstructionView::type() const
+  {
+    return table_->types_[index_];
+  }
+
+  inline OperandSpan InstructionView::operands() const
+  {
+    const uint32_t begin = table_->operandBegin_[index_];
+    return OperandSpan(table_->operands_.data() + begin, table_->operandBegin_[index_ + 1] - begin);
+  }
+
+  inline uint32_t InstructionView::labelId() const
+  {
+    return table_->labelIds_[index_];
+  }
+
+  inline std::string_view InstructionView::label() const
+  {
+    return hasLabel() ? table_->symbolName(labelId()) : std::string_view();
+  }
+
+} // namespace asmtowasm
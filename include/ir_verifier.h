@@ -0,0 +1,56 @@
+#pragma once
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <cstddef>
+#include <string>
+
+namespace asmtowasm
+{
+
+  // LLVM IRを検証するタイミング（--verify）
+  enum class VerifyMode
+  {
+    None,    // 検証しない
+    Final,   // Wasm生成へ渡すIRを一度だけ検証（既定）
+    EachPass // リフトの直後、最適化パスごと、強度低減の後に検証
+  };
+
+  // 検証に失敗した関数
+  struct VerifyFailure
+  {
+    std::string function; // 関数名
+    std::string message;  // verifyFunctionの診断（kDumpLimitバイトまで）
+    std::string dump;     // 関数のIR（kDumpLimitバイトまで）
+  };
+
+  // 関数ごとのIR検証
+  // verifyFunctionは関数を読むだけなので、定義済みの関数を分けて並列に検証できる
+  // 失敗したときはモジュール全体ではなく、関数順で最初に失敗した関数のIRだけを診断に含める
+  class IrVerifier
+  {
+  public:
+    static constexpr size_t kDumpLimit = 16 * 1024;       // 診断に含めるIRとメッセージの上限（バイト）
+    static constexpr size_t kParallelThreshold = 1 << 14; // 並列に検証するIRの命令数の下限
+
+    // threadCount: 0はハードウェアの並列度、1は逐次
+    explicit IrVerifier(unsigned threadCount) : threadCount_(threadCount) {}
+
+    // 定義済みの全関数を検証し、すべて妥当ならtrue
+    bool run(const llvm::Module &module);
+
+    // 1つの関数を検証し、妥当ならtrue（関数単位の最適化パスの後）
+    bool run(const llvm::Function &func);
+
+    // 最後のrunで失敗した関数
+    const VerifyFailure &failure() const { return failure_; }
+
+  private:
+    unsigned threadCount_;
+    VerifyFailure failure_;
+
+    // 失敗した関数の名前とIRを記録（メッセージとIRは上限で切り詰める）
+    void recordFailure(const llvm::Function &func, std::string message);
+  };
+
+} // namespace asmtowasm
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // 64バイトブロック内の文字種ビットマスク（ビットiはブロック先頭からiバイト目）
+  struct BlockMasks
+  {
+    uint64_t newline = 0; // '\n'
+    uint64_t comment = 0; // '#'
+    uint64_t blank = 0;   // ' ', '\t', '\r', '\v', '\f'
+    uint64_t comma = 0;   // ','
+    uint64_t paren = 0;   // '(' と ')'
+    uint64_t quote = 0;   // '\''
+  };
+
+  // 行スキャナ
+  // 入力を64バイト単位でSIMD分類し、ブロックごとにトークン開始・終了・改行のビットを求めておき、
+  // 行の処理ではそのビットを順に走査してトークン境界へ直接飛ぶ。
+  // 区切りは空白と括弧外のカンマ、'#'から行末まではコメント
+  // 文字リテラル（'x' と '\x'）の中のカンマ・空白・括弧・'#'は区切りやコメントにしない
+  class LineScanner
+  {
+  public:
+    static constexpr size_t kBlockSize = 64;
+
+    LineScanner(const char *data, size_t size);
+
+    // 次の1行をトークンに分割（入力の終端ならfalse、空行でもtrueを返す）
+    bool nextLine(std::vector<std::string_view> &tokens);
+
+    // 実行時に選択された分類カーネル名（"avx2" / "sse2" / "scalar"）
+    static const char *kernelName();
+
+    // 分類カーネルを名前で切り替える（ベンチマーク用。このCPUで使えなければfalse）
+    // 選択はプロセス全体に効くので、パース中には呼ばない
+    static bool useKernel(std::string_view name);
+
+    // 64バイトのブロックを分類（blockはkBlockSizeバイト読めること）
+    static void classifyBlock(const char *block, BlockMasks &masks);
+
+  private:
+    const char *data_;
+    size_t size_;
+    size_t pos_ = 0;
+
+    // 現在のブロックのイベント
+    size_t block_ = SIZE_MAX;
+    uint64_t starts_ = 0;  // トークン先頭
+    uint64_t ends_ = 0;    // トークン直後の位置
+    uint64_t newline_ = 0; // 行末
+
+    // ブロックをまたいで持ち越す状態
+    bool prevTokenByte_ = false; // 前ブロック末尾のバイトがトークンの一部か
+    bool inComment_ = false;
+    size_t literalCarry_ = 0; // 前ブロックから続く文字リテラルのこのブロックでのバイト数
+    int depth_ = 0; // 括弧の深さ（括弧内のカンマと空白はトークンを区切らない）
+
+    // 行の途中のトークン
+    bool tokenOpen_ = false;
+    size_t tokenStart_ = 0;
+
+    // 次のブロックを分類してイベントを求める（ブロックは先頭から順に処理する）
+    void scanBlock(size_t block);
+
+    // posの'\''から始まる文字リテラルのバイト数（リテラルでなければ0）
+    size_t literalLength(size_t pos) const;
+  };
+
+} // namespace asmtowasm
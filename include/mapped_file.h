@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace asmtowasm
+{
+
+  // 読み取り専用でメモリマップしたファイル
+  // mmapが使えない環境ではファイル全体をバッファに読み込む
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // ファイルを開いてマップする
+    bool open(const std::string &filename, std::string &errorMessage);
+
+    // マップを解除する
+    void close();
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string fallback_; // mmap非対応時の読み込みバッファ
+  };
+
+} // namespace asmtowasm
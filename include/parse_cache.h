@@ -0,0 +1,43 @@
+#pragma once
+
+#include "instruction_table.h"
+#include <cstdint>
+#include <string>
+
+namespace asmtowasm
+{
+
+  // パース結果のバイナリキャッシュ
+  // ソース内容のハッシュをキーにキャッシュディレクトリへ保存し、
+  // 同じ内容のソースはテキストをパースせずにイメージから復元する
+  class ParseCache
+  {
+  public:
+    // 形式を変えたら上げる
+    static constexpr uint32_t kFormatVersion = 2;
+
+    explicit ParseCache(std::string directory) : directory_(std::move(directory)) {}
+
+    // ソース内容のハッシュ
+    static uint64_t hashSource(const char *data, size_t size);
+
+    // キャッシュイメージのパス
+    std::string imagePath(uint64_t sourceHash) const;
+
+    // キャッシュを読み込む（存在しない・不正な場合はfalse）
+    bool load(uint64_t sourceHash, size_t sourceSize, InstructionTable &table,
+              LabelTable &labels) const;
+
+    // キャッシュを書き込む
+    bool store(uint64_t sourceHash, size_t sourceSize, const InstructionTable &table,
+               const LabelTable &labels, std::string &errorMessage) const;
+
+  private:
+    std::string directory_;
+
+    // イメージを検証して命令テーブルへ展開（記録ごとのヒープ確保は行わない）
+    static bool decode(const char *data, size_t size, uint64_t sourceHash, size_t sourceSize,
+                       InstructionTable &table, LabelTable &labels);
+  };
+
+} // namespace asmtowasm
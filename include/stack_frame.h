@@ -0,0 +1,61 @@
+#pragma once
+
+#include "assembly_parser.h"
+#include "control_flow.h"
+#include "instruction_table.h"
+#include <cstdint>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // シャドウスタック: モジュール全体のスタックポインタ（グローバル）が指す、データとは別の予約領域
+  // 領域は2ページ目 [kShadowStackBase, kShadowStackBase + kShadowStackSize) で、上位アドレスから下へ伸びる
+  constexpr const char *kStackPointerName = "__stack_pointer";
+  constexpr uint32_t kShadowStackBase = 65536;
+  constexpr uint32_t kShadowStackSize = 65536;
+  constexpr uint32_t kShadowStackTop = kShadowStackBase + kShadowStackSize; // スタックポインタの初期値
+
+  // 関数ごとのスタックフレーム
+  struct StackFrame
+  {
+    bool usesStack = false; // PUSH/POPを含む
+    bool promoted = false;  // PUSH/POPの対が関数内で釣り合い、スロットをSSA値にできる
+    bool usesStackPointer = false; // %espを直接読み書きする（add %esp, 4 や 4(%esp) など）
+    uint32_t slotCount = 0; // 同時に積まれる値の最大数（昇格した関数のみ）
+  };
+
+  // フレーム解析の結果
+  struct StackLayout
+  {
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    std::vector<StackFrame> frames; // 記号ID -> フレーム（末尾はラベルのないmain用）
+    std::vector<uint32_t> slots;    // 命令番号 -> PUSHが積む/POPが取り出すスロット（到達しなければkNoSlot）
+  };
+
+  // PUSH/POPの釣り合いの解析
+  // 関数内の制御フローに沿ってスタックの深さを流し、次をすべて満たす関数を昇格する:
+  //   合流点で深さが一致する、入口より下をPOPしない、戻るときの深さが0、%espを直接使わない、
+  //   呼び出し先もすべて昇格できる（呼び出し先の積み残しや N(%esp) での読み出しは呼び出し元のスロットを見る）
+  // 昇格した関数のスロットは呼び出し先から見えないので、メモリに置かずレジスタと同じくSSA値にできる
+  class StackFrameAnalysis
+  {
+  public:
+    explicit StackFrameAnalysis(const InstructionTable &table) : table_(table) {}
+
+    // 関数ごとの命令範囲とそのCFGから解析（ラベルのないmainの範囲の記号IDは記号数）
+    StackLayout run(const std::vector<FunctionRange> &ranges, const std::vector<FunctionCfg> &graphs);
+
+  private:
+    static constexpr uint32_t kUnknown = UINT32_MAX;
+
+    const InstructionTable &table_;
+    std::vector<uint32_t> depths_; // 解析中の範囲のブロックごとの入口でのスタックの深さ
+
+    // 範囲の深さを求めてスロットを記録し、釣り合っていればtrue
+    bool analyzeRange(const FunctionCfg &graph, StackLayout &layout, StackFrame &frame,
+                      std::vector<uint32_t> &callees);
+  };
+
+} // namespace asmtowasm
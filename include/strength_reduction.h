@@ -0,0 +1,43 @@
+#pragma once
+
+#include <llvm/ADT/APInt.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+#include <cstddef>
+
+namespace asmtowasm
+{
+
+  // 置き換えた命令の数
+  struct StrengthReductionStats
+  {
+    size_t multiplies = 0;      // mul -> シフトと加減算
+    size_t signedDivides = 0;   // sdiv -> シフト、または上位ビットの乗算とシフト
+    size_t unsignedDivides = 0; // udiv -> シフト、または上位ビットの乗算とシフト
+  };
+
+  // 定数による乗除算の強度低減
+  // Wasmは乗除算をそのまま実行するので、LLVMのバックエンドが行う置き換えをIRの段階で行う:
+  //   乗算: 2の冪はシフト、2^k±1はシフトと加減算（定数が負なら結果の符号を反転）
+  //   除算: 2の冪はシフト（符号付きは負の被除数が0方向へ丸まるよう2^k-1を足してから）、
+  //         それ以外はマジックナンバーとの積の上位32ビット（i64で計算）とシフト
+  // 最適化パイプラインの後に実行する（InstCombineは2^k±1の乗算を元に戻す）
+  // 除算はi32だけが対象（i64の上位ビットの乗算はWasmにない）
+  class StrengthReduction
+  {
+  public:
+    // モジュールの全関数の定数による乗除算を置き換える
+    StrengthReductionStats run(llvm::Module &module);
+
+  private:
+    // 置き換えた値（置き換えない定数ならnull）
+    static llvm::Value *reduceMultiply(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &c);
+    static llvm::Value *reduceSignedDivide(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &d);
+    static llvm::Value *reduceUnsignedDivide(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &d);
+
+    // i32同士の積の上位32ビット
+    static llvm::Value *multiplyHigh(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &magic,
+                                     bool isSigned);
+  };
+
+} // namespace asmtowasm
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  // 名前を密な32ビットIDに対応付けるインターナー
+  // ハッシュ表はオープンアドレス法で、検索時に文字列を確保しない
+  class SymbolTable
+  {
+  public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    // 名前を登録してIDを返す（既存ならそのID）
+    uint32_t intern(std::string_view name);
+
+    // 登録済みの名前のIDを返す（未登録ならkNone）
+    uint32_t find(std::string_view name) const;
+
+    // IDの名前（テーブルが生きている間は有効）
+    std::string_view name(uint32_t id) const { return names_[id]; }
+
+    size_t size() const { return names_.size(); }
+
+    void clear();
+
+  private:
+    std::deque<std::string> names_; // ID -> 名前（要素のアドレスが動かない）
+    std::vector<uint32_t> slots_;   // ハッシュ表（kNoneは空き）
+
+    static uint64_t hash(std::string_view name);
+    size_t findSlot(std::string_view name, uint64_t h) const;
+    void rehash(size_t slotCount);
+  };
+
+} // namespace asmtowasm
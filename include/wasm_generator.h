@@ -1,5 +1,6 @@
 #pragma once
 
+#include "symbol_table.h"
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
@@ -14,8 +15,10 @@
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <memory>
-#include <map>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace asmtowasm
@@ -46,6 +49,7 @@ namespace asmtowasm
     RETURN,
     CALL,
     CALL_INDIRECT,
+    RETURN_CALL, // 末尾呼び出し（tail-call拡張）
 
     // パラメータとローカル
     DROP,
@@ -243,17 +247,37 @@ namespace asmtowasm
     std::string name;
     std::vector<WasmType> params;
     std::vector<WasmType> locals;
-    WasmType returnType;
+    std::vector<WasmType> results; // 戻り値（構造体を返す関数は複数の値）
     std::vector<WasmInstruction> instructions;
 
-    WasmFunction(const std::string &n) : name(n), returnType(WasmType::VOID) {}
+    WasmFunction(const std::string &n) : name(n) {}
+  };
+
+  // WebAssemblyグローバル
+  struct WasmGlobal
+  {
+    std::string name;
+    WasmType type;
+    bool isMutable;
+    uint64_t initialValue;
   };
 
   // WebAssemblyモジュール
   struct WasmModule
   {
     std::vector<WasmFunction> functions;
-    std::map<std::string, uint32_t> functionIndices;
+    std::vector<WasmGlobal> globals;
+    SymbolTable symbols;                   // 関数名の記号表（パーサーの記号表を引き継ぐ）
+    std::vector<uint32_t> functionIndices; // 記号ID -> 関数インデックス（なければkNoFunction）
+
+    static constexpr uint32_t kNoFunction = UINT32_MAX;
+
+    // 名前から関数インデックスを引く（なければkNoFunction）
+    uint32_t findFunction(std::string_view name) const
+    {
+      const uint32_t id = symbols.find(name);
+      return id < functionIndices.size() ? functionIndices[id] : kNoFunction;
+    }
     uint32_t memorySize;
     uint32_t memoryMaxSize;
 
@@ -267,8 +291,19 @@ namespace asmtowasm
     WasmGenerator();
     ~WasmGenerator() = default;
 
-    // LLVM IRからWebAssemblyを生成
-    bool generateWasm(llvm::Module *module);
+    // LLVM IRからWebAssemblyを生成（新しいインスタンスか、reset()の後に呼ぶ）
+    // symbolsを渡すと関数の記号IDをパーサーと共通にする
+    bool generateWasm(llvm::Module *module, const SymbolTable *symbols = nullptr);
+
+    // 前のジョブの関数、グローバル、ローカルの割り当てを捨てる
+    // 表と命令列のバッファは容量を残して次のジョブで再利用する（設定は引き継ぐ）
+    void reset();
+
+    // reset()してからgenerateWasm（1つのインスタンスで小さなモジュールを繰り返し生成する用途）
+    bool compile(llvm::Module *module, const SymbolTable *symbols = nullptr);
+
+    // tail-call拡張を使うか（末尾呼び出しの直後のretをreturn_callにまとめる）
+    void setTailCallEnabled(bool enabled) { tailCallEnabled_ = enabled; }
 
     // WebAssemblyバイナリをファイルに出力
     bool writeWasmToFile(const std::string &filename);
@@ -284,13 +319,24 @@ namespace asmtowasm
 
   private:
     WasmModule wasmModule_;
+    std::vector<WasmFunction> spareFunctions_; // reset()で空にした関数（バッファを次のジョブで再利用）
     std::string errorMessage_;
-    std::map<llvm::Function *, uint32_t> functionMap_;
-    std::map<llvm::Value *, uint32_t> localMap_;
+    bool tailCallEnabled_ = false;
+    std::unordered_map<llvm::Function *, uint32_t> functionMap_;
+    std::unordered_map<llvm::Value *, uint32_t> localMap_;
+    std::unordered_map<const llvm::GlobalVariable *, uint32_t> globalMap_;
+    // 先行ブロック -> (渡す値, 後続ブロックのphi) の列
+    std::unordered_map<llvm::BasicBlock *, std::vector<std::pair<llvm::Value *, llvm::PHINode *>>> phiCopies_;
 
     // LLVM型をWebAssembly型に変換
     WasmType convertLLVMType(llvm::Type *type);
 
+    // LLVM型が表すWebAssemblyの値の型を追加（voidは0個、構造体は要素ごと）
+    void appendWasmTypes(llvm::Type *type, std::vector<WasmType> &types);
+
+    // LLVMのグローバル変数をWebAssemblyグローバルに変換（ロード/ストアはglobal.get/global.setになる）
+    bool convertGlobal(llvm::GlobalVariable *global);
+
     // LLVM関数をWebAssembly関数に変換
     bool convertFunction(llvm::Function *func);
 
@@ -309,20 +355,79 @@ namespace asmtowasm
     // 分岐命令を変換
     bool convertBranchInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
 
+    // switch命令を変換（ケースごとに比較してbr_if）
+    bool convertSwitchInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
+
+    // 整数の型変換（zext、sext、trunc）を変換
+    bool convertCastInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
+
+    // select命令を変換
+    bool convertSelectInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
+
     // 関数呼び出し命令を変換
     bool convertCallInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
 
+    // 組み込み関数の呼び出し（最小/最大、abs、ビット数え、ファネルシフト）を変換
+    bool convertIntrinsicCall(llvm::CallInst *call, WasmFunction &wasmFunc);
+
     // 戻り命令を変換
     bool convertReturnInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
 
     // ロード/ストア命令を変換
     bool convertMemoryInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
-    bool convertIntToPtrInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
-    bool convertPtrToIntInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
-    bool convertBitCastInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
+
+    // 後続ブロックのphiに渡す値を、このブロックの終端の前でローカルへ設定
+    bool emitPhiCopies(llvm::BasicBlock *block, WasmFunction &wasmFunc);
+
+    // LLVM値をスタックに積む（定数、引数、命令の結果のローカル。構造体は要素を順に積む）
+    bool pushValue(llvm::Value *value, WasmFunction &wasmFunc);
+
+    // 構造体の値のindex番目の要素を積む
+    bool pushField(llvm::Value *aggregate, unsigned index, WasmFunction &wasmFunc);
+
+    // スタックに積んだ値を命令の結果のローカルへ設定（構造体は要素ごとのローカルへ逆順に）
+    void emitSetLocals(llvm::Value *value, WasmFunction &wasmFunc);
+
+    // insertvalue命令を変換（要素ごとのローカルへ新しい構造体を作る）
+    bool convertInsertValueInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc);
+
+    // 符号付きの演算のため、i32/i64より狭い整数を符号拡張して積む
+    bool pushSignExtended(llvm::Value *value, WasmFunction &wasmFunc);
+
+    // i32/i64より狭い整数の結果から上位ビットを落とす（値は常にゼロ拡張で保持）
+    void emitWrap(llvm::Type *type, WasmFunction &wasmFunc);
+
+    // 整数型をi64で保持するか（33〜64ビット）
+    static bool isWide(const llvm::Type *type);
+
+    // 型に応じてi32/i64版のオペコードを選ぶ
+    static WasmOpcode selectOpcode(const llvm::Type *type, WasmOpcode op32, WasmOpcode op64);
+
+    // Wasmでは何もしない型変換（inttoptr、ptrtoint、bitcast、同じ幅で保持するzext、freeze）
+    static bool isFoldedCast(const llvm::Value *value);
+
+    // 直後の条件分岐だけが使う比較（ローカルを使わずスタックで渡す）
+    static bool isBranchCondition(const llvm::Instruction *inst);
+
+    // 同じブロックの唯一の利用者で要素を直接積むinsertvalue（戻り値の構造体の組み立てなど）
+    static bool isFoldedInsertValue(const llvm::Value *value);
+
+    // ロード/ストアの offset= に畳み込むアドレスの定数の加算
+    static bool isFoldedOffset(const llvm::Value *value);
+
+    // ロード/ストアのアドレスを積み、畳み込んだ定数の変位をoffsetに返す
+    bool pushAddress(llvm::Value *pointer, uint64_t &offset, WasmFunction &wasmFunc);
+
+    // return_callにする呼び出し（tail-call拡張が有効で、tail/musttailの呼び出しの値を直後のret、またはretだけのブロックがそのまま返す）
+    bool isReturnCall(const llvm::Instruction *inst) const;
+
+    // allocaからの読み出し（allocaはローカルとして扱う）
+    static bool isAllocaLoad(const llvm::Value *value);
 
     // LLVM値をWebAssemblyローカルインデックスに変換
+    // 構造体の値は要素ごとに連続したローカルを割り当て、先頭のインデックスを返す
     uint32_t assignLocalIndex(llvm::Value *value, WasmType type, WasmFunction &wasmFunc);
+    uint32_t assignLocalIndices(llvm::Value *value, WasmFunction &wasmFunc);
     uint32_t getLocalIndex(llvm::Value *value);
 
     // WebAssemblyバイナリを生成
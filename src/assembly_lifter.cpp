@@ -1,212 +1,1046 @@
 #include "assembly_lifter.h"
+#include "ir_verifier.h"
+#include "strength_reduction.h"
+#include <algorithm>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/InstIterator.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Intrinsics.h>
+#include <llvm/Analysis/LazyCallGraph.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/raw_ostream.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <sstream>
 #include <iostream>
+#include <thread>
 
 namespace asmtowasm
 {
 
   AssemblyLifter::AssemblyLifter()
       : context_(std::make_unique<llvm::LLVMContext>()),
-        module_(std::make_unique<llvm::Module>("assembly_module", *context_)),
-        builder_(std::make_unique<llvm::IRBuilder<>>(*context_))
+        builder_(std::make_unique<llvm::IRBuilder<>>(*context_)),
+        log_(&std::cout)
   {
-    registers_.clear();
-    blocks_.clear();
+    createModule();
     functions_.clear();
     errorMessage_.clear();
   }
 
-  bool AssemblyLifter::liftToLLVM(const std::vector<Instruction> &instructions,
-                                  const std::map<std::string, size_t> &labels)
+  void AssemblyLifter::createModule()
   {
-    std::cout << "Assemblyリフター: LLVM IR生成を開始" << std::endl;
-    std::cout << "命令数: " << instructions.size() << ", ラベル数: " << labels.size() << std::endl;
+    // 出力先はwasm32（ポインタは32ビット）。最適化パスはこの前提でアドレス計算を扱う
+    module_ = std::make_unique<llvm::Module>("assembly_module", *context_);
+    module_->setTargetTriple("wasm32-unknown-unknown");
+    module_->setDataLayout("e-m:e-p:32:32-i64:64-n32:64-S128");
+  }
+
+  void AssemblyLifter::reset()
+  {
+    // 命令を参照する挿入位置と解析結果を先に捨ててから、モジュールを作り直す
+    builder_->ClearInsertionPoint();
+    blockStates_.clear();
+    pendingPhis_.clear();
+    trivialPhiCandidates_.clear();
+    cfgBlocks_.clear();
+    pendingEdges_.clear();
+    functions_.clear();
+    createModule();
+
+    table_ = nullptr;
+    mainSymbol_ = SymbolTable::kNone;
+    walkCounter_ = 0;
+    callTargets_.clear();
+    functionRanges_.clear();
+    controlFlow_.reset();
+    currentGraph_ = nullptr;
+    currentBlock_ = 0;
+    conventions_.clear();
+    stackLayout_.reset();
+    inlineBodies_.reset();
+    inlinedFunctions_.clear();
+    currentSymbol_ = SymbolTable::kNone;
+    wideRegisters_ = false;
+    selfTailLoop_ = false;
+    errorMessage_.clear();
+  }
+
+  bool AssemblyLifter::compile(const InstructionTable &instructions, const LabelTable &labels)
+  {
+    reset();
+    return liftToLLVM(instructions, labels);
+  }
+
+  bool AssemblyLifter::liftToLLVM(const InstructionTable &instructions,
+                                  const LabelTable &labels)
+  {
+    table_ = &instructions;
+
+    // 記号IDで引く表を用意（関数表の末尾はラベルのないmain用）
+    const size_t symbolCount = instructions.symbols().size();
+    mainSymbol_ = instructions.symbols().find("main");
+    if (mainSymbol_ == SymbolTable::kNone)
+    {
+      mainSymbol_ = static_cast<uint32_t>(symbolCount);
+    }
+    *log_ << "Assemblyリフター: LLVM IR生成を開始" << std::endl;
+    *log_ << "命令数: " << instructions.size() << ", ラベル数: " << labels.size() << std::endl;
+
+    // CALL先ラベル（関数として扱う）を事前収集し、命令列を関数ごとの範囲に分ける
+    callTargets_.assign(symbolCount, false);
+    for (InstructionView inst : instructions)
+    {
+      OperandSpan operands = inst.operands();
+      if (inst.type() == InstructionType::CALL && operands.size() == 1 && operands[0].type == OperandType::LABEL)
+      {
+        callTargets_[operands[0].symbol] = true;
+      }
+    }
+    resetFunctionState();
+    collectFunctionRanges();
+
+    // 64ビットレジスタを使う入力はレジスタファイルをi64にする（32ビットだけの入力は従来どおりi32）
+    auto isWide = [](RegisterId reg) { return registerAlias(reg).bits == 64; };
+    wideRegisters_ = false;
+    for (InstructionView inst : instructions)
+    {
+      for (const Operand &operand : inst.operands())
+      {
+        wideRegisters_ = wideRegisters_ || (operand.type == OperandType::REGISTER && isWide(operand.reg)) ||
+                         (operand.type == OperandType::MEMORY &&
+                          (isWide(operand.memory.base) || isWide(operand.memory.index)));
+      }
+    }
+    *log_ << "レジスタ幅: " << (wideRegisters_ ? 64 : 32) << "ビット" << std::endl;
 
-    // CALL先ラベルを事前収集（関数として扱う）
-    std::map<std::string, bool> callTargets;
-    for (const auto &inst : instructions)
+    // 関数ごとに基本ブロックと到達性を一度だけ求める（以降の解析とリフトは到達するブロックだけを見る）
+    controlFlow_ = std::make_shared<const std::vector<FunctionCfg>>(
+        ControlFlowAnalysis(instructions, labels).run(functionRanges_));
+    for (size_t r = 0; r < functionRanges_.size(); ++r)
     {
-      if (inst.type == InstructionType::CALL && inst.operands.size() == 1 && inst.operands[0].type == OperandType::LABEL)
+      const std::vector<CfgBlock> &cfgBlocks = (*controlFlow_)[r].blocks;
+      const size_t unreachable = std::count_if(cfgBlocks.begin(), cfgBlocks.end(),
+                                               [](const CfgBlock &block) { return !block.reachable; });
+      *log_ << "制御フロー: " << symbolName(functionRanges_[r].symbol) << " ブロック=" << cfgBlocks.size() - unreachable;
+      if (unreachable != 0)
       {
-        callTargets[inst.operands[0].value] = true;
+        *log_ << " (到達しないブロック " << unreachable << " 個を除外)";
       }
+      *log_ << std::endl;
     }
 
-    // 関数はラベル到達時に作成
-    llvm::FunctionType *funcType = llvm::FunctionType::get(getIntType(), false);
-    llvm::Function *currentFunc = nullptr;
+    // 関数ごとにレジスタで受け渡す引数と戻り値を推論
+    conventions_ = CallingConventionAnalysis(instructions).run(functionRanges_, *controlFlow_, mainSymbol_);
+    for (size_t symbol = 0; symbol < conventions_.size(); ++symbol)
+    {
+      const CallingConvention &convention = conventions_[symbol];
+      if (symbol == mainSymbol_ || (convention.params | convention.results) == 0)
+      {
+        continue;
+      }
+      *log_ << "呼び出し規約: " << symbolName(static_cast<uint32_t>(symbol)) << " 引数=";
+      forEachRegister(convention.params, [&](RegisterId reg) { *log_ << fullRegisterName(reg) << " "; });
+      *log_ << "戻り値=";
+      forEachRegister(convention.results, [&](RegisterId reg) { *log_ << fullRegisterName(reg) << " "; });
+      *log_ << std::endl;
+    }
+
+    // PUSH/POPが関数内で釣り合う関数はスタックのスロットをSSA値に昇格
+    stackLayout_ = std::make_shared<const StackLayout>(StackFrameAnalysis(instructions).run(functionRanges_, *controlFlow_));
+    for (size_t symbol = 0; symbol < stackLayout_->frames.size(); ++symbol)
+    {
+      const StackFrame &frame = stackLayout_->frames[symbol];
+      if (frame.promoted)
+      {
+        *log_ << "スタックフレーム: " << symbolName(static_cast<uint32_t>(symbol)) << " スロット=" << frame.slotCount
+              << " (SSA値に昇格)" << std::endl;
+      }
+      else if (frame.usesStack || frame.usesStackPointer)
+      {
+        *log_ << "スタックフレーム: " << symbolName(static_cast<uint32_t>(symbol)) << " (シャドウスタック)" << std::endl;
+      }
+    }
 
-    // 各命令をLLVM IRに変換
-    for (size_t i = 0; i < instructions.size(); ++i)
+    // 命令数と呼び出し回数が小さい葉関数はCALLの位置へ展開する（最適化レベルによらない）
+    std::vector<InlineBody> inlineBodies;
+    if (inliningEnabled_)
     {
-      std::cout << "命令 " << i << " を処理中: ";
-      if (!instructions[i].label.empty())
+      inlineBodies = InlineAnalysis(instructions).run(functionRanges_, *controlFlow_, mainSymbol_);
+    }
+    inlineBodies.resize(symbolCount + 1);
+    inlinedFunctions_.clear();
+    for (size_t symbol = 0; symbol < inlineBodies.size(); ++symbol)
+    {
+      const InlineBody &body = inlineBodies[symbol];
+      if (body.inlined)
       {
-        std::cout << "ラベル=" << instructions[i].label << " ";
+        inlinedFunctions_.push_back({symbolName(static_cast<uint32_t>(symbol)), body.size, body.callSites});
+        *log_ << "インライン展開: " << symbolName(static_cast<uint32_t>(symbol)) << " 命令=" << body.size
+              << " 呼び出し=" << body.callSites << std::endl;
       }
-      std::cout << "タイプ=" << static_cast<int>(instructions[i].type) << std::endl;
+    }
+    inlineBodies_ = std::make_shared<const std::vector<InlineBody>>(std::move(inlineBodies));
+
+    // 関数の記号が重複していなければ、関数ごとに独立して並列にリフトできる
+    const unsigned threadCount = threadCount_ != 0 ? threadCount_ : std::thread::hardware_concurrency();
+    bool ok;
+    if (threadCount > 1 && functionRanges_.size() > 1 && instructions.size() >= kParallelLiftThreshold &&
+        hasUniqueFunctions())
+    {
+      ok = liftFunctionsParallel(threadCount);
+    }
+    else
+    {
+      ok = liftFunctions(0, functionRanges_.size());
+    }
+    if (!ok)
+    {
+      return false;
+    }
+    defineStackPointer();
+    // 逐次と並列のリフトで同じIRを最適化パスに渡す
+    canonicalizeUseLists();
+
+    // each-passではリフトの誤りを最適化パスに渡す前に検出する
+    if (verifyMode_ == VerifyMode::EachPass && !verifyModule("リフト直後"))
+    {
+      return false;
+    }
+
+    if (!applyOptimizationPasses())
+    {
+      return false;
+    }
+
+    // 定数による乗除算をシフトと上位ビットの乗算に置き換える（パイプラインに戻されないよう最後に）
+    const StrengthReductionStats reduced = StrengthReduction().run(*module_);
+    *log_ << "強度低減: 乗算=" << reduced.multiplies << " 符号付き除算=" << reduced.signedDivides
+          << " 符号なし除算=" << reduced.unsignedDivides << std::endl;
+
+    // Wasm生成へ渡すIRを検証
+    if (verifyMode_ != VerifyMode::None && !verifyModule("最終"))
+    {
+      return false;
+    }
+    *log_ << "Assemblyリフター: LLVM IR生成完了" << std::endl;
 
-      // ラベル付きの命令: 関数開始 or 現関数内ブロック
-      if (!instructions[i].label.empty())
+    return true;
+  }
+
+  void AssemblyLifter::collectFunctionRanges()
+  {
+    // 関数はmainまたはCALL先のラベルから次の関数の手前まで（最初の関数より前の命令はmainの入口）
+    functionRanges_.clear();
+    for (size_t i = 0; i < table_->size(); ++i)
+    {
+      InstructionView inst = (*table_)[i];
+      const bool startsFunction = inst.hasLabel() && (inst.labelId() == mainSymbol_ || callTargets_[inst.labelId()]);
+      if (startsFunction || functionRanges_.empty())
       {
-        const std::string &labelName = instructions[i].label;
-        if (labelName == "main" || callTargets.count(labelName) > 0)
+        if (!functionRanges_.empty())
         {
-          // 新しい関数に切替え
-          currentFunc = getOrCreateFunction(labelName);
-          if (!currentFunc)
+          functionRanges_.back().end = i;
+        }
+        FunctionRange range;
+        range.symbol = startsFunction ? inst.labelId() : mainSymbol_;
+        range.begin = i;
+        functionRanges_.push_back(range);
+      }
+    }
+    if (!functionRanges_.empty())
+    {
+      functionRanges_.back().end = table_->size();
+    }
+  }
+
+  bool AssemblyLifter::hasUniqueFunctions() const
+  {
+    std::vector<bool> seen(functions_.size(), false);
+    for (const FunctionRange &range : functionRanges_)
+    {
+      if (seen[range.symbol])
+      {
+        return false;
+      }
+      seen[range.symbol] = true;
+    }
+    return true;
+  }
+
+  void AssemblyLifter::resetFunctionState()
+  {
+    const size_t symbolCount = table_->symbols().size();
+    functions_.assign(symbolCount + 1, nullptr);
+    blockStates_.clear();
+    pendingPhis_.clear();
+    trivialPhiCandidates_.clear();
+  }
+
+  bool AssemblyLifter::liftFunctions(size_t first, size_t last)
+  {
+    for (size_t r = first; r < last; ++r)
+    {
+      const FunctionRange &range = functionRanges_[r];
+      const FunctionCfg &graph = (*controlFlow_)[r];
+      InstructionView head = (*table_)[range.begin];
+      const bool labeled = head.hasLabel() && head.labelId() == range.symbol;
+      if (graph.duplicateLabel != SymbolTable::kNone)
+      {
+        errorMessage_ = "ラベルが重複しています: " + symbolName(graph.duplicateLabel);
+        return false;
+      }
+
+      // 関数を開始（関数ラベルより前の命令はmainの入口ブロックへ）
+      if (!beginFunction(range.symbol, labeled ? std::string(head.label()) : "entry"))
+      {
+        *log_ << "関数の作成に失敗: " << symbolName(range.symbol) << std::endl;
+        return false;
+      }
+      if (!liftBlocks(graph))
+      {
+        return false;
+      }
+
+      // 関数は範囲の終わりで閉じる（ログと結果が塊の分け方に依存しないように）
+      finishFunction();
+    }
+    return true;
+  }
+
+  bool AssemblyLifter::liftBlocks(const FunctionCfg &graph)
+  {
+    currentGraph_ = &graph;
+    cfgBlocks_.assign(graph.blocks.size(), nullptr);
+    pendingEdges_.resize(graph.blocks.size());
+    for (size_t b = 0; b < graph.blocks.size(); ++b)
+    {
+      pendingEdges_[b] = graph.blocks[b].predecessors;
+    }
+
+    // return_callを使わなければ、自己再帰の末尾呼び出しは先頭の命令へ戻るループにする
+    // （同じ関数の2つ目以降の範囲は関数の入口から始まらないので対象外）
+    llvm::BasicBlock *funcEntry = builder_->GetInsertBlock();
+    selfTailLoop_ = !tailCallEnabled_ && funcEntry == &funcEntry->getParent()->getEntryBlock();
+    uint32_t selfTailCalls = 0;
+    for (const CfgBlock &block : graph.blocks)
+    {
+      for (size_t i = block.begin; i < block.end && block.reachable && selfTailLoop_; ++i)
+      {
+        if (isTailCall(block, i) && (*table_)[i].operands()[0].symbol == currentSymbol_)
+        {
+          ++selfTailCalls;
+        }
+      }
+    }
+    pendingEdges_.front() += selfTailCalls;
+
+    // 入口ブロックは先行ブロックを持てないので、先頭の命令へ戻る辺があれば入口から分岐する
+    if (pendingEdges_.front() == 0)
+    {
+      cfgBlocks_.front() = funcEntry;
+      blockState(funcEntry).placed = true;
+    }
+    else
+    {
+      builder_->CreateBr(getOrCreateBlock(0));
+    }
+
+    for (size_t b = 0; b < graph.blocks.size(); ++b)
+    {
+      const CfgBlock &block = graph.blocks[b];
+      if (!block.reachable)
+      {
+        *log_ << "命令 " << block.begin << "-" << block.end - 1 << " は到達しないため除外" << std::endl;
+        continue;
+      }
+      currentBlock_ = static_cast<uint32_t>(b);
+      llvm::BasicBlock *basicBlock = getOrCreateBlock(currentBlock_);
+      if (basicBlock != funcEntry)
+      {
+        builder_->SetInsertPoint(basicBlock);
+        blockState(basicBlock).placed = true;
+        if (pendingEdges_[b] == 0)
+        {
+          sealBlock(basicBlock);
+        }
+      }
+
+      for (size_t i = block.begin; i < block.end; ++i)
+      {
+        InstructionView inst = (*table_)[i];
+        *log_ << "命令 " << i << " を処理中: ";
+        if (inst.hasLabel())
+        {
+          *log_ << "ラベル=" << inst.label() << " ";
+        }
+        *log_ << "タイプ=" << static_cast<int>(inst.type()) << std::endl;
+
+        if (!liftInstruction(inst, i))
+        {
+          *log_ << "命令 " << i << " の処理に失敗しました" << std::endl;
+          return false;
+        }
+        removeTrivialPhis();
+      }
+
+      // ジャンプやRETで終わらないブロックは次のブロックへ落ちる（範囲の終わりなら関数から戻る）
+      if (!endsBlock((*table_)[block.end - 1].type()))
+      {
+        if (block.fallthrough == CfgBlock::kExit)
+        {
+          createReturn();
+        }
+        else
+        {
+          builder_->CreateBr(getOrCreateBlock(block.fallthrough));
+          addEdge(block.fallthrough);
+        }
+        removeTrivialPhis();
+      }
+    }
+    return true;
+  }
+
+  void AssemblyLifter::canonicalizeUseLists()
+  {
+    // 命令のモジュール内の通し番号と、命令が使う定数（定数式の中の定数を含む）
+    std::unordered_map<const llvm::User *, size_t> rank;
+    std::vector<llvm::Constant *> constants;
+    std::unordered_set<const llvm::Constant *> seen;
+    std::vector<llvm::Constant *> worklist;
+    for (llvm::Function &func : *module_)
+    {
+      for (llvm::Instruction &inst : llvm::instructions(func))
+      {
+        rank.emplace(&inst, rank.size());
+        for (llvm::Value *operand : inst.operands())
+        {
+          if (auto *constant = llvm::dyn_cast<llvm::Constant>(operand))
           {
-            std::cout << "関数の作成に失敗: " << labelName << std::endl;
-            return false;
+            worklist.push_back(constant);
           }
-          // ブロック名の衝突を避けるためクリア
-          blocks_.clear();
-          registers_.clear();
-          llvm::BasicBlock *funcEntry = llvm::BasicBlock::Create(*context_, labelName, currentFunc);
-          builder_->SetInsertPoint(funcEntry);
         }
-        else
+        while (!worklist.empty())
         {
-          // 現関数内のブロックとして扱う
-          if (!currentFunc)
+          llvm::Constant *constant = worklist.back();
+          worklist.pop_back();
+          if (!seen.insert(constant).second)
+          {
+            continue;
+          }
+          constants.push_back(constant);
+          if (!llvm::isa<llvm::GlobalValue>(constant))
           {
-            // まだ関数が作成されていない場合は、デフォルト関数を作成
-            currentFunc = getOrCreateFunction("main");
-            if (!currentFunc)
+            for (llvm::Value *operand : constant->operands())
             {
-              std::cout << "デフォルト関数の作成に失敗" << std::endl;
-              return false;
+              worklist.push_back(llvm::cast<llvm::Constant>(operand));
             }
           }
-          llvm::BasicBlock *labelBlock = getOrCreateBlock(labelName);
-          if (!labelBlock)
+        }
+      }
+    }
+
+    // 定数式の利用者はそれを使う最初の命令の位置、命令から使われない利用者は末尾
+    const size_t unused = rank.size();
+    std::function<size_t(const llvm::User *)> rankOf = [&](const llvm::User *user) -> size_t
+    {
+      auto found = rank.find(user);
+      if (found != rank.end())
+      {
+        return found->second;
+      }
+      size_t first = unused;
+      for (const llvm::User *next : user->users())
+      {
+        first = std::min(first, rankOf(next));
+      }
+      rank.emplace(user, first);
+      return first;
+    };
+    for (llvm::Constant *constant : constants)
+    {
+      if (!constant->hasNUsesOrMore(2))
+      {
+        continue;
+      }
+      constant->sortUseList(
+          [&](const llvm::Use &left, const llvm::Use &right)
           {
-            std::cout << "ブロックの作成に失敗: " << labelName << std::endl;
-            return false;
+            const size_t leftRank = rankOf(left.getUser());
+            const size_t rightRank = rankOf(right.getUser());
+            return leftRank != rightRank ? leftRank < rightRank : left.getOperandNo() < right.getOperandNo();
+          });
+    }
+  }
+
+  bool AssemblyLifter::liftFunctionsParallel(unsigned threadCount)
+  {
+    // 負荷の偏りを均すため、スレッド数より細かく、命令数がほぼ等しい連続した関数の塊に分ける
+    const size_t chunkCount = static_cast<size_t>(threadCount) * 4;
+    const size_t chunkSize = (table_->size() + chunkCount - 1) / chunkCount;
+    struct ChunkResult
+    {
+      size_t first = 0; // 関数範囲 [first, last)
+      size_t last = 0;
+      std::ostringstream log;
+      llvm::SmallVector<char, 0> bitcode;
+      std::string errorMessage;
+      bool ok = true;
+    };
+    std::vector<std::unique_ptr<ChunkResult>> results;
+    for (size_t r = 0; r < functionRanges_.size();)
+    {
+      auto result = std::make_unique<ChunkResult>();
+      result->first = r;
+      const size_t limit = functionRanges_[r].begin + chunkSize;
+      while (r < functionRanges_.size() && (r == result->first || functionRanges_[r].end <= limit))
+      {
+        ++r;
+      }
+      result->last = r;
+      results.push_back(std::move(result));
+    }
+    *log_ << "関数 " << functionRanges_.size() << " 個を " << results.size() << " 個の塊に分けて並列にリフト" << std::endl;
+
+    // ワーカーは塊ごとに独立したLLVMContextでリフトし、モジュールをビットコードにして返す
+    std::atomic<size_t> nextChunk{0};
+    auto worker = [&]()
+    {
+      for (size_t i = nextChunk++; i < results.size(); i = nextChunk++)
+      {
+        ChunkResult &result = *results[i];
+        AssemblyLifter lifter;
+        lifter.log_ = &result.log;
+        lifter.table_ = table_;
+        lifter.mainSymbol_ = mainSymbol_;
+        lifter.callTargets_ = callTargets_;
+        lifter.functionRanges_ = functionRanges_;
+        lifter.controlFlow_ = controlFlow_;
+        lifter.conventions_ = conventions_;
+        lifter.stackLayout_ = stackLayout_;
+        lifter.inlineBodies_ = inlineBodies_;
+        lifter.tailCallEnabled_ = tailCallEnabled_;
+        lifter.wideRegisters_ = wideRegisters_;
+        lifter.resetFunctionState();
+        result.ok = lifter.liftFunctions(result.first, result.last);
+        if (!result.ok)
+        {
+          result.errorMessage = lifter.errorMessage_;
+          continue;
+        }
+        llvm::raw_svector_ostream stream(result.bitcode);
+        llvm::WriteBitcodeToFile(*lifter.module_, stream, /*ShouldPreserveUseListOrder*/ true);
+      }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threadCount && t < results.size(); ++t)
+    {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : workers)
+    {
+      thread.join();
+    }
+
+    // 塊の順にログを出し、モジュールをリンク（関数の宣言は他の塊の定義で解決される）
+    for (auto &result : results)
+    {
+      *log_ << result->log.str();
+      if (!result->ok)
+      {
+        errorMessage_ = result->errorMessage;
+        return false;
+      }
+      llvm::MemoryBufferRef buffer(llvm::StringRef(result->bitcode.data(), result->bitcode.size()), "chunk");
+      llvm::Expected<std::unique_ptr<llvm::Module>> chunkModule = llvm::parseBitcodeFile(buffer, *context_);
+      if (!chunkModule)
+      {
+        errorMessage_ = "ビットコードの読み込みに失敗しました: " + llvm::toString(chunkModule.takeError());
+        return false;
+      }
+      if (llvm::Linker::linkModules(*module_, std::move(*chunkModule)))
+      {
+        errorMessage_ = "モジュールのリンクに失敗しました";
+        return false;
+      }
+    }
+
+    // 関数の並びを逐次リフトと同じ初出順（関数の開始かCALLで最初に現れた順）に揃える
+    std::vector<bool> placed(functions_.size(), false);
+    auto place = [&](uint32_t symbol)
+    {
+      if (placed[symbol])
+      {
+        return;
+      }
+      placed[symbol] = true;
+      if (llvm::Function *func = module_->getFunction(symbolName(symbol)))
+      {
+        func->removeFromParent();
+        module_->getFunctionList().push_back(func);
+      }
+    };
+    for (size_t r = 0; r < functionRanges_.size(); ++r)
+    {
+      place(functionRanges_[r].symbol);
+      for (const CfgBlock &block : (*controlFlow_)[r].blocks)
+      {
+        for (size_t i = block.begin; i < block.end && block.reachable; ++i)
+        {
+          InstructionView inst = (*table_)[i];
+          if (inst.type() == InstructionType::CALL && inst.operands().size() == 1 &&
+              inst.operands()[0].type == OperandType::LABEL && !(*inlineBodies_)[inst.operands()[0].symbol].inlined)
+          {
+            place(inst.operands()[0].symbol);
           }
-          builder_->SetInsertPoint(labelBlock);
         }
       }
+    }
+    return true;
+  }
+
+  llvm::Function *AssemblyLifter::beginFunction(uint32_t symbol, const std::string &entryName)
+  {
+    finishFunction();
+
+    llvm::Function *func = getOrCreateFunction(symbol);
+    if (!func)
+    {
+      return nullptr;
+    }
+
+    // ブロックとレジスタの定義は関数ごとに作り直す
+    currentSymbol_ = symbol;
+    llvm::BasicBlock *funcEntry = llvm::BasicBlock::Create(*context_, entryName, func);
+    blockState(funcEntry).sealed = true;
+    builder_->SetInsertPoint(funcEntry);
+
+    // 引数のレジスタは入口で引数の値を持つ
+    auto arg = func->arg_begin();
+    forEachRegister(conventions_[symbol].params, [&](RegisterId reg) { writeRegister(reg, &*arg++); });
+    return func;
+  }
+
+  void AssemblyLifter::finishFunction()
+  {
+    llvm::BasicBlock *current = builder_->GetInsertBlock();
+    if (!current)
+    {
+      return;
+    }
+
+    // CFGのブロックは入る辺がそろった時点で封鎖済みで、すべて終端命令で閉じている
+    *log_ << "関数 " << current->getParent()->getName().str() << " のブロック数: " << current->getParent()->size()
+          << std::endl;
+    removeTrivialPhis();
+    blockStates_.clear();
+    builder_->ClearInsertionPoint();
+  }
+
+  void AssemblyLifter::createReturn()
+  {
+    if (currentSymbol_ == mainSymbol_)
+    {
+      builder_->CreateRet(llvm::ConstantInt::get(getIntType(), 0));
+      return;
+    }
+
+    std::vector<llvm::Value *> values;
+    forEachRegister(conventions_[currentSymbol_].results, [&](RegisterId reg) { values.push_back(readRegister(reg)); });
+    if (values.empty())
+    {
+      builder_->CreateRetVoid();
+    }
+    else if (values.size() == 1)
+    {
+      builder_->CreateRet(values.front());
+    }
+    else
+    {
+      builder_->CreateAggregateRet(values.data(), static_cast<unsigned>(values.size()));
+    }
+  }
+
+  llvm::BasicBlock *AssemblyLifter::createSealedBlock(const char *name)
+  {
+    llvm::Function *currentFunc = builder_->GetInsertBlock()->getParent();
+    llvm::BasicBlock *block = llvm::BasicBlock::Create(*context_, name, currentFunc);
+    blockState(block).sealed = true;
+    return block;
+  }
+
+  llvm::Value *AssemblyLifter::readRegister(RegisterId reg)
+  {
+    // パース時にデコード済みの識別子から、格納先のスロットとビット位置が決まる
+    const RegisterAlias alias = registerAlias(reg);
+    llvm::Value *full = readRegisterSlot(reg);
+    if (alias.bits == 64 || (alias.bits == 32 && !wideRegisters_))
+    {
+      return full;
+    }
+    if (alias.bits == 32)
+    {
+      return builder_->CreateTrunc(full, getIntType(), registerName(reg));
+    }
+
+    // 比較が符号付きで行われるので、切り出した値は符号拡張してi32で扱う
+    llvm::Value *part = full;
+    if (alias.shift != 0)
+    {
+      part = builder_->CreateLShr(part, alias.shift);
+    }
+    part = builder_->CreateTrunc(part, llvm::Type::getIntNTy(*context_, alias.bits));
+    return builder_->CreateSExt(part, getIntType(), registerName(reg));
+  }
+
+  llvm::Value *AssemblyLifter::readRegister(PseudoRegister reg)
+  {
+    return readVariable(registerSlot(reg), builder_->GetInsertBlock());
+  }
+
+  void AssemblyLifter::writeRegister(RegisterId reg, llvm::Value *value)
+  {
+    const RegisterAlias alias = registerAlias(reg);
+    if (alias.bits == 64 || (alias.bits == 32 && !wideRegisters_))
+    {
+      writeRegisterSlot(reg, fitToType(value, getRegisterType()));
+      return;
+    }
+    if (alias.bits == 32)
+    {
+      // 32ビットレジスタへの書き込みは上位32ビットを0にする
+      llvm::Value *low = fitToType(value, getIntType());
+      writeRegisterSlot(reg, builder_->CreateZExt(low, getRegisterType(), fullRegisterName(alias.full)));
+      return;
+    }
+
+    // 格納先の他のビットを残して、サブレジスタのビットだけを置き換える
+    llvm::Type *type = getRegisterType();
+    const uint64_t mask = ((uint64_t(1) << alias.bits) - 1) << alias.shift;
+    llvm::Value *full = readRegisterSlot(reg);
+    llvm::Value *kept = builder_->CreateAnd(full, llvm::ConstantInt::get(type, ~mask));
+    llvm::Value *part = builder_->CreateAnd(builder_->CreateZExtOrTrunc(value, type),
+                                            llvm::ConstantInt::get(type, mask >> alias.shift));
+    if (alias.shift != 0)
+    {
+      part = builder_->CreateShl(part, alias.shift);
+    }
+    writeRegisterSlot(reg, builder_->CreateOr(kept, part, fullRegisterName(alias.full)));
+  }
+
+  void AssemblyLifter::writeRegister(PseudoRegister reg, llvm::Value *value)
+  {
+    writeVariable(registerSlot(reg), builder_->GetInsertBlock(), value);
+  }
+
+  llvm::Value *AssemblyLifter::readRegisterSlot(RegisterId reg)
+  {
+    // %espはPUSH/POPと呼び出し先が同じ値を見るようにグローバルに置く
+    // （%espを直接使う関数と、それを呼ぶ関数はスタックフレーム解析で昇格しない）
+    if (registerAlias(reg).full == RegisterId::RSP)
+    {
+      llvm::Value *stackValue = builder_->CreateLoad(getIntType(), getStackPointer(), "stack_ptr");
+      return builder_->CreateZExtOrTrunc(stackValue, getRegisterType());
+    }
+    return readVariable(registerSlot(reg), builder_->GetInsertBlock());
+  }
+
+  void AssemblyLifter::writeRegisterSlot(RegisterId reg, llvm::Value *value)
+  {
+    if (registerAlias(reg).full == RegisterId::RSP)
+    {
+      builder_->CreateStore(builder_->CreateZExtOrTrunc(value, getIntType()), getStackPointer());
+      return;
+    }
+    writeVariable(registerSlot(reg), builder_->GetInsertBlock(), value);
+  }
+
+  const char *AssemblyLifter::slotName(size_t slot) const
+  {
+    if (slot < kFullRegisterCount)
+    {
+      return fullRegisterName(static_cast<RegisterId>(static_cast<size_t>(RegisterId::RAX) + slot));
+    }
+    if (slot >= kRegisterSlotCount)
+    {
+      return "stack_slot";
+    }
+    return pseudoRegisterName(static_cast<PseudoRegister>(slot - kFullRegisterCount));
+  }
+
+  const char *AssemblyLifter::fullRegisterName(RegisterId full) const
+  {
+    return registerName(wideRegisters_ ? full : lowerHalf(full));
+  }
+
+  llvm::WeakTrackingVH &AssemblyLifter::definition(BlockState &state, size_t slot)
+  {
+    if (slot < kRegisterSlotCount)
+    {
+      return state.definitions[slot];
+    }
+    // スタックのスロットは使うブロックでだけ確保する
+    const size_t stackSlot = slot - kRegisterSlotCount;
+    if (stackSlot >= state.stackSlots.size())
+    {
+      state.stackSlots.resize(stackSlot + 1);
+    }
+    return state.stackSlots[stackSlot];
+  }
+
+  void AssemblyLifter::writeVariable(size_t slot, llvm::BasicBlock *block, llvm::Value *value)
+  {
+    definition(blockState(block), slot) = value;
+  }
+
+  llvm::Value *AssemblyLifter::readVariable(size_t slot, llvm::BasicBlock *block)
+  {
+    // 先行ブロックを深くたどってもスタックを使い切らないよう、再帰の代わりに明示的なスタックを使う
+    struct Frame
+    {
+      llvm::PHINode *phi;                     // オペランドを集めている合流点のphi
+      std::vector<llvm::BasicBlock *> preds;  // phiのブロックの先行ブロック
+      size_t next;                            // 次に読む先行ブロック
+      std::vector<llvm::BasicBlock *> chain;  // phiの結果を定義として書き戻すブロック
+    };
+    std::vector<Frame> frames;
+    std::vector<llvm::BasicBlock *> chain; // 単一の先行ブロックをたどって通過したブロック
+    llvm::BasicBlock *current = block;
+
+    while (true)
+    {
+      // 定義が見つかるか、このブロックでの値を作るまで先行ブロックをたどる
+      llvm::Value *value = nullptr;
+      const uint64_t walk = ++walkCounter_;
+      while (!value)
+      {
+        BlockState &state = blockState(current);
+        value = definition(state, slot);
+        if (value)
+        {
+          break;
+        }
+        if (!state.sealed)
+        {
+          // 先行ブロックが揃っていないので、オペランドなしのphiを置いて封鎖時に埋める
+          llvm::PHINode *phi = createPhi(slot, current);
+          state.incompletePhis.emplace_back(slot, phi);
+          pendingPhis_.insert(phi);
+          writeVariable(slot, current, phi);
+          value = phi;
+          break;
+        }
+
+        std::vector<llvm::BasicBlock *> preds(llvm::pred_begin(current), llvm::pred_end(current));
+        if (preds.empty())
+        {
+          // 関数の入口（または到達しないブロック）まで定義がない
+          // Wasmのローカルと同じく、書き込み前のレジスタは0として読む
+          value = llvm::ConstantInt::get(getRegisterType(), 0);
+          writeVariable(slot, current, value);
+          break;
+        }
+        if (preds.size() == 1 && state.walk != walk)
+        {
+          state.walk = walk;
+          chain.push_back(current);
+          current = preds.front();
+          continue;
+        }
+
+        // 合流点（または到達しない、先行ブロックが1つずつの循環に戻ってきた）:
+        // 循環をたどっても止まるよう、先にphiを定義として書いてから各先行ブロックを読む
+        llvm::PHINode *phi = createPhi(slot, current);
+        pendingPhis_.insert(phi);
+        writeVariable(slot, current, phi);
+        frames.push_back(Frame{phi, std::move(preds), 0, std::move(chain)});
+        chain.clear();
+        current = frames.back().preds.front();
+      }
+
+      for (llvm::BasicBlock *passed : chain)
+      {
+        writeVariable(slot, passed, value);
+      }
+      chain.clear();
+
+      // 読んだ値を待っているphiに渡し、オペランドが揃ったphiは自明なら取り除く
+      while (true)
+      {
+        if (frames.empty())
+        {
+          return value;
+        }
+        Frame &frame = frames.back();
+        frame.phi->addIncoming(value, frame.preds[frame.next]);
+        if (++frame.next < frame.preds.size())
+        {
+          current = frame.preds[frame.next];
+          break;
+        }
+        pendingPhis_.erase(frame.phi);
+        value = tryRemoveTrivialPhi(frame.phi);
+        for (llvm::BasicBlock *passed : frame.chain)
+        {
+          writeVariable(slot, passed, value);
+        }
+        frames.pop_back();
+      }
+    }
+  }
+
+  llvm::PHINode *AssemblyLifter::createPhi(size_t slot, llvm::BasicBlock *block)
+  {
+    *log_ << "        phiを作成: " << slotName(slot) << " (" << block->getName().str() << ")" << std::endl;
+    if (block->empty())
+    {
+      return llvm::PHINode::Create(getRegisterType(), 0, slotName(slot), block);
+    }
+    return llvm::PHINode::Create(getRegisterType(), 0, slotName(slot), &block->front());
+  }
+
+  llvm::Value *AssemblyLifter::tryRemoveTrivialPhi(llvm::PHINode *phi)
+  {
+    // オペランドを集めている途中のphiは、揃った時点で改めて判定する
+    if (pendingPhis_.count(phi))
+    {
+      return phi;
+    }
+
+    llvm::Value *same = nullptr;
+    for (llvm::Value *incoming : phi->incoming_values())
+    {
+      if (incoming == same || incoming == phi)
+      {
+        continue;
+      }
+      if (same)
+      {
+        return phi; // 2種類以上の値が合流している
+      }
+      same = incoming;
+    }
+    if (!same)
+    {
+      same = llvm::UndefValue::get(phi->getType());
+    }
 
-      if (!liftInstruction(instructions[i], i))
+    // 置き換えで自明になりうる他のphiは、リフト中の命令が値を持っていないときにまとめて調べる
+    for (llvm::User *user : phi->users())
+    {
+      if (user != phi && llvm::isa<llvm::PHINode>(user))
       {
-        std::cout << "命令 " << i << " の処理に失敗しました" << std::endl;
-        return false;
+        trivialPhiCandidates_.emplace_back(user);
       }
     }
 
-    // 旧entryブロック処理は不要（関数はラベル到達時に開始）
+    // 定義表のWeakTrackingVHも置き換え先を指すようになる
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+    return same;
+  }
 
-    // すべてのBasicBlockに終端命令があることを確認
-    if (currentFunc)
+  void AssemblyLifter::removeTrivialPhis()
+  {
+    while (!trivialPhiCandidates_.empty())
     {
-      for (auto &block : *currentFunc)
+      llvm::Value *candidate = trivialPhiCandidates_.back();
+      trivialPhiCandidates_.pop_back();
+      if (auto *phi = llvm::dyn_cast_or_null<llvm::PHINode>(candidate))
       {
-        std::cout << "BasicBlock " << block.getName().str() << " をチェック中..." << std::endl;
-        if (!block.getTerminator())
-        {
-          std::cout << "BasicBlock " << block.getName().str() << " に終端命令を追加" << std::endl;
-          llvm::IRBuilder<> tempBuilder(&block);
-          tempBuilder.CreateRet(llvm::ConstantInt::get(getIntType(), 0));
-        }
-        else
-        {
-          std::cout << "BasicBlock " << block.getName().str() << " は既に終端命令を持っています" << std::endl;
-        }
+        tryRemoveTrivialPhi(phi);
       }
     }
+  }
 
-    // 最適化パスを適用
-    applyOptimizationPasses();
+  void AssemblyLifter::sealBlock(llvm::BasicBlock *block)
+  {
+    BlockState &state = blockState(block);
+    if (state.sealed)
+    {
+      return;
+    }
+    state.sealed = true;
 
-    // IRの妥当性を検証
-    std::cout << "IR検証を開始..." << std::endl;
-    std::string verifyError;
-    llvm::raw_string_ostream verifyStream(verifyError);
-    // 全関数を検証
-    for (auto &func : *module_)
+    std::vector<std::pair<size_t, llvm::PHINode *>> incompletePhis = std::move(state.incompletePhis);
+    state.incompletePhis.clear();
+    std::vector<llvm::BasicBlock *> preds(llvm::pred_begin(block), llvm::pred_end(block));
+    for (const auto &[slot, phi] : incompletePhis)
     {
-      if (func.isDeclaration())
-        continue;
-      verifyError.clear();
-      llvm::raw_string_ostream vs(verifyError);
-      if (llvm::verifyFunction(func, &vs))
-      {
-        std::cout << "IR検証エラー: " << verifyError << std::endl;
-        std::cout << "生成されたLLVM IR:" << std::endl;
-        std::string moduleDump;
-        llvm::raw_string_ostream dumpStream(moduleDump);
-        module_->print(dumpStream, nullptr);
-        std::cout << moduleDump << std::endl;
-        errorMessage_ = "IR検証エラー: " + verifyError;
-        return false;
+      for (llvm::BasicBlock *pred : preds)
+      {
+        phi->addIncoming(readVariable(slot, pred), pred);
       }
+      pendingPhis_.erase(phi);
+      tryRemoveTrivialPhi(phi);
     }
-    std::cout << "IR検証成功!" << std::endl;
-    std::cout << "Assemblyリフター: LLVM IR生成完了" << std::endl;
-
-    return true;
   }
 
-  llvm::Value *AssemblyLifter::getOrCreateRegister(const std::string &regName)
+  void AssemblyLifter::addEdge(uint32_t block)
   {
-    auto it = registers_.find(regName);
-    if (it != registers_.end())
+    llvm::BasicBlock *basicBlock = cfgBlocks_[block];
+    if (--pendingEdges_[block] == 0 && blockState(basicBlock).placed)
     {
-      std::cout << "        既存のレジスタを使用: " << regName << std::endl;
-      return it->second;
+      *log_ << "        ブロックを封鎖: " << basicBlock->getName().str() << std::endl;
+      sealBlock(basicBlock);
     }
+  }
 
-    // 新しいレジスタを作成
-    llvm::Value *reg = builder_->CreateAlloca(getIntType(), nullptr, regName);
-    registers_[regName] = reg;
-    std::cout << "        新しいレジスタを作成: " << regName << std::endl;
-    return reg;
+  const char *AssemblyLifter::pseudoRegisterName(PseudoRegister reg)
+  {
+    switch (reg)
+    {
+    case PseudoRegister::CMP_LHS:
+      return "CMP_LHS";
+    case PseudoRegister::CMP_RHS:
+      return "CMP_RHS";
+    case PseudoRegister::COUNT:
+      break;
+    }
+    return "";
   }
 
-  llvm::Value *AssemblyLifter::getOperandValue(const Operand &operand)
+  llvm::Value *AssemblyLifter::getOperandValue(const Operand &operand, llvm::Type *type)
   {
-    std::cout << "      getOperandValue: タイプ=" << static_cast<int>(operand.type) << ", 値=" << operand.value << std::endl;
+    *log_ << "      getOperandValue: タイプ=" << static_cast<int>(operand.type) << ", 値=" << table_->formatOperand(operand) << std::endl;
 
     switch (operand.type)
     {
     case OperandType::REGISTER:
     {
-      llvm::Value *reg = getOrCreateRegister(operand.value);
-      return builder_->CreateLoad(getIntType(), reg, operand.value + "_val");
+      return fitToType(readRegister(operand.reg), type);
     }
     case OperandType::IMMEDIATE:
     {
-      int value = std::stoi(operand.value);
-      return llvm::ConstantInt::get(getIntType(), value);
+      return llvm::ConstantInt::get(type, static_cast<uint64_t>(operand.immediate), /*isSigned*/ true);
     }
     case OperandType::MEMORY:
     {
-      return calculateMemoryAddress(operand);
-    }
-    case OperandType::LABEL:
-    {
-      // ラベルはBasicBlockへの参照として扱う
-      return getOrCreateBlock(operand.value);
+      // メモリオペランドの値はそのアドレスから読み込んだ値
+      return loadMemory(operand, type);
     }
     default:
       return nullptr;
     }
   }
 
-  bool AssemblyLifter::liftInstruction(const Instruction &instruction, size_t index)
+  bool AssemblyLifter::liftInstruction(InstructionView instruction, size_t index)
   {
-    std::cout << "  liftInstruction: タイプ=" << static_cast<int>(instruction.type);
-    if (!instruction.label.empty())
+    *log_ << "  liftInstruction: タイプ=" << static_cast<int>(instruction.type());
+    if (instruction.hasLabel())
     {
-      std::cout << ", ラベル=" << instruction.label;
+      *log_ << ", ラベル=" << instruction.label();
     }
-    std::cout << ", オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << ", オペランド数=" << instruction.operands().size() << std::endl;
 
-    switch (instruction.type)
+    switch (instruction.type())
     {
     case InstructionType::ADD:
     case InstructionType::SUB:
@@ -226,14 +1060,14 @@ namespace asmtowasm
     case InstructionType::JGE:
       return liftJumpInstruction(instruction);
     case InstructionType::CALL:
-      return liftCallInstruction(instruction);
+      return liftCallInstruction(instruction, index);
     case InstructionType::RET:
       return liftReturnInstruction(instruction);
     case InstructionType::PUSH:
     case InstructionType::POP:
-      return liftStackInstruction(instruction);
+      return liftStackInstruction(instruction, index);
     case InstructionType::LABEL:
-      std::cout << "  LABEL命令をスキップ" << std::endl;
+      *log_ << "  LABEL命令をスキップ" << std::endl;
       return true;
     default:
       errorMessage_ = "未対応の命令タイプ";
@@ -241,18 +1075,37 @@ namespace asmtowasm
     }
   }
 
-  bool AssemblyLifter::liftArithmeticInstruction(const Instruction &instruction)
+  bool AssemblyLifter::liftArithmeticInstruction(InstructionView instruction)
   {
-    std::cout << "    liftArithmeticInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftArithmeticInstruction: オペランド数=" << instruction.operands().size() << std::endl;
 
-    if (instruction.operands.size() < 2)
+    if (instruction.operands().size() < 2)
     {
       errorMessage_ = "算術命令には少なくとも2つのオペランドが必要です";
       return false;
     }
 
-    llvm::Value *left = getOperandValue(instruction.operands[0]);
-    llvm::Value *right = getOperandValue(instruction.operands[1]);
+    const Operand &destination = instruction.operands()[0];
+    if (destination.type == OperandType::MEMORY && instruction.operands()[1].type == OperandType::MEMORY)
+    {
+      errorMessage_ = "算術命令の両方のオペランドをメモリにはできません";
+      return false;
+    }
+
+    // メモリのデスティネーションは読み込んで演算し、同じアドレスへ書き戻す（アドレスは1度だけ計算）
+    llvm::Type *type = operationType(instruction);
+    llvm::Value *memPtr = nullptr;
+    llvm::Value *left = nullptr;
+    if (destination.type == OperandType::MEMORY)
+    {
+      memPtr = builder_->CreateIntToPtr(calculateMemoryAddress(destination), getPtrType(type), "mem_ptr");
+      left = builder_->CreateLoad(type, memPtr, "mem_val");
+    }
+    else
+    {
+      left = getOperandValue(destination, type);
+    }
+    llvm::Value *right = getOperandValue(instruction.operands()[1], type);
 
     if (!left || !right)
     {
@@ -261,120 +1114,104 @@ namespace asmtowasm
     }
 
     llvm::Value *result = nullptr;
-    switch (instruction.type)
+    switch (instruction.type())
     {
     case InstructionType::ADD:
       result = builder_->CreateAdd(left, right, "add");
-      std::cout << "    ADD命令を生成" << std::endl;
+      *log_ << "    ADD命令を生成" << std::endl;
       break;
     case InstructionType::SUB:
       result = builder_->CreateSub(left, right, "sub");
-      std::cout << "    SUB命令を生成" << std::endl;
+      *log_ << "    SUB命令を生成" << std::endl;
       break;
     case InstructionType::MUL:
       result = builder_->CreateMul(left, right, "mul");
-      std::cout << "    MUL命令を生成" << std::endl;
+      *log_ << "    MUL命令を生成" << std::endl;
       break;
     case InstructionType::DIV:
       result = builder_->CreateSDiv(left, right, "div");
-      std::cout << "    DIV命令を生成" << std::endl;
+      *log_ << "    DIV命令を生成" << std::endl;
       break;
     default:
       return false;
     }
 
-    // 結果を最初のオペランド（通常はレジスタ）に格納
-    if (instruction.operands[0].type == OperandType::REGISTER)
+    // 結果を最初のオペランド（レジスタまたはメモリ）に格納
+    if (destination.type == OperandType::REGISTER)
     {
-      llvm::Value *reg = getOrCreateRegister(instruction.operands[0].value);
-      builder_->CreateStore(result, reg);
-      std::cout << "    結果をレジスタ " << instruction.operands[0].value << " に格納" << std::endl;
+      writeRegister(destination.reg, result);
+      *log_ << "    結果をレジスタ " << table_->formatOperand(destination) << " に格納" << std::endl;
+    }
+    else if (memPtr)
+    {
+      builder_->CreateStore(result, memPtr);
+      *log_ << "    結果をメモリ " << table_->formatOperand(destination) << " に格納" << std::endl;
     }
 
     return true;
   }
 
-  bool AssemblyLifter::liftMoveInstruction(const Instruction &instruction)
+  bool AssemblyLifter::liftMoveInstruction(InstructionView instruction)
   {
-    std::cout << "    liftMoveInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftMoveInstruction: オペランド数=" << instruction.operands().size() << std::endl;
 
-    if (instruction.operands.size() != 2)
+    if (instruction.operands().size() != 2)
     {
       errorMessage_ = "MOV命令には2つのオペランドが必要です";
       return false;
     }
 
-    llvm::Value *source = getOperandValue(instruction.operands[1]);
-    if (!source)
+    // MOV dst, src: メモリ同士の転送はできない
+    const Operand &destination = instruction.operands()[0];
+    const Operand &sourceOperand = instruction.operands()[1];
+    if (destination.type == OperandType::MEMORY && sourceOperand.type == OperandType::MEMORY)
     {
-      errorMessage_ = "ソースオペランドの解析に失敗しました";
+      errorMessage_ = "MOV命令の両方のオペランドをメモリにはできません";
       return false;
     }
 
-    if (instruction.operands[0].type == OperandType::REGISTER)
+    // ソースがメモリならそのアドレスから読み込む（mov %eax, (%esi)）
+    // 64ビットレジスタとの転送は64ビット、それ以外は32ビット（mov (%rdi), %raxは8バイトを書く）
+    llvm::Value *source =
+        sourceOperand.type != OperandType::LABEL ? getOperandValue(sourceOperand, operationType(instruction)) : nullptr;
+    if (!source)
     {
-      llvm::Value *dest = getOrCreateRegister(instruction.operands[0].value);
-      builder_->CreateStore(source, dest);
-      std::cout << "    MOV命令を生成: " << instruction.operands[0].value << " = " << instruction.operands[1].value << std::endl;
+      errorMessage_ = "ソースオペランドの解析に失敗しました";
+      return false;
     }
-    else if (instruction.operands[0].type == OperandType::MEMORY)
+
+    if (destination.type == OperandType::REGISTER)
     {
-      // メモリアクセス: mov (%esi), %eax または mov %eax, (%esi)
-      if (instruction.operands[1].type == OperandType::REGISTER)
-      {
-        // mov (%esi), %eax: メモリからレジスタへ
-        llvm::Value *memAddr = calculateMemoryAddress(instruction.operands[0]);
-        llvm::Value *memPtr = builder_->CreateIntToPtr(memAddr, getPtrType(), "mem_ptr");
-        llvm::Value *reg = getOrCreateRegister(instruction.operands[1].value);
-        llvm::Value *memValue = builder_->CreateLoad(getIntType(), memPtr, "mem_val");
-        builder_->CreateStore(memValue, reg);
-        std::cout << "    MOV命令を生成: " << instruction.operands[1].value << " = " << instruction.operands[0].value << std::endl;
-      }
-      else
-      {
-        errorMessage_ = "メモリアクセスのMOV命令では、ソースはレジスタである必要があります";
-        return false;
-      }
+      writeRegister(destination.reg, source);
     }
-    else if (instruction.operands[1].type == OperandType::MEMORY)
+    else if (destination.type == OperandType::MEMORY)
     {
-      // mov %eax, (%esi): レジスタからメモリへ
-      if (instruction.operands[0].type == OperandType::REGISTER)
-      {
-        llvm::Value *reg = getOrCreateRegister(instruction.operands[0].value);
-        llvm::Value *regValue = builder_->CreateLoad(getIntType(), reg, "reg_val");
-        llvm::Value *memAddr = calculateMemoryAddress(instruction.operands[1]);
-        llvm::Value *memPtr = builder_->CreateIntToPtr(memAddr, getPtrType(), "mem_ptr");
-        builder_->CreateStore(regValue, memPtr);
-        std::cout << "    MOV命令を生成: " << instruction.operands[1].value << " = " << instruction.operands[0].value << std::endl;
-      }
-      else
-      {
-        errorMessage_ = "メモリアクセスのMOV命令では、デスティネーションはレジスタである必要があります";
-        return false;
-      }
+      // レジスタまたは即値をメモリへ（mov (%esi), %eax、mov 8(%esi), 20）
+      storeMemory(destination, source);
     }
     else
     {
       errorMessage_ = "MOV命令のデスティネーションはレジスタまたはメモリアクセスである必要があります";
       return false;
     }
+    *log_ << "    MOV命令を生成: " << table_->formatOperand(destination) << " = " << table_->formatOperand(sourceOperand) << std::endl;
 
     return true;
   }
 
-  bool AssemblyLifter::liftCompareInstruction(const Instruction &instruction)
+  bool AssemblyLifter::liftCompareInstruction(InstructionView instruction)
   {
-    std::cout << "    liftCompareInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftCompareInstruction: オペランド数=" << instruction.operands().size() << std::endl;
 
-    if (instruction.operands.size() != 2)
+    if (instruction.operands().size() != 2)
     {
       errorMessage_ = "CMP命令には2つのオペランドが必要です";
       return false;
     }
 
-    llvm::Value *left = getOperandValue(instruction.operands[0]);
-    llvm::Value *right = getOperandValue(instruction.operands[1]);
+    llvm::Type *type = operationType(instruction);
+    llvm::Value *left = getOperandValue(instruction.operands()[0], type);
+    llvm::Value *right = getOperandValue(instruction.operands()[1], type);
 
     if (!left || !right)
     {
@@ -382,51 +1219,42 @@ namespace asmtowasm
       return false;
     }
 
-    // 各種フラグを設定（符号付き比較）
-    llvm::Value *eq = builder_->CreateICmpEQ(left, right, "cmp_eq");
-    llvm::Value *lt = builder_->CreateICmpSLT(left, right, "cmp_lt");
-    llvm::Value *gt = builder_->CreateICmpSGT(left, right, "cmp_gt");
-    llvm::Value *le = builder_->CreateICmpSLE(left, right, "cmp_le");
-    llvm::Value *ge = builder_->CreateICmpSGE(left, right, "cmp_ge");
-
-    setFlagRegister("ZF", builder_->CreateZExt(eq, getIntType(), "zf_int"));
-    setFlagRegister("LT", builder_->CreateZExt(lt, getIntType(), "lt_int"));
-    setFlagRegister("GT", builder_->CreateZExt(gt, getIntType(), "gt_int"));
-    setFlagRegister("LE", builder_->CreateZExt(le, getIntType(), "le_int"));
-    setFlagRegister("GE", builder_->CreateZExt(ge, getIntType(), "ge_int"));
-    std::cout << "    CMP命令を生成 (ZF,LT,GT,LE,GE を設定)" << std::endl;
+    // フラグは作らずオペランドだけ記録し、条件ジャンプが必要な比較を1つだけ生成する
+    recordComparison(left, right);
+    *log_ << "    CMP命令のオペランドを記録（フラグは条件ジャンプで生成）" << std::endl;
 
     return true;
   }
 
-  bool AssemblyLifter::liftJumpInstruction(const Instruction &instruction)
+  bool AssemblyLifter::liftJumpInstruction(InstructionView instruction)
   {
-    std::cout << "    liftJumpInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftJumpInstruction: オペランド数=" << instruction.operands().size() << std::endl;
 
-    if (instruction.operands.size() != 1)
+    if (instruction.operands().size() != 1 || instruction.operands()[0].type != OperandType::LABEL)
     {
-      errorMessage_ = "ジャンプ命令には1つのオペランドが必要です";
+      errorMessage_ = "ジャンプ命令には1つのラベルオペランドが必要です";
       return false;
     }
 
-    llvm::BasicBlock *targetBlock = getOrCreateBlock(instruction.operands[0].value);
-    if (!targetBlock)
+    // 行き先はCFGの辺（関数から戻る辺は戻るだけのブロック）
+    const CfgBlock &block = currentGraph_->blocks[currentBlock_];
+    auto successorBlock = [&](uint32_t successor)
     {
-      errorMessage_ = "ジャンプ先のラベルが見つかりません: " + instruction.operands[0].value;
-      return false;
-    }
+      return successor == CfgBlock::kExit ? createSealedBlock("exit") : getOrCreateBlock(successor);
+    };
 
-    switch (instruction.type)
+    switch (instruction.type())
     {
     case InstructionType::JMP:
-      builder_->CreateBr(targetBlock);
-      std::cout << "    JMP命令を生成: " << instruction.operands[0].value << std::endl;
-      // 終端後に後続命令を挿入しないよう、新しい継続ブロックへ切替
+      if (block.taken == CfgBlock::kExit)
+      {
+        createReturn();
+      }
+      else
       {
-        llvm::Function *currentFunc = builder_->GetInsertBlock()->getParent();
-        llvm::BasicBlock *nextBlock = llvm::BasicBlock::Create(*context_, "cont", currentFunc);
-        builder_->SetInsertPoint(nextBlock);
+        builder_->CreateBr(getOrCreateBlock(block.taken));
       }
+      *log_ << "    JMP命令を生成: " << table_->formatOperand(instruction.operands()[0]) << std::endl;
       break;
     case InstructionType::JE:
     case InstructionType::JNE:
@@ -435,68 +1263,79 @@ namespace asmtowasm
     case InstructionType::JLE:
     case InstructionType::JGE:
     {
-      // CMPで設定したフラグを使用して条件分岐を生成
-      auto getFlagCond = [&](const char *name, bool branchWhenNonZero) -> llvm::Value *
-      {
-        llvm::Value *reg = getFlagRegister(name);
-        llvm::Value *val = builder_->CreateLoad(getIntType(), reg, std::string(name) + "_val");
-        return branchWhenNonZero
-                   ? builder_->CreateICmpNE(val, llvm::ConstantInt::get(getIntType(), 0), std::string(name) + "_nz")
-                   : builder_->CreateICmpEQ(val, llvm::ConstantInt::get(getIntType(), 0), std::string(name) + "_z");
-      };
-
-      llvm::Function *currentFunc = builder_->GetInsertBlock()->getParent();
-      llvm::BasicBlock *fallthrough = llvm::BasicBlock::Create(*context_, "cont", currentFunc);
-
-      switch (instruction.type)
-      {
-      case InstructionType::JE:
-        builder_->CreateCondBr(getFlagCond("ZF", /*branchWhenNonZero*/ true), targetBlock, fallthrough);
-        break;
-      case InstructionType::JNE:
-        builder_->CreateCondBr(getFlagCond("ZF", /*branchWhenNonZero*/ false), fallthrough, targetBlock);
-        break;
-      case InstructionType::JL:
-        builder_->CreateCondBr(getFlagCond("LT", /*branchWhenNonZero*/ true), targetBlock, fallthrough);
-        break;
-      case InstructionType::JG:
-        builder_->CreateCondBr(getFlagCond("GT", /*branchWhenNonZero*/ true), targetBlock, fallthrough);
-        break;
-      case InstructionType::JLE:
-        builder_->CreateCondBr(getFlagCond("LE", /*branchWhenNonZero*/ true), targetBlock, fallthrough);
-        break;
-      case InstructionType::JGE:
-        builder_->CreateCondBr(getFlagCond("GE", /*branchWhenNonZero*/ true), targetBlock, fallthrough);
-        break;
-      default:
-        // 他の条件は暫定で無条件ジャンプ
-        builder_->CreateBr(targetBlock);
-        break;
-      }
-
-      builder_->SetInsertPoint(fallthrough);
-      std::cout << "    条件ジャンプ命令を生成: " << instruction.operands[0].value << std::endl;
+      // 直前のCMPのオペランドから、このジャンプの条件だけを分岐条件として直接生成
+      llvm::Value *condition = materializeCondition(instruction.type());
+      llvm::BasicBlock *taken = successorBlock(block.taken);
+      llvm::BasicBlock *fallthrough = successorBlock(block.fallthrough);
+      builder_->CreateCondBr(condition, taken, fallthrough);
+
+      // 戻るブロックは分岐を張った後で、分岐元のレジスタを読んで戻る
+      for (auto [successor, exit] : {std::make_pair(block.taken, taken), std::make_pair(block.fallthrough, fallthrough)})
+      {
+        if (successor == CfgBlock::kExit)
+        {
+          builder_->SetInsertPoint(exit);
+          createReturn();
+        }
+      }
+      *log_ << "    条件ジャンプ命令を生成: " << table_->formatOperand(instruction.operands()[0]) << std::endl;
       break;
     }
     default:
       return false;
     }
 
+    // CFGの辺が確定した
+    block.forEachSuccessor([&](uint32_t successor)
+                           {
+                             if (successor != CfgBlock::kExit)
+                             {
+                               addEdge(successor);
+                             }
+                           });
     return true;
   }
 
-  bool AssemblyLifter::liftCallInstruction(const Instruction &instruction)
+  bool AssemblyLifter::isTailCall(const CfgBlock &block, size_t index) const
+  {
+    InstructionView call = (*table_)[index];
+    OperandSpan operands = call.operands();
+    if (call.type() != InstructionType::CALL || operands.size() != 1 || operands[0].type != OperandType::LABEL ||
+        index + 1 >= block.end)
+    {
+      return false;
+    }
+    InstructionView next = (*table_)[index + 1];
+    if (next.type() != InstructionType::RET || !next.operands().empty())
+    {
+      return false;
+    }
+
+    // mainは0を返し、mainの呼び出しは値を返さないので末尾呼び出しにならない
+    // %espを直接使う呼び出し先は、戻ってから戻りアドレスのスロットを外す
+    const uint32_t callee = operands[0].symbol;
+    return currentSymbol_ != mainSymbol_ && callee != mainSymbol_ &&
+           conventions_[currentSymbol_].results == conventions_[callee].results &&
+           !stackLayout_->frames[callee].usesStackPointer;
+  }
+
+  bool AssemblyLifter::liftCallInstruction(InstructionView instruction, size_t index)
   {
-    std::cout << "    liftCallInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftCallInstruction: オペランド数=" << instruction.operands().size() << std::endl;
 
-    if (instruction.operands.size() != 1)
+    if (instruction.operands().size() != 1 || instruction.operands()[0].type != OperandType::LABEL)
     {
-      errorMessage_ = "CALL命令には1つのオペランドが必要です";
+      errorMessage_ = "CALL命令には1つのラベルオペランドが必要です";
       return false;
     }
 
-    std::string funcName = instruction.operands[0].value;
-    llvm::Function *func = getOrCreateFunction(funcName);
+    const uint32_t funcSymbol = instruction.operands()[0].symbol;
+    if ((*inlineBodies_)[funcSymbol].inlined)
+    {
+      return liftInlinedCall(funcSymbol);
+    }
+    const std::string funcName = symbolName(funcSymbol);
+    llvm::Function *func = getOrCreateFunction(funcSymbol);
 
     if (!func)
     {
@@ -504,251 +1343,571 @@ namespace asmtowasm
       return false;
     }
 
-    builder_->CreateCall(func);
-    std::cout << "    CALL命令を生成: " << funcName << std::endl;
+    const bool tailCall = isTailCall(currentGraph_->blocks[currentBlock_], index);
+    if (tailCall && funcSymbol == currentSymbol_ && selfTailLoop_)
+    {
+      // 引数のレジスタはすでに次の呼び出しの値を持つので、先頭の命令へ戻るだけ
+      // （先頭のブロックで入口からの引数とphiで合流する）
+      builder_->CreateBr(cfgBlocks_.front());
+      addEdge(0);
+      *log_ << "    自己再帰の末尾呼び出しをループに変換: " << funcName << std::endl;
+      return true;
+    }
+
+    // 引数のレジスタを渡し、返されたレジスタを呼び出し後の値にする
+    // （書き換えうるが返されないレジスタは、呼び出し後に読まれない）
+    const CallingConvention &convention = conventions_[funcSymbol];
+    std::vector<llvm::Value *> args;
+    forEachRegister(convention.params, [&](RegisterId reg) { args.push_back(readRegister(reg)); });
+    // 呼び出し先が N(%esp) で引数を読むなら、x86と同じく戻りアドレスの分だけ下を指した%espで呼ぶ
+    const bool returnSlot = stackLayout_->frames[funcSymbol].usesStackPointer;
+    if (returnSlot)
+    {
+      adjustStackPointer(-static_cast<int64_t>(stackSlotSize()));
+    }
+    llvm::CallInst *call = builder_->CreateCall(func, args);
+    if (returnSlot)
+    {
+      adjustStackPointer(stackSlotSize());
+    }
+    if (tailCall)
+    {
+      // 戻り値のレジスタが一致するので、呼び出しの結果をそのまま返す（自己再帰は型が同じなのでmusttail）
+      call->setTailCallKind(funcSymbol == currentSymbol_ ? llvm::CallInst::TCK_MustTail : llvm::CallInst::TCK_Tail);
+      if (call->getType()->isVoidTy())
+      {
+        builder_->CreateRetVoid();
+      }
+      else
+      {
+        builder_->CreateRet(call);
+      }
+      *log_ << "    末尾呼び出しを生成: " << funcName << " (引数 " << args.size() << " 個)" << std::endl;
+      return true;
+    }
+    if (call->getType()->isStructTy())
+    {
+      unsigned index = 0;
+      forEachRegister(convention.results, [&](RegisterId reg)
+                      { writeRegister(reg, builder_->CreateExtractValue(call, index++, fullRegisterName(reg))); });
+    }
+    else if (!call->getType()->isVoidTy() && funcSymbol != mainSymbol_)
+    {
+      forEachRegister(convention.results, [&](RegisterId reg)
+                      {
+                        call->setName(fullRegisterName(reg));
+                        writeRegister(reg, call);
+                      });
+    }
+    *log_ << "    CALL命令を生成: " << funcName << " (引数 " << args.size() << " 個)" << std::endl;
+    return true;
+  }
+
+  bool AssemblyLifter::liftInlinedCall(uint32_t symbol)
+  {
+    const InlineBody &body = (*inlineBodies_)[symbol];
+    *log_ << "    CALLをインライン展開: " << symbolName(symbol) << " (命令 " << body.size << " 個)" << std::endl;
+    // 展開しても呼び出し先から見える%espは呼び出したときと同じにする
+    const bool returnSlot = stackLayout_->frames[symbol].usesStackPointer;
+    if (returnSlot)
+    {
+      adjustStackPointer(-static_cast<int64_t>(stackSlotSize()));
+    }
+    for (size_t i = body.begin; i < body.end; ++i)
+    {
+      if (!liftInstruction((*table_)[i], i))
+      {
+        return false;
+      }
+      removeTrivialPhis();
+    }
+    if (returnSlot)
+    {
+      adjustStackPointer(stackSlotSize());
+    }
     return true;
   }
 
-  bool AssemblyLifter::liftReturnInstruction(const Instruction &instruction)
+  bool AssemblyLifter::liftReturnInstruction(InstructionView instruction)
   {
-    std::cout << "    liftReturnInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftReturnInstruction: オペランド数=" << instruction.operands().size() << std::endl;
 
-    if (instruction.operands.empty())
+    // 直前の末尾呼び出しですでに戻っている
+    if (builder_->GetInsertBlock()->getTerminator())
     {
-      builder_->CreateRet(llvm::ConstantInt::get(getIntType(), 0));
-      std::cout << "    RET命令を生成: 0を返す" << std::endl;
+      *log_ << "    RET命令は末尾呼び出しで生成済み" << std::endl;
+      return true;
+    }
+
+    if (instruction.operands().empty())
+    {
+      createReturn();
+      *log_ << "    RET命令を生成" << std::endl;
     }
     else
     {
-      llvm::Value *retValue = getOperandValue(instruction.operands[0]);
+      llvm::Type *type = operationType(instruction);
+      llvm::Value *retValue = getOperandValue(instruction.operands()[0], type);
       if (!retValue)
       {
         errorMessage_ = "RET命令のオペランドの解析に失敗しました";
         return false;
       }
-      builder_->CreateRet(retValue);
-      std::cout << "    RET命令を生成: 値を返す" << std::endl;
+      if (currentSymbol_ == mainSymbol_)
+      {
+        builder_->CreateRet(fitToType(retValue, getIntType()));
+      }
+      else
+      {
+        // 他の関数では ret x は %eax（64ビットの値なら%rax）に x を入れて戻る
+        writeRegister(type == getIntType() ? RegisterId::EAX : RegisterId::RAX, retValue);
+        createReturn();
+      }
+      *log_ << "    RET命令を生成: 値を返す" << std::endl;
     }
     return true;
   }
 
-  bool AssemblyLifter::liftStackInstruction(const Instruction &instruction)
+  bool AssemblyLifter::liftStackInstruction(InstructionView instruction, size_t index)
   {
-    std::cout << "    liftStackInstruction: オペランド数=" << instruction.operands.size() << std::endl;
+    *log_ << "    liftStackInstruction: オペランド数=" << instruction.operands().size() << std::endl;
+
+    // 釣り合いを証明した関数では、スロットは呼び出し先から見えないのでSSA値として持つ
+    const bool promoted = stackLayout_->frames[currentSymbol_].promoted;
+    const uint32_t slot = stackLayout_->slots[index];
 
-    if (instruction.type == InstructionType::PUSH)
+    if (instruction.type() == InstructionType::PUSH)
     {
-      if (instruction.operands.size() != 1)
+      if (instruction.operands().size() != 1)
       {
         errorMessage_ = "PUSH命令には1つのオペランドが必要です";
         return false;
       }
 
-      // PUSH命令: スタックに値をプッシュ（簡単化のため、メモリに保存）
-      llvm::Value *value = getOperandValue(instruction.operands[0]);
+      llvm::Value *value = getOperandValue(instruction.operands()[0], getRegisterType());
       if (!value)
       {
         errorMessage_ = "PUSH命令のオペランドの解析に失敗しました";
         return false;
       }
 
-      // スタックポインタを取得または作成
-      llvm::Value *stackPtr = getOrCreateRegister("STACK_PTR");
-      llvm::Value *stackValue = builder_->CreateLoad(getIntType(), stackPtr, "stack_ptr_val");
-
-      // スタックポインタをデクリメント（簡単化のため、固定オフセット）
-      llvm::Value *newStackPtr = builder_->CreateSub(stackValue, llvm::ConstantInt::get(getIntType(), 4), "new_stack_ptr");
-      builder_->CreateStore(newStackPtr, stackPtr);
-
-      // 値をスタックに保存
-      llvm::Value *stackAddr = builder_->CreateIntToPtr(newStackPtr, getPtrType(), "stack_addr");
-      builder_->CreateStore(value, stackAddr);
+      if (promoted)
+      {
+        writeVariable(stackSlotVariable(slot), builder_->GetInsertBlock(), value);
+      }
+      else
+      {
+        // シャドウスタック: スタックポインタをスロットの幅（4か8）だけ減らしてから、指す位置へ保存
+        llvm::GlobalVariable *stackPointer = getStackPointer();
+        llvm::Value *stackValue = builder_->CreateLoad(getIntType(), stackPointer, "stack_ptr");
+        llvm::Value *newStackPtr = builder_->CreateSub(stackValue, llvm::ConstantInt::get(getIntType(), stackSlotSize()), "new_stack_ptr");
+        builder_->CreateStore(newStackPtr, stackPointer);
+        llvm::Value *stackAddr = builder_->CreateIntToPtr(newStackPtr, getPtrType(getRegisterType()), "stack_addr");
+        builder_->CreateStore(value, stackAddr);
+      }
 
-      std::cout << "    PUSH命令を生成: " << instruction.operands[0].value << std::endl;
+      *log_ << "    PUSH命令を生成: " << table_->formatOperand(instruction.operands()[0]);
+      if (promoted)
+      {
+        *log_ << " (スロット" << slot << ")";
+      }
+      *log_ << std::endl;
     }
-    else if (instruction.type == InstructionType::POP)
+    else if (instruction.type() == InstructionType::POP)
     {
-      if (instruction.operands.size() != 1)
+      if (instruction.operands().size() != 1)
       {
         errorMessage_ = "POP命令には1つのオペランドが必要です";
         return false;
       }
 
-      // POP命令: スタックから値をポップ（簡単化のため、メモリから読み込み）
-      llvm::Value *stackPtr = getOrCreateRegister("STACK_PTR");
-      llvm::Value *stackValue = builder_->CreateLoad(getIntType(), stackPtr, "stack_ptr_val");
-
-      // スタックから値を読み込み
-      llvm::Value *stackAddr = builder_->CreateIntToPtr(stackValue, getPtrType(), "stack_addr");
-      llvm::Value *value = builder_->CreateLoad(getIntType(), stackAddr, "stack_val");
-
-      // スタックポインタをインクリメント
-      llvm::Value *newStackPtr = builder_->CreateAdd(stackValue, llvm::ConstantInt::get(getIntType(), 4), "new_stack_ptr");
-      builder_->CreateStore(newStackPtr, stackPtr);
+      llvm::Value *value = nullptr;
+      if (promoted)
+      {
+        value = readVariable(stackSlotVariable(slot), builder_->GetInsertBlock());
+      }
+      else
+      {
+        // シャドウスタック: 指す位置から読み込んでから、スタックポインタをスロットの幅だけ増やす
+        llvm::GlobalVariable *stackPointer = getStackPointer();
+        llvm::Value *stackValue = builder_->CreateLoad(getIntType(), stackPointer, "stack_ptr");
+        llvm::Value *stackAddr = builder_->CreateIntToPtr(stackValue, getPtrType(getRegisterType()), "stack_addr");
+        value = builder_->CreateLoad(getRegisterType(), stackAddr, "stack_val");
+        llvm::Value *newStackPtr = builder_->CreateAdd(stackValue, llvm::ConstantInt::get(getIntType(), stackSlotSize()), "new_stack_ptr");
+        builder_->CreateStore(newStackPtr, stackPointer);
+      }
 
       // 値をレジスタに保存
-      if (instruction.operands[0].type == OperandType::REGISTER)
+      if (instruction.operands()[0].type == OperandType::REGISTER)
       {
-        llvm::Value *reg = getOrCreateRegister(instruction.operands[0].value);
-        builder_->CreateStore(value, reg);
+        writeRegister(instruction.operands()[0].reg, value);
       }
 
-      std::cout << "    POP命令を生成: " << instruction.operands[0].value << std::endl;
+      *log_ << "    POP命令を生成: " << table_->formatOperand(instruction.operands()[0]);
+      if (promoted)
+      {
+        *log_ << " (スロット" << slot << ")";
+      }
+      *log_ << std::endl;
     }
 
     return true;
   }
 
-  llvm::BasicBlock *AssemblyLifter::getOrCreateBlock(const std::string &labelName)
+  llvm::GlobalVariable *AssemblyLifter::getStackPointer()
   {
-    auto it = blocks_.find(labelName);
-    if (it != blocks_.end())
+    if (llvm::GlobalVariable *stackPointer = module_->getGlobalVariable(kStackPointerName))
     {
-      std::cout << "        既存のBasicBlockを使用: " << labelName << std::endl;
-      return it->second;
+      return stackPointer;
     }
+    return new llvm::GlobalVariable(*module_, getIntType(), /*isConstant*/ false, llvm::GlobalValue::ExternalLinkage,
+                                    nullptr, kStackPointerName);
+  }
 
-    // 新しいBasicBlockを作成
-    llvm::BasicBlock *currentBlock = builder_->GetInsertBlock();
-    llvm::Function *currentFunc = nullptr;
-
-    if (currentBlock)
+  void AssemblyLifter::defineStackPointer()
+  {
+    // シャドウスタックを使う関数があれば、スタックポインタは予約領域の上端から始まる
+    llvm::GlobalVariable *stackPointer = module_->getGlobalVariable(kStackPointerName);
+    if (stackPointer && !stackPointer->hasInitializer())
     {
-      currentFunc = currentBlock->getParent();
+      stackPointer->setInitializer(llvm::ConstantInt::get(getIntType(), kShadowStackTop));
     }
-    else
+  }
+
+  void AssemblyLifter::adjustStackPointer(int64_t delta)
+  {
+    llvm::GlobalVariable *stackPointer = getStackPointer();
+    llvm::Value *stackValue = builder_->CreateLoad(getIntType(), stackPointer, "stack_ptr");
+    builder_->CreateStore(builder_->CreateAdd(stackValue, llvm::ConstantInt::get(getIntType(), delta, /*isSigned*/ true)),
+                          stackPointer);
+  }
+
+  llvm::BasicBlock *AssemblyLifter::getOrCreateBlock(uint32_t block)
+  {
+    if (cfgBlocks_[block])
     {
-      // 現在のブロックが設定されていない場合は、デフォルト関数を作成
-      currentFunc = getOrCreateFunction("main");
-      if (!currentFunc)
-      {
-        std::cout << "        エラー: デフォルト関数の作成に失敗" << std::endl;
-        return nullptr;
-      }
+      return cfgBlocks_[block];
     }
 
-    llvm::BasicBlock *block = llvm::BasicBlock::Create(*context_, labelName, currentFunc);
-    blocks_[labelName] = block;
-    std::cout << "        新しいBasicBlockを作成: " << labelName << std::endl;
-    return block;
+    // ラベルで始まるブロックはラベル名、ジャンプやRETの後から始まるブロックは継続ブロック
+    InstructionView leader = (*table_)[currentGraph_->blocks[block].begin];
+    const std::string blockName = leader.hasLabel() ? std::string(leader.label()) : "cont";
+    llvm::BasicBlock *basicBlock =
+        llvm::BasicBlock::Create(*context_, blockName, builder_->GetInsertBlock()->getParent());
+    cfgBlocks_[block] = basicBlock;
+    *log_ << "        新しいBasicBlockを作成: " << blockName << std::endl;
+    return basicBlock;
   }
 
-  llvm::Function *AssemblyLifter::getOrCreateFunction(const std::string &funcName)
+  llvm::Function *AssemblyLifter::getOrCreateFunction(uint32_t symbol)
   {
-    auto it = functions_.find(funcName);
-    if (it != functions_.end())
+    const std::string funcName = symbolName(symbol);
+    if (functions_[symbol])
     {
-      std::cout << "        既存の関数を使用: " << funcName << std::endl;
-      return it->second;
+      *log_ << "        既存の関数を使用: " << funcName << std::endl;
+      return functions_[symbol];
     }
 
-    // 新しい関数を作成
-    llvm::FunctionType *funcType = llvm::FunctionType::get(getIntType(), false);
+    // 新しい関数を作成: mainは i32 ()、他の関数は引数のレジスタを受け取り、戻り値のレジスタを返す
+    // （レジスタはスロットの型で渡し、戻り値が複数なら構造体で返してWasmでは複数の戻り値になる）
+    const CallingConvention &convention = conventions_[symbol];
+    llvm::Type *returnType = getIntType();
+    std::vector<llvm::Type *> paramTypes;
+    if (symbol != mainSymbol_)
+    {
+      std::vector<llvm::Type *> resultTypes;
+      forEachRegister(convention.params, [&](RegisterId) { paramTypes.push_back(getRegisterType()); });
+      forEachRegister(convention.results, [&](RegisterId) { resultTypes.push_back(getRegisterType()); });
+      if (resultTypes.empty())
+      {
+        returnType = llvm::Type::getVoidTy(*context_);
+      }
+      else if (resultTypes.size() == 1)
+      {
+        returnType = resultTypes.front();
+      }
+      else
+      {
+        returnType = llvm::StructType::get(*context_, resultTypes);
+      }
+    }
+    llvm::FunctionType *funcType = llvm::FunctionType::get(returnType, paramTypes, false);
     llvm::Function *func = llvm::Function::Create(funcType,
                                                   llvm::Function::ExternalLinkage,
                                                   funcName,
                                                   *module_);
-    functions_[funcName] = func;
-    std::cout << "        新しい関数を作成: " << funcName << std::endl;
+    auto arg = func->arg_begin();
+    forEachRegister(convention.params, [&](RegisterId reg) { (arg++)->setName(fullRegisterName(reg)); });
+    // Wasmのメモリはアドレス0から有効（0番地へのアクセスを未定義動作として消させない）
+    func->addFnAttr(llvm::Attribute::NullPointerIsValid);
+    // 出力にはデータセグメントもlibcもないので、最適化でswitchの表引きやmemset/memcpy呼び出しを作らせない
+    func->addFnAttr("no-jump-tables", "true");
+    func->addFnAttr("no-builtins");
+    functions_[symbol] = func;
+    *log_ << "        新しい関数を作成: " << funcName << std::endl;
     return func;
   }
 
+  std::string AssemblyLifter::symbolName(uint32_t symbol) const
+  {
+    if (symbol < table_->symbols().size())
+    {
+      return std::string(table_->symbolName(symbol));
+    }
+    return "main";
+  }
+
   llvm::Type *AssemblyLifter::getIntType() const
   {
-    std::cout << "        getIntType: Int32型を取得" << std::endl;
+    *log_ << "        getIntType: Int32型を取得" << std::endl;
     return llvm::Type::getInt32Ty(*context_);
   }
 
-  llvm::Type *AssemblyLifter::getPtrType() const
+  llvm::Type *AssemblyLifter::getRegisterType() const
   {
-    std::cout << "        getPtrType: ポインタ型を取得" << std::endl;
-    return llvm::PointerType::get(getIntType(), 0);
+    return wideRegisters_ ? llvm::Type::getInt64Ty(*context_) : llvm::Type::getInt32Ty(*context_);
   }
 
-  llvm::Value *AssemblyLifter::calculateMemoryAddress(const Operand &operand)
+  llvm::Type *AssemblyLifter::operationType(InstructionView instruction) const
   {
-    // メモリアドレスを解析: (%esi), (%esi+4), (1000) など
-    std::string addr = operand.value.substr(1, operand.value.length() - 2); // ()を除去
-    std::cout << "        メモリアドレスを計算: " << operand.value << " -> " << addr << std::endl;
-
-    // 配列アクセスの最適化: レジスタ+オフセットの形式をチェック
-    if (addr.find('+') != std::string::npos)
+    for (const Operand &operand : instruction.operands())
     {
-      // (%esi+4) のような形式 - 配列アクセスとして最適化
-      size_t plusPos = addr.find('+');
-      std::string regName = addr.substr(0, plusPos);
-      std::string offsetStr = addr.substr(plusPos + 1);
+      if (operand.type == OperandType::REGISTER && registerAlias(operand.reg).bits == 64)
+      {
+        return llvm::Type::getInt64Ty(*context_);
+      }
+    }
+    return getIntType();
+  }
+
+  llvm::Value *AssemblyLifter::fitToType(llvm::Value *value, llvm::Type *type)
+  {
+    return builder_->CreateSExtOrTrunc(value, type);
+  }
 
-      llvm::Value *reg = getOrCreateRegister(regName);
-      llvm::Value *regValue = builder_->CreateLoad(getIntType(), reg, "base_addr");
+  llvm::Type *AssemblyLifter::getPtrType(llvm::Type *elementType) const
+  {
+    *log_ << "        getPtrType: ポインタ型を取得" << std::endl;
+    return llvm::PointerType::get(elementType, 0);
+  }
 
-      int offset = std::stoi(offsetStr);
+  llvm::Value *AssemblyLifter::calculateMemoryAddress(const Operand &operand)
+  {
+    // パース済みの base + index*scale + displacement を1つの正規形にする:
+    //   (base + (index << log2(scale))) + displacement
+    // 正の変位は最後に nuw で足すので、生成器はロード/ストアの offset= に畳み込める
+    const MemoryOperand &mem = operand.memory;
 
-      // メモリアライメントを考慮（4バイト境界）
-      if (offset % 4 == 0)
-      {
-        // 4バイト境界の場合は最適化
-        llvm::Value *alignedOffset = llvm::ConstantInt::get(getIntType(), offset);
-        llvm::Value *result = builder_->CreateAdd(regValue, alignedOffset, "aligned_mem_addr");
-        std::cout << "        最適化された配列アクセス: " << regName << " + " << offset << " (4バイト境界)" << std::endl;
-        return result;
-      }
-      else
+    llvm::Value *address = nullptr;
+    if (mem.base != RegisterId::NONE)
+    {
+      address = fitToType(readRegister(mem.base), getIntType());
+    }
+
+    if (mem.index != RegisterId::NONE)
+    {
+      llvm::Value *index = fitToType(readRegister(mem.index), getIntType());
+      if (mem.scale != 1)
       {
-        // 非境界の場合は通常の計算
-        llvm::Value *offsetValue = llvm::ConstantInt::get(getIntType(), offset);
-        llvm::Value *result = builder_->CreateAdd(regValue, offsetValue, "mem_addr");
-        std::cout << "        配列アクセス: " << regName << " + " << offset << " (非境界)" << std::endl;
-        return result;
+        const unsigned shift = mem.scale == 2 ? 1 : mem.scale == 4 ? 2 : 3;
+        index = builder_->CreateShl(index, shift, "scaled_index");
       }
+      address = address ? builder_->CreateAdd(address, index, "indexed_addr") : index;
     }
-    else if (addr.find('%') != std::string::npos)
+
+    llvm::Value *displacement = llvm::ConstantInt::get(getIntType(), static_cast<uint64_t>(mem.displacement), /*isSigned*/ true);
+    if (!address)
     {
-      // (%esi) のような形式 - 直接レジスタアクセス
-      llvm::Value *reg = getOrCreateRegister(addr);
-      llvm::Value *regValue = builder_->CreateLoad(getIntType(), reg, "reg_val");
-      std::cout << "        直接レジスタアクセス: " << addr << std::endl;
-      return regValue;
+      // (1000) のような形式 - 絶対アドレス
+      return displacement;
     }
-    else
+
+    if (mem.displacement > 0)
     {
-      // (1000) のような形式 - 絶対アドレス
-      int value = std::stoi(addr);
+      address = builder_->CreateNUWAdd(address, displacement, "mem_addr");
+    }
+    else if (mem.displacement < 0)
+    {
+      address = builder_->CreateAdd(address, displacement, "mem_addr");
+    }
 
-      // 絶対アドレスのアライメントチェック
-      if (value % 4 == 0)
-      {
-        std::cout << "        最適化された絶対アドレス: " << value << " (4バイト境界)" << std::endl;
-      }
-      else
-      {
-        std::cout << "        絶対アドレス: " << value << " (非境界)" << std::endl;
-      }
+    return address;
+  }
+
+  llvm::Value *AssemblyLifter::loadMemory(const Operand &operand, llvm::Type *type)
+  {
+    llvm::Value *memPtr = builder_->CreateIntToPtr(calculateMemoryAddress(operand), getPtrType(type), "mem_ptr");
+    return builder_->CreateLoad(type, memPtr, "mem_val");
+  }
+
+  void AssemblyLifter::storeMemory(const Operand &operand, llvm::Value *value)
+  {
+    llvm::Value *memPtr = builder_->CreateIntToPtr(calculateMemoryAddress(operand), getPtrType(value->getType()), "mem_ptr");
+    builder_->CreateStore(value, memPtr);
+  }
+
+  void AssemblyLifter::recordComparison(llvm::Value *left, llvm::Value *right)
+  {
+    // オペランドは擬似レジスタとしてSSAに乗るので、ラベルをまたいだ条件ジャンプでも合流点のphiで届く
+    // （スロットの型に符号拡張しても、符号付き比較と等値比較の結果は変わらない）
+    writeRegister(PseudoRegister::CMP_LHS, fitToType(left, getRegisterType()));
+    writeRegister(PseudoRegister::CMP_RHS, fitToType(right, getRegisterType()));
+  }
+
+  llvm::Value *AssemblyLifter::materializeCondition(InstructionType jump)
+  {
+    llvm::Value *left = readRegister(PseudoRegister::CMP_LHS);
+    llvm::Value *right = readRegister(PseudoRegister::CMP_RHS);
+    *log_ << "        条件を生成: " << static_cast<int>(jump) << std::endl;
 
-      return llvm::ConstantInt::get(getIntType(), value);
+    // 符号付き比較
+    switch (jump)
+    {
+    case InstructionType::JE:
+      return builder_->CreateICmpEQ(left, right, "je_cond");
+    case InstructionType::JNE:
+      return builder_->CreateICmpNE(left, right, "jne_cond");
+    case InstructionType::JL:
+      return builder_->CreateICmpSLT(left, right, "jl_cond");
+    case InstructionType::JG:
+      return builder_->CreateICmpSGT(left, right, "jg_cond");
+    case InstructionType::JLE:
+      return builder_->CreateICmpSLE(left, right, "jle_cond");
+    case InstructionType::JGE:
+      return builder_->CreateICmpSGE(left, right, "jge_cond");
+    default:
+      return llvm::ConstantInt::getTrue(*context_);
     }
   }
 
-  llvm::Value *AssemblyLifter::getFlagRegister(const std::string &flagName)
+  bool AssemblyLifter::verifyModule(const std::string &stage)
   {
-    std::cout << "        フラグレジスタを取得: " << flagName << std::endl;
-    return getOrCreateRegister("FLAG_" + flagName);
+    const auto start = std::chrono::steady_clock::now();
+    IrVerifier verifier(threadCount_);
+    if (!verifier.run(*module_))
+    {
+      reportVerifyFailure(verifier.failure(), stage);
+      return false;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    *log_ << "IR検証成功 (" << stage << "): " << elapsed.count() / 1000.0 << " ms" << std::endl;
+    return true;
   }
 
-  void AssemblyLifter::setFlagRegister(const std::string &flagName, llvm::Value *value)
+  void AssemblyLifter::reportVerifyFailure(const VerifyFailure &failure, const std::string &stage)
   {
-    llvm::Value *flagReg = getFlagRegister(flagName);
-    builder_->CreateStore(value, flagReg);
-    std::cout << "        フラグレジスタを設定: " << flagName << std::endl;
+    *log_ << "IR検証エラー (" << stage << "): 関数 " << failure.function << std::endl;
+    *log_ << failure.message << std::endl;
+    *log_ << "関数 " << failure.function << " のLLVM IR:" << std::endl;
+    *log_ << failure.dump << std::endl;
+    errorMessage_ = "IR検証エラー (" + stage + "): 関数 " + failure.function + ": " + failure.message;
   }
 
-  void AssemblyLifter::applyOptimizationPasses()
+  bool AssemblyLifter::applyOptimizationPasses()
   {
-    std::cout << "最適化パスを適用中..." << std::endl;
+    if (optimizationLevel_ == OptimizationLevel::O0)
+    {
+      *log_ << "最適化パス: -O0 のため適用しません" << std::endl;
+      return true;
+    }
+
+    llvm::OptimizationLevel level = llvm::OptimizationLevel::O2;
+    const char *levelName = "-O2";
+    switch (optimizationLevel_)
+    {
+    case OptimizationLevel::O1:
+      level = llvm::OptimizationLevel::O1;
+      levelName = "-O1";
+      break;
+    case OptimizationLevel::O3:
+      level = llvm::OptimizationLevel::O3;
+      levelName = "-O3";
+      break;
+    case OptimizationLevel::Os:
+      level = llvm::OptimizationLevel::Os;
+      levelName = "-Os";
+      break;
+    default:
+      break;
+    }
+    *log_ << "最適化パスを適用中: " << levelName << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+
+    // each-pass: パスが変更した単位（関数、SCC、ループを含む関数、モジュール）をパスの直後に検証し、
+    // 失敗したら以降の任意のパスを飛ばす（壊れたIRをパスに渡さない）
+    llvm::PassInstrumentationCallbacks instrumentation;
+    IrVerifier verifier(threadCount_);
+    std::string failedPass;
+    if (verifyMode_ == VerifyMode::EachPass)
+    {
+      instrumentation.registerShouldRunOptionalPassCallback(
+          [&](llvm::StringRef, llvm::Any) { return failedPass.empty(); });
+      instrumentation.registerAfterPassCallback(
+          [&](llvm::StringRef passName, llvm::Any ir, const llvm::PreservedAnalyses &preserved)
+          {
+            // パスマネージャーとアダプターは中のパスの後に検証済み
+            if (!failedPass.empty() || preserved.areAllPreserved() || passName.contains("PassManager") ||
+                passName.contains("PassAdaptor"))
+            {
+              return;
+            }
+            bool valid = true;
+            if (llvm::any_isa<const llvm::Function *>(ir))
+            {
+              valid = verifier.run(*llvm::any_cast<const llvm::Function *>(ir));
+            }
+            else if (llvm::any_isa<const llvm::Loop *>(ir))
+            {
+              valid = verifier.run(*llvm::any_cast<const llvm::Loop *>(ir)->getHeader()->getParent());
+            }
+            else if (llvm::any_isa<const llvm::LazyCallGraph::SCC *>(ir))
+            {
+              for (const llvm::LazyCallGraph::Node &node : *llvm::any_cast<const llvm::LazyCallGraph::SCC *>(ir))
+              {
+                valid = valid && verifier.run(node.getFunction());
+              }
+            }
+            else if (llvm::any_isa<const llvm::Module *>(ir))
+            {
+              valid = verifier.run(*llvm::any_cast<const llvm::Module *>(ir));
+            }
+            if (!valid)
+            {
+              failedPass = passName.str();
+            }
+          });
+    }
 
-    // 最適化パスは現在無効化（リンクエラーを避けるため）
-    // 将来的にはLLVMの最適化パスを適用予定
+    // 新しいパスマネージャー: 解析マネージャーを相互に登録してから標準パイプラインを組む
+    llvm::LoopAnalysisManager loopAnalyses;
+    llvm::FunctionAnalysisManager functionAnalyses;
+    llvm::CGSCCAnalysisManager cgsccAnalyses;
+    llvm::ModuleAnalysisManager moduleAnalyses;
+    llvm::PassBuilder passBuilder(nullptr, llvm::PipelineTuningOptions(), llvm::None, &instrumentation);
+    passBuilder.registerModuleAnalyses(moduleAnalyses);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalyses);
+    passBuilder.registerFunctionAnalyses(functionAnalyses);
+    passBuilder.registerLoopAnalyses(loopAnalyses);
+    passBuilder.crossRegisterProxies(loopAnalyses, functionAnalyses, cgsccAnalyses, moduleAnalyses);
+
+    llvm::ModulePassManager passes = passBuilder.buildPerModuleDefaultPipeline(level);
+    passes.run(*module_, moduleAnalyses);
+    if (!failedPass.empty())
+    {
+      reportVerifyFailure(verifier.failure(), failedPass + " の後");
+      return false;
+    }
 
-    std::cout << "最適化パス適用完了（スキップ）" << std::endl;
+    size_t instructionCount = 0;
+    for (const llvm::Function &func : *module_)
+    {
+      instructionCount += func.getInstructionCount();
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    *log_ << "最適化パス適用完了: " << instructionCount << " 命令, "
+              << elapsed.count() / 1000.0 << " ms" << std::endl;
+    return true;
   }
 } // namespace asmtowasm
@@ -1,256 +1,956 @@
 #include "assembly_parser.h"
-#include <fstream>
-#include <sstream>
+#include "line_scanner.h"
+#include "mapped_file.h"
+#include "parse_cache.h"
 #include <algorithm>
-#include <cctype>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 namespace asmtowasm
 {
 
-  AssemblyParser::AssemblyParser()
+  AssemblyParser::AssemblyParser() : log_(&std::cout)
   {
     instructions_.clear();
     labels_.clear();
     errorMessage_.clear();
   }
 
+  namespace
+  {
+    bool isBlank(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    bool isDigit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    // 文字リテラル: 'a', '\n' など
+    bool parseCharLiteral(std::string_view text, int64_t &value)
+    {
+      if (text.size() == 3 && text[2] == '\'' && text[1] != '\\')
+      {
+        value = static_cast<unsigned char>(text[1]);
+        return true;
+      }
+      if (text.size() == 4 && text[1] == '\\' && text[3] == '\'')
+      {
+        switch (text[2])
+        {
+        case 'n':
+          value = '\n';
+          return true;
+        case 't':
+          value = '\t';
+          return true;
+        case 'r':
+          value = '\r';
+          return true;
+        case '0':
+          value = 0;
+          return true;
+        case '\\':
+        case '\'':
+          value = text[2];
+          return true;
+        default:
+          return false;
+        }
+      }
+      return false;
+    }
+
+    // 整数リテラル: 10, -5, 0x1A, 0b101, 'a'（符号は先頭のみ）
+    // 64ビットに収まらない値（正は2^64-1、負は-2^63まで）は失敗し、overflowがあればtrueにする
+    bool parseInteger(std::string_view text, int64_t &value, bool *overflow = nullptr)
+    {
+      if (text.empty())
+      {
+        return false;
+      }
+      if (text[0] == '\'')
+      {
+        return parseCharLiteral(text, value);
+      }
+
+      bool negative = false;
+      if (text[0] == '-' || text[0] == '+')
+      {
+        negative = text[0] == '-';
+        text.remove_prefix(1);
+      }
+
+      unsigned base = 10;
+      if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+      {
+        base = 16;
+        text.remove_prefix(2);
+      }
+      else if (text.size() > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B'))
+      {
+        base = 2;
+        text.remove_prefix(2);
+      }
+      if (text.empty())
+      {
+        return false;
+      }
+
+      uint64_t magnitude = 0;
+      for (char c : text)
+      {
+        unsigned digit;
+        if (isDigit(c))
+        {
+          digit = static_cast<unsigned>(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+          digit = static_cast<unsigned>(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+          digit = static_cast<unsigned>(c - 'A' + 10);
+        }
+        else
+        {
+          return false;
+        }
+        if (digit >= base)
+        {
+          return false;
+        }
+        if (magnitude > (UINT64_MAX - digit) / base)
+        {
+          if (overflow)
+          {
+            *overflow = true;
+          }
+          return false;
+        }
+        magnitude = magnitude * base + digit;
+      }
+      if (negative && magnitude > (uint64_t(1) << 63))
+      {
+        if (overflow)
+        {
+          *overflow = true;
+        }
+        return false;
+      }
+
+      value = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+      return true;
+    }
+  }
+
   bool AssemblyParser::parseFile(const std::string &filename)
   {
-    std::ifstream file(filename);
-    if (!file.is_open())
+    MappedFile file;
+    if (!file.open(filename, errorMessage_))
     {
-      errorMessage_ = "ファイルを開けませんでした: " + filename;
       return false;
     }
 
-    std::string line;
-    size_t lineNumber = 0;
+    if (cacheDirectory_.empty())
+    {
+      return parseBuffer(file.data(), file.size());
+    }
 
-    while (std::getline(file, line))
+    // 同じ内容のソースはキャッシュしたイメージから復元
+    ParseCache cache(cacheDirectory_);
+    const uint64_t sourceHash = ParseCache::hashSource(file.data(), file.size());
     {
-      lineNumber++;
-      if (!parseLine(line))
+      InstructionTable table;
+      LabelTable labels;
+      if (cache.load(sourceHash, file.size(), table, labels))
       {
-        errorMessage_ = "行 " + std::to_string(lineNumber) + " でエラー: " + errorMessage_;
-        return false;
+        *log_ << "パースキャッシュを使用: " << cache.imagePath(sourceHash) << std::endl;
+        appendParsed(std::move(table), labels);
+        return true;
       }
     }
 
-    file.close();
+    // キャッシュがなければこのファイルだけをパースして保存
+    AssemblyParser fileParser;
+    fileParser.threadCount_ = threadCount_;
+    fileParser.log_ = log_;
+    if (!fileParser.parseBuffer(file.data(), file.size()))
+    {
+      errorMessage_ = fileParser.errorMessage_;
+      appendParsed(std::move(fileParser.instructions_), fileParser.labels_);
+      return false;
+    }
+
+    std::string cacheError;
+    if (cache.store(sourceHash, file.size(), fileParser.instructions_, fileParser.labels_, cacheError))
+    {
+      *log_ << "パースキャッシュを保存: " << cache.imagePath(sourceHash) << std::endl;
+    }
+    else
+    {
+      *log_ << "警告: " << cacheError << std::endl;
+    }
+    appendParsed(std::move(fileParser.instructions_), fileParser.labels_);
     return true;
   }
 
   bool AssemblyParser::parseString(const std::string &assemblyCode)
   {
-    std::istringstream stream(assemblyCode);
-    std::string line;
+    return parseBuffer(assemblyCode.data(), assemblyCode.size());
+  }
+
+  bool AssemblyParser::parseBuffer(const char *data, size_t size)
+  {
+    unsigned threadCount = threadCount_ != 0 ? threadCount_ : std::thread::hardware_concurrency();
+    if (threadCount > 1 && size >= kParallelParseThreshold)
+    {
+      return parseBufferParallel(data, size, threadCount);
+    }
+
     size_t lineNumber = 0;
+    if (!parseLines(data, size, lineNumber))
+    {
+      errorMessage_ = "行 " + std::to_string(lineNumber) + " でエラー: " + errorMessage_;
+      return false;
+    }
+    return true;
+  }
 
-    while (std::getline(stream, line))
+  bool AssemblyParser::feed(std::string_view chunk)
+  {
+    while (!chunk.empty())
     {
-      lineNumber++;
-      if (!parseLine(line))
+      size_t newline = chunk.find('\n');
+      if (newline == std::string_view::npos)
+      {
+        // 行の残りは次のチャンクまで保持
+        pendingLine_.append(chunk.data(), chunk.size());
+        return true;
+      }
+
+      std::string_view line = chunk.substr(0, newline);
+      chunk.remove_prefix(newline + 1);
+
+      streamLineNumber_++;
+      bool ok;
+      if (pendingLine_.empty())
+      {
+        ok = parseLine(line);
+      }
+      else
+      {
+        pendingLine_.append(line.data(), line.size());
+        ok = parseLine(pendingLine_);
+        pendingLine_.clear();
+      }
+
+      if (!ok)
       {
-        errorMessage_ = "行 " + std::to_string(lineNumber) + " でエラー: " + errorMessage_;
+        errorMessage_ = "行 " + std::to_string(streamLineNumber_) + " でエラー: " + errorMessage_;
         return false;
       }
+      flushToCallback();
     }
-
     return true;
   }
 
-  bool AssemblyParser::parseLine(const std::string &line)
+  bool AssemblyParser::finish()
   {
-    // コメントを除去
-    std::string cleanLine = removeComments(line);
+    if (!pendingLine_.empty())
+    {
+      streamLineNumber_++;
+      bool ok = parseLine(pendingLine_);
+      pendingLine_.clear();
+      if (!ok)
+      {
+        errorMessage_ = "行 " + std::to_string(streamLineNumber_) + " でエラー: " + errorMessage_;
+        return false;
+      }
+      flushToCallback();
+    }
+    return true;
+  }
 
-    // トリム
-    cleanLine = trim(cleanLine);
+  bool AssemblyParser::loadDocument(std::string_view text)
+  {
+    instructions_.clear();
+    labels_.clear();
+    lineRecords_.clear();
+    callCounts_.clear();
+    emittedCount_ = 0;
+    incremental_ = true;
+    return applyEdit(0, 0, text);
+  }
 
-    // 空行をスキップ
-    if (cleanLine.empty())
+  bool AssemblyParser::applyEdit(size_t startLine, size_t removedCount, std::string_view newText,
+                                 std::vector<FunctionRange> *changedFunctions)
+  {
+    if (!incremental_ || callback_)
     {
-      return true;
+      errorMessage_ = "増分パースはloadDocument()で開始し、コールバックなしで使用してください";
+      return false;
+    }
+    if (startLine > lineRecords_.size() || removedCount > lineRecords_.size() - startLine)
+    {
+      errorMessage_ = "編集範囲が文書の行数を超えています";
+      return false;
+    }
+    if (changedFunctions)
+    {
+      changedFunctions->clear();
     }
 
-    std::istringstream iss(cleanLine);
-    std::string token;
-    std::vector<std::string> tokens;
+    // 新しい行だけを別のパーサーでパース（失敗したら文書は変更しない）
+    AssemblyParser lineParser;
+    lineParser.log_ = log_;
+    std::vector<LineRecord> newRecords;
+    while (!newText.empty())
+    {
+      const size_t newline = newText.find('\n');
+      const std::string_view line = newText.substr(0, newline);
+      newText.remove_prefix(newline == std::string_view::npos ? newText.size() : newline + 1);
 
-    // トークンに分割
-    while (iss >> token)
+      const size_t before = lineParser.instructions_.size();
+      if (!lineParser.parseLine(line))
+      {
+        errorMessage_ = "行 " + std::to_string(startLine + newRecords.size() + 1) + " でエラー: " + lineParser.errorMessage_;
+        return false;
+      }
+      LineRecord record;
+      record.hasInstruction = lineParser.instructions_.size() > before;
+      if (record.hasInstruction)
+      {
+        record.labelId = lineParser.instructions_[before].labelId();
+      }
+      newRecords.push_back(record);
+    }
+    const InstructionTable &inserted = lineParser.instructions_;
+
+    // 編集範囲に対応する命令範囲
+    size_t first = 0;
+    for (size_t i = 0; i < startLine; ++i)
     {
-      tokens.push_back(token);
+      first += lineRecords_[i].hasInstruction ? 1 : 0;
+    }
+    size_t removed = 0;
+    std::vector<uint32_t> removedLabels;
+    for (size_t i = startLine; i < startLine + removedCount; ++i)
+    {
+      removed += lineRecords_[i].hasInstruction ? 1 : 0;
+      if (lineRecords_[i].labelId != SymbolTable::kNone)
+      {
+        removedLabels.push_back(lineRecords_[i].labelId);
+      }
     }
 
-    if (tokens.empty())
+    // 命令が変わらない編集（コメントや空白だけの変更）は行の記録だけを差し替える
+    if (removed == inserted.size() && instructions_.rangeEquals(first, inserted))
     {
+      for (size_t i = 0; i < newRecords.size(); ++i)
+      {
+        if (newRecords[i].labelId != SymbolTable::kNone)
+        {
+          newRecords[i].labelId = instructions_.symbols().find(inserted.symbolName(newRecords[i].labelId));
+        }
+      }
+      lineRecords_.erase(lineRecords_.begin() + startLine, lineRecords_.begin() + startLine + removedCount);
+      lineRecords_.insert(lineRecords_.begin() + startLine, newRecords.begin(), newRecords.end());
+      *log_ << "増分パース: 行 " << startLine + 1 << " の編集で命令は変化しませんでした" << std::endl;
       return true;
     }
 
-    // ラベルかどうかチェック
-    std::string firstToken = tokens[0];
-    if (firstToken.back() == ':')
+    std::vector<FunctionRange> oldFunctions;
+    if (changedFunctions)
     {
-      // ラベル
-      std::string labelName = firstToken.substr(0, firstToken.length() - 1);
-      labels_[labelName] = instructions_.size();
-      std::cout << "ラベル " << labelName << " を検出しました。トークン数: " << tokens.size() << std::endl;
+      oldFunctions = getFunctionRanges();
+    }
+
+    // 削除する命令のCALL先とラベル定義を外す
+    countCalls(first, removed, -1);
+    for (uint32_t labelId : removedLabels)
+    {
+      const size_t target = labels_.find(labelId);
+      if (target >= first && target < first + removed)
+      {
+        labels_.undefine(labelId);
+      }
+    }
 
-      // ラベルの後に命令があるかチェック
-      if (tokens.size() > 1)
+    // 命令を差し替え、後続の命令を指すラベルをずらす
+    const std::vector<uint32_t> remap = instructions_.replaceRange(first, removed, inserted);
+    const ptrdiff_t delta = static_cast<ptrdiff_t>(inserted.size()) - static_cast<ptrdiff_t>(removed);
+    labels_.shiftFrom(first + removed, delta);
+    countCalls(first, inserted.size(), 1);
+
+    // 新しい行のラベルを定義（同名のラベルは後ろの定義が優先）
+    size_t index = first;
+    for (LineRecord &record : newRecords)
+    {
+      if (record.labelId != SymbolTable::kNone)
       {
-        InstructionType type = parseInstructionType(tokens[1]);
-        if (type == InstructionType::UNKNOWN)
+        record.labelId = remap[record.labelId];
+        if (!labels_.contains(record.labelId) || labels_.find(record.labelId) < index)
         {
-          errorMessage_ = "不明な命令: " + tokens[1];
-          return false;
+          labels_.define(record.labelId, index);
+        }
+      }
+      index += record.hasInstruction ? 1 : 0;
+    }
+    lineRecords_.erase(lineRecords_.begin() + startLine, lineRecords_.begin() + startLine + removedCount);
+    lineRecords_.insert(lineRecords_.begin() + startLine, newRecords.begin(), newRecords.end());
+
+    // 削除したラベルが他の行でも定義されていれば、その定義に戻す
+    for (uint32_t labelId : removedLabels)
+    {
+      if (labels_.contains(labelId))
+      {
+        continue;
+      }
+      size_t lineIndex = 0;
+      for (const LineRecord &record : lineRecords_)
+      {
+        if (record.labelId == labelId)
+        {
+          labels_.define(labelId, lineIndex);
         }
+        lineIndex += record.hasInstruction ? 1 : 0;
+      }
+    }
 
-        Instruction inst(type);
-        inst.label = labelName;
+    *log_ << "増分パース: 行 " << startLine + 1 << " から " << removedCount << " 行を " << newRecords.size()
+          << " 行で置き換え（命令 " << removed << " -> " << inserted.size() << "）" << std::endl;
 
-        // オペランドを解析
-        for (size_t i = 2; i < tokens.size(); ++i)
+    if (changedFunctions)
+    {
+      // 編集範囲の外にあり、ずれただけの関数は変化なしとみなす
+      std::unordered_map<uint32_t, FunctionRange> oldBySymbol;
+      for (const FunctionRange &range : oldFunctions)
+      {
+        oldBySymbol[range.symbol] = range;
+      }
+      for (const FunctionRange &range : getFunctionRanges())
+      {
+        auto it = oldBySymbol.find(range.symbol);
+        bool unchanged = false;
+        if (it != oldBySymbol.end())
+        {
+          const FunctionRange &old = it->second;
+          unchanged = (old.end <= first && range.begin == old.begin && range.end == old.end) ||
+                      (old.begin >= first + removed && range.begin == old.begin + delta && range.end == old.end + delta);
+          oldBySymbol.erase(it);
+        }
+        if (!unchanged)
         {
-          inst.operands.push_back(parseOperand(tokens[i]));
+          changedFunctions->push_back(range);
         }
+      }
+      for (auto &entry : oldBySymbol)
+      {
+        entry.second.removed = true;
+        changedFunctions->push_back(entry.second);
+      }
+    }
+    return true;
+  }
 
-        instructions_.push_back(inst);
+  std::vector<FunctionRange> AssemblyParser::getFunctionRanges() const
+  {
+    // 増分パース中でなければCALL先をその場で数える
+    std::vector<uint32_t> scannedCalls;
+    const std::vector<uint32_t> *calls = &callCounts_;
+    if (!incremental_)
+    {
+      scannedCalls.assign(instructions_.symbols().size(), 0);
+      for (InstructionView inst : instructions_)
+      {
+        OperandSpan operands = inst.operands();
+        if (inst.type() == InstructionType::CALL && operands.size() == 1 && operands[0].type == OperandType::LABEL)
+        {
+          scannedCalls[operands[0].symbol]++;
+        }
       }
-      else
+      calls = &scannedCalls;
+    }
+
+    // 関数の開始位置: mainまたはCALL先のラベル
+    const uint32_t mainSymbol = instructions_.symbols().find("main");
+    std::vector<std::pair<size_t, uint32_t>> starts;
+    labels_.forEach([&](uint32_t symbol, size_t index)
+                    {
+                      if (symbol == mainSymbol || (symbol < calls->size() && (*calls)[symbol] > 0))
+                      {
+                        starts.emplace_back(index, symbol);
+                      }
+                    });
+    std::sort(starts.begin(), starts.end());
+
+    std::vector<FunctionRange> ranges;
+    const size_t total = instructions_.size();
+    if (total > 0 && (starts.empty() || starts.front().first > 0))
+    {
+      FunctionRange range;
+      range.end = starts.empty() ? total : starts.front().first;
+      ranges.push_back(range);
+    }
+    for (size_t i = 0; i < starts.size(); ++i)
+    {
+      FunctionRange range;
+      range.symbol = starts[i].second;
+      range.begin = starts[i].first;
+      range.end = i + 1 < starts.size() ? starts[i + 1].first : total;
+      ranges.push_back(range);
+    }
+    return ranges;
+  }
+
+  void AssemblyParser::countCalls(size_t first, size_t count, int delta)
+  {
+    callCounts_.resize(instructions_.symbols().size(), 0);
+    for (size_t i = first; i < first + count; ++i)
+    {
+      InstructionView inst = instructions_[i];
+      OperandSpan operands = inst.operands();
+      if (inst.type() == InstructionType::CALL && operands.size() == 1 && operands[0].type == OperandType::LABEL)
       {
-        // 単独のラベルの場合、LABEL命令を作成
-        Instruction labelInst(InstructionType::LABEL);
-        labelInst.label = labelName;
-        instructions_.push_back(labelInst);
-        std::cout << "単独のラベル " << labelName << " を処理しました" << std::endl;
+        callCounts_[operands[0].symbol] += delta;
       }
     }
+  }
+
+  void AssemblyParser::appendParsed(InstructionTable &&table, const LabelTable &labels)
+  {
+    const size_t base = nextInstructionIndex();
+    std::vector<uint32_t> remap;
+    if (instructions_.empty() && instructions_.symbols().size() == 0)
+    {
+      // 記号表ごと引き継ぐので記号IDはそのまま
+      instructions_ = std::move(table);
+    }
     else
     {
-      // 通常の命令
-      InstructionType type = parseInstructionType(firstToken);
-      if (type == InstructionType::UNKNOWN)
+      remap = instructions_.appendTable(table);
+    }
+    labels.forEach([&](uint32_t symbol, size_t index)
+                   { labels_.define(remap.empty() ? symbol : remap[symbol], base + index); });
+    flushToCallback();
+  }
+
+  void AssemblyParser::flushToCallback()
+  {
+    if (!callback_)
+    {
+      return;
+    }
+    for (InstructionView inst : instructions_)
+    {
+      callback_(inst);
+    }
+    emittedCount_ += instructions_.size();
+    instructions_.clearInstructions();
+  }
+
+  bool AssemblyParser::parseLines(const char *data, size_t size, size_t &lineNumber)
+  {
+    LineScanner scanner(data, size);
+    while (scanner.nextLine(tokens_))
+    {
+      lineNumber++;
+      if (!parseTokens())
       {
-        errorMessage_ = "不明な命令: " + firstToken;
         return false;
       }
+      flushToCallback();
+    }
 
-      Instruction inst(type);
+    return true;
+  }
 
-      // オペランドを解析
-      for (size_t i = 1; i < tokens.size(); ++i)
+  bool AssemblyParser::parseBufferParallel(const char *data, size_t size, unsigned threadCount)
+  {
+    // 負荷の偏りを均すため、スレッド数より細かく行境界で分割
+    const size_t chunkCount = static_cast<size_t>(threadCount) * 4;
+    std::vector<std::pair<const char *, size_t>> chunks;
+    const char *end = data + size;
+    const char *cursor = data;
+    for (size_t i = 1; i <= chunkCount && cursor < end; ++i)
+    {
+      const char *split = i == chunkCount ? end : data + size / chunkCount * i;
+      if (split < cursor)
+      {
+        split = cursor;
+      }
+      if (split < end)
       {
-        inst.operands.push_back(parseOperand(tokens[i]));
+        const char *newline = static_cast<const char *>(std::memchr(split, '\n', end - split));
+        split = newline ? newline + 1 : end;
       }
+      chunks.emplace_back(cursor, static_cast<size_t>(split - cursor));
+      cursor = split;
+    }
 
-      instructions_.push_back(inst);
+    // チャンクごとの命令テーブル
+    struct ChunkResult
+    {
+      AssemblyParser parser;
+      std::ostringstream log;
+      size_t lineCount = 0;
+      bool ok = true;
+    };
+    std::vector<std::unique_ptr<ChunkResult>> results;
+    results.reserve(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+      results.push_back(std::make_unique<ChunkResult>());
+      results.back()->parser.log_ = &results.back()->log;
     }
 
+    // ワーカーが未処理のチャンクを順に取り出してパース
+    std::atomic<size_t> nextChunk{0};
+    auto worker = [&]()
+    {
+      for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+      {
+        ChunkResult &result = *results[i];
+        result.ok = result.parser.parseLines(chunks[i].first, chunks[i].second, result.lineCount);
+      }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threadCount && t < chunks.size(); ++t)
+    {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : workers)
+    {
+      thread.join();
+    }
+
+    // チャンク順に結合し、ラベルの命令インデックスを再配置（逐次パースと同じ結果）
+    size_t lineOffset = 0;
+    for (auto &result : results)
+    {
+      *log_ << result->log.str();
+
+      appendParsed(std::move(result->parser.instructions_), result->parser.labels_);
+
+      // エラー行までの状態も逐次パースと一致させる
+      if (!result->ok)
+      {
+        errorMessage_ = "行 " + std::to_string(lineOffset + result->lineCount) + " でエラー: " + result->parser.errorMessage_;
+        return false;
+      }
+      lineOffset += result->lineCount;
+    }
+
+    return true;
+  }
+
+  bool AssemblyParser::parseLine(std::string_view line)
+  {
+    LineScanner scanner(line.data(), line.size());
+    scanner.nextLine(tokens_);
+    return parseTokens();
+  }
+
+  bool AssemblyParser::parseTokens()
+  {
+    // 空行・コメントのみの行をスキップ
+    if (tokens_.empty())
+    {
+      return true;
+    }
+
+    // ラベルかどうかチェック
+    std::string_view firstToken = tokens_[0];
+    uint32_t labelId = SymbolTable::kNone;
+    size_t mnemonicToken = 0;
+    if (firstToken.back() == ':')
+    {
+      // ラベル
+      std::string_view labelName = firstToken.substr(0, firstToken.length() - 1);
+      labelId = instructions_.symbols().intern(labelName);
+      labels_.define(labelId, nextInstructionIndex());
+      *log_ << "ラベル " << labelName << " を検出しました。トークン数: " << tokens_.size() << std::endl;
+
+      if (tokens_.size() == 1)
+      {
+        // 単独のラベルの場合、LABEL命令を作成
+        instructions_.append(InstructionType::LABEL, labelId, nullptr, 0);
+        *log_ << "単独のラベル " << labelName << " を処理しました" << std::endl;
+        return true;
+      }
+      mnemonicToken = 1;
+    }
+
+    // 命令（ラベルの後に続く場合も含む）
+    InstructionType type = parseInstructionType(tokens_[mnemonicToken]);
+    if (type == InstructionType::UNKNOWN)
+    {
+      errorMessage_ = "不明な命令: " + std::string(tokens_[mnemonicToken]);
+      return false;
+    }
+
+    // オペランドを解析
+    if (!parseOperands(mnemonicToken + 1))
+    {
+      return false;
+    }
+
+    instructions_.append(type, labelId, operandScratch_.data(), operandScratch_.size());
     return true;
   }
 
-  InstructionType AssemblyParser::parseInstructionType(const std::string &instruction)
+  InstructionType AssemblyParser::parseInstructionType(std::string_view instruction)
   {
-    std::string upper = instruction;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-
-    if (upper == "ADD")
-      return InstructionType::ADD;
-    if (upper == "SUB")
-      return InstructionType::SUB;
-    if (upper == "MUL")
-      return InstructionType::MUL;
-    if (upper == "DIV")
-      return InstructionType::DIV;
-    if (upper == "MOV")
-      return InstructionType::MOV;
-    if (upper == "CMP")
-      return InstructionType::CMP;
-    if (upper == "JMP")
-      return InstructionType::JMP;
-    if (upper == "JE")
-      return InstructionType::JE;
-    if (upper == "JZ") // alias of JE
-      return InstructionType::JE;
-    if (upper == "JNE")
-      return InstructionType::JNE;
-    if (upper == "JNZ") // alias of JNE
-      return InstructionType::JNE;
-    if (upper == "JL")
-      return InstructionType::JL;
-    if (upper == "JG")
-      return InstructionType::JG;
-    if (upper == "JLE")
-      return InstructionType::JLE;
-    if (upper == "JGE")
-      return InstructionType::JGE;
-    if (upper == "CALL")
-      return InstructionType::CALL;
-    if (upper == "RET")
-      return InstructionType::RET;
-    if (upper == "PUSH")
-      return InstructionType::PUSH;
-    if (upper == "POP")
-      return InstructionType::POP;
-
-    return InstructionType::UNKNOWN;
+    return decodeMnemonic(instruction);
   }
 
-  Operand AssemblyParser::parseOperand(const std::string &operand)
+  bool AssemblyParser::parseOperand(std::string_view text, Operand &operand)
   {
-    std::string trimmed = trim(operand);
+    std::string_view trimmed = trim(text);
 
     // カンマを除去
     if (!trimmed.empty() && trimmed.back() == ',')
     {
-      trimmed = trimmed.substr(0, trimmed.length() - 1);
+      trimmed.remove_suffix(1);
     }
 
     // レジスタかどうかチェック
     if (trimmed.length() >= 2 && trimmed[0] == '%')
     {
-      return Operand(OperandType::REGISTER, trimmed);
+      operand.type = OperandType::REGISTER;
+      operand.reg = decodeRegister(trimmed);
+      if (operand.reg == RegisterId::NONE)
+      {
+        errorMessage_ = "不明なレジスタ: " + std::string(trimmed);
+        return false;
+      }
+      return true;
     }
 
-    // メモリアドレスかどうかチェック
-    if (trimmed.length() >= 3 && trimmed[0] == '(' && trimmed.back() == ')')
+    // メモリアドレスかどうかチェック: (式) と、AT&Tの 変位(%base,%index,scale)
+    const size_t open = trimmed.find('(');
+    if (open != std::string_view::npos && trimmed.length() >= open + 3 && trimmed.back() == ')')
     {
-      return Operand(OperandType::MEMORY, trimmed);
+      operand.type = OperandType::MEMORY;
+      if (!parseMemoryOperand(trimmed.substr(open + 1, trimmed.length() - open - 2), operand.memory))
+      {
+        return false;
+      }
+      if (open > 0)
+      {
+        int64_t displacement = 0;
+        bool overflow = false;
+        if (!parseInteger(trim(trimmed.substr(0, open)), displacement, &overflow))
+        {
+          errorMessage_ = (overflow ? "変位が64ビットに収まりません: " : "不正な変位: ") + std::string(trimmed);
+          return false;
+        }
+        // 括弧内の変位と同じく64ビットのビット列として足す（和の桁あふれで未定義動作にしない）
+        operand.memory.displacement = static_cast<int64_t>(static_cast<uint64_t>(operand.memory.displacement) +
+                                                           static_cast<uint64_t>(displacement));
+      }
+      return true;
     }
 
-    // 数値かどうかチェック
-    if (std::all_of(trimmed.begin(), trimmed.end(), [](char c)
-                    { return std::isdigit(c) || c == '-' || c == '+'; }))
+    // 数値かどうかチェック（AT&Tの$接頭辞も受け付ける）
+    std::string_view number = trimmed;
+    if (!number.empty() && number[0] == '$')
+    {
+      number.remove_prefix(1);
+    }
+    if (!number.empty() &&
+        (isDigit(number[0]) || number[0] == '\'' ||
+         ((number[0] == '-' || number[0] == '+') && number.size() > 1 && isDigit(number[1]))))
     {
-      return Operand(OperandType::IMMEDIATE, trimmed);
+      operand.type = OperandType::IMMEDIATE;
+      bool overflow = false;
+      if (!parseInteger(number, operand.immediate, &overflow))
+      {
+        errorMessage_ = (overflow ? "即値が64ビットに収まりません: " : "不正な即値: ") + std::string(trimmed);
+        return false;
+      }
+      return true;
     }
 
     // それ以外はラベルとして扱う
-    return Operand(OperandType::LABEL, trimmed);
+    operand.type = OperandType::LABEL;
+    operand.symbol = instructions_.symbols().intern(trimmed);
+    return true;
+  }
+
+  bool AssemblyParser::parseMemoryOperand(std::string_view text, MemoryOperand &memory)
+  {
+    // AT&Tの %base,%index,scale（baseは省略可、scaleの既定は1）
+    if (text.find(',') != std::string_view::npos)
+    {
+      std::string_view parts[3];
+      size_t count = 0;
+      for (size_t pos = 0;;)
+      {
+        const size_t comma = text.find(',', pos);
+        if (count == 3)
+        {
+          errorMessage_ = "メモリオペランドの項が多すぎます: (" + std::string(text) + ")";
+          return false;
+        }
+        parts[count++] = trim(text.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos));
+        if (comma == std::string_view::npos)
+        {
+          break;
+        }
+        pos = comma + 1;
+      }
+
+      if (!parts[0].empty())
+      {
+        memory.base = decodeRegister(parts[0]);
+        if (memory.base == RegisterId::NONE)
+        {
+          errorMessage_ = "不正なメモリオペランドのレジスタ: (" + std::string(text) + ")";
+          return false;
+        }
+      }
+      memory.index = decodeRegister(parts[1]);
+      if (memory.index == RegisterId::NONE)
+      {
+        errorMessage_ = "不正なメモリオペランドのレジスタ: (" + std::string(text) + ")";
+        return false;
+      }
+      int64_t scale = 1;
+      if (count == 3 && (!parseInteger(parts[2], scale) || (scale != 1 && scale != 2 && scale != 4 && scale != 8)))
+      {
+        errorMessage_ = "不正なスケール: (" + std::string(text) + ")";
+        return false;
+      }
+      memory.scale = static_cast<uint8_t>(scale);
+      return true;
+    }
+
+    // 項を+/-で区切って解析: %base, %index*scale, 変位（負の変位も可）
+    bool hasTerm = false;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+      while (pos < text.size() && isBlank(text[pos]))
+      {
+        ++pos;
+      }
+      bool negative = false;
+      if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+      {
+        negative = text[pos] == '-';
+        ++pos;
+      }
+
+      size_t next = text.find_first_of("+-", pos);
+      std::string_view term = trim(text.substr(pos, next == std::string_view::npos ? std::string_view::npos : next - pos));
+      if (term.empty())
+      {
+        errorMessage_ = "不正なメモリオペランド: (" + std::string(text) + ")";
+        return false;
+      }
+      hasTerm = true;
+
+      if (term[0] == '%')
+      {
+        size_t star = term.find('*');
+        RegisterId reg = decodeRegister(trim(term.substr(0, star)));
+        if (reg == RegisterId::NONE || negative)
+        {
+          errorMessage_ = "不正なメモリオペランドのレジスタ: (" + std::string(text) + ")";
+          return false;
+        }
+
+        int64_t scale = 1;
+        if (star != std::string_view::npos)
+        {
+          if (!parseInteger(trim(term.substr(star + 1)), scale) ||
+              (scale != 1 && scale != 2 && scale != 4 && scale != 8))
+          {
+            errorMessage_ = "不正なスケール: (" + std::string(text) + ")";
+            return false;
+          }
+        }
+
+        if (memory.base == RegisterId::NONE && star == std::string_view::npos)
+        {
+          memory.base = reg;
+        }
+        else if (memory.index == RegisterId::NONE)
+        {
+          memory.index = reg;
+          memory.scale = static_cast<uint8_t>(scale);
+        }
+        else
+        {
+          errorMessage_ = "メモリオペランドのレジスタが多すぎます: (" + std::string(text) + ")";
+          return false;
+        }
+      }
+      else
+      {
+        int64_t displacement = 0;
+        bool overflow = false;
+        if (!parseInteger(term, displacement, &overflow))
+        {
+          errorMessage_ = (overflow ? "変位が64ビットに収まりません: (" : "不正な変位: (") + std::string(text) + ")";
+          return false;
+        }
+        // 変位は64ビットのビット列として足す（-2^63の符号反転や和の桁あふれで未定義動作にしない）
+        const uint64_t term64 = static_cast<uint64_t>(displacement);
+        memory.displacement = static_cast<int64_t>(static_cast<uint64_t>(memory.displacement) +
+                                                   (negative ? 0 - term64 : term64));
+      }
+
+      pos = next == std::string_view::npos ? text.size() : next;
+    }
+
+    if (!hasTerm)
+    {
+      errorMessage_ = "空のメモリオペランド";
+      return false;
+    }
+    return true;
   }
 
-  std::string AssemblyParser::trim(const std::string &str)
+  bool AssemblyParser::parseOperands(size_t firstToken)
   {
-    size_t first = str.find_first_not_of(' ');
-    if (first == std::string::npos)
+    operandScratch_.clear();
+    for (size_t i = firstToken; i < tokens_.size(); ++i)
     {
-      return "";
+      Operand operand;
+      if (!parseOperand(tokens_[i], operand))
+      {
+        return false;
+      }
+      operandScratch_.push_back(operand);
     }
-    size_t last = str.find_last_not_of(' ');
-    return str.substr(first, (last - first + 1));
+    return true;
   }
 
-  std::string AssemblyParser::removeComments(const std::string &line)
+  std::string_view AssemblyParser::trim(std::string_view str)
   {
-    size_t commentPos = line.find('#');
-    if (commentPos != std::string::npos)
+    size_t first = 0;
+    while (first < str.size() && isBlank(str[first]))
+    {
+      ++first;
+    }
+    size_t last = str.size();
+    while (last > first && isBlank(str[last - 1]))
     {
-      return line.substr(0, commentPos);
+      --last;
     }
-    return line;
+    return str.substr(first, last - first);
   }
 
 } // namespace asmtowasm
@@ -0,0 +1,328 @@
+#include "calling_convention.h"
+#include <algorithm>
+
+namespace asmtowasm
+{
+
+  namespace
+  {
+    // 16/8ビットのサブレジスタへの書き込みは格納先の他のビットを残すので、格納先を読むことにもなる
+    // （32ビットレジスタへの書き込みは上位32ビットを0にするので、格納先全体の定義）
+    RegisterMask partialWriteUses(RegisterId reg)
+    {
+      return registerAlias(reg).bits < 32 ? registerBit(reg) : 0;
+    }
+
+    constexpr RegisterMask kResultRegister = registerBit(RegisterId::EAX); // RETのオペランドを返すレジスタ
+    // スタックポインタは関数間で共有するグローバルに置くので、引数や戻り値として受け渡さない
+    constexpr RegisterMask kStackPointerRegister = registerBit(RegisterId::ESP);
+  }
+
+  std::vector<CallingConvention> CallingConventionAnalysis::run(const std::vector<FunctionRange> &ranges,
+                                                                const std::vector<FunctionCfg> &graphs,
+                                                                uint32_t mainSymbol)
+  {
+    mainSymbol_ = mainSymbol;
+    const size_t functionCount = table_.symbols().size() + 1;
+    conventions_.assign(functionCount, CallingConvention());
+    demanded_.assign(functionCount, 0);
+
+    // 関数ごとの範囲と呼び出し関係、関数自身が書き換えるレジスタを集める
+    std::vector<std::vector<size_t>> rangesOf(functionCount);
+    std::vector<std::vector<uint32_t>> callers(functionCount);
+    std::vector<std::vector<uint32_t>> callees(functionCount);
+    std::vector<RegisterMask> clobbers(functionCount, 0);
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+      const uint32_t symbol = ranges[r].symbol;
+      rangesOf[symbol].push_back(r);
+      for (const CfgBlock &block : graphs[r].blocks)
+      {
+        for (size_t i = block.begin; i < block.end && block.reachable; ++i)
+        {
+          InstructionView inst = table_[i];
+          const uint32_t callee = callTarget(inst);
+          if (callee != SymbolTable::kNone)
+          {
+            // mainの呼び出しは呼び出し元のレジスタに影響しない
+            if (callee != mainSymbol_)
+            {
+              callees[symbol].push_back(callee);
+              callers[callee].push_back(symbol);
+            }
+            continue;
+          }
+          clobbers[symbol] |= effectOf(inst).defs;
+          if (inst.type() == InstructionType::RET && !inst.operands().empty() && symbol != mainSymbol_)
+          {
+            clobbers[symbol] |= kResultRegister;
+          }
+        }
+      }
+    }
+
+    // 書き換えうるレジスタを呼び出し先から呼び出し元へ伝える（増えた関数の呼び出し元だけを調べ直す）
+    std::vector<uint32_t> worklist;
+    std::vector<bool> queued(functionCount, false);
+    auto enqueue = [&](uint32_t symbol)
+    {
+      if (!queued[symbol] && !rangesOf[symbol].empty())
+      {
+        queued[symbol] = true;
+        worklist.push_back(symbol);
+      }
+    };
+    for (const FunctionRange &range : ranges)
+    {
+      enqueue(range.symbol);
+    }
+    while (!worklist.empty())
+    {
+      const uint32_t symbol = worklist.back();
+      worklist.pop_back();
+      queued[symbol] = false;
+      RegisterMask clobbered = clobbers[symbol];
+      for (uint32_t callee : callees[symbol])
+      {
+        clobbered |= clobbers[callee];
+      }
+      if (clobbered != clobbers[symbol])
+      {
+        clobbers[symbol] = clobbered;
+        for (uint32_t caller : callers[symbol])
+        {
+          enqueue(caller);
+        }
+      }
+    }
+    for (size_t symbol = 0; symbol < functionCount; ++symbol)
+    {
+      if (symbol != mainSymbol_)
+      {
+        conventions_[symbol].clobbers = clobbers[symbol];
+      }
+    }
+
+    // 生存区間の不動点: 引数が増えたら呼び出し元を、戻り値が増えたらその関数を調べ直す
+    // （呼び出し元が先に並ぶことが多いので、命令順に先頭から処理する）
+    for (const FunctionRange &range : ranges)
+    {
+      enqueue(range.symbol);
+    }
+    std::reverse(worklist.begin(), worklist.end());
+    std::vector<uint32_t> changedCallees;
+    while (!worklist.empty())
+    {
+      const uint32_t symbol = worklist.back();
+      worklist.pop_back();
+      queued[symbol] = false;
+
+      RegisterMask entryLive = 0;
+      changedCallees.clear();
+      for (size_t r : rangesOf[symbol])
+      {
+        entryLive |= analyzeRange(ranges[r], graphs[r], symbol, changedCallees);
+      }
+      for (uint32_t callee : changedCallees)
+      {
+        enqueue(callee);
+      }
+      CallingConvention &convention = conventions_[symbol];
+      if (symbol != mainSymbol_ && (entryLive & ~convention.params) != 0)
+      {
+        convention.params |= entryLive;
+        for (uint32_t caller : callers[symbol])
+        {
+          enqueue(caller);
+        }
+      }
+    }
+
+    return std::move(conventions_);
+  }
+
+  RegisterMask CallingConventionAnalysis::analyzeRange(const FunctionRange &range, const FunctionCfg &graph,
+                                                       uint32_t symbol, std::vector<uint32_t> &changedCallees)
+  {
+    const RegisterMask exitLive = conventions_[symbol].results;
+    const RegisterMask retDefs = symbol != mainSymbol_ ? kResultRegister : 0;
+    live_.assign(range.end - range.begin, 0);
+    liveOut_.assign(graph.blocks.size(), 0);
+
+    // 命令の後での生存レジスタ（ブロックの末尾では後続ブロックの入口の和）
+    auto liveAfter = [&](const CfgBlock &block, size_t index)
+    {
+      return index + 1 < block.end ? live_[index + 1 - range.begin] : liveOut_[&block - graph.blocks.data()];
+    };
+
+    // 到達するブロックを後ろから流し、ループの後方ジャンプで変わらなくなるまで繰り返す
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (size_t b = graph.blocks.size(); b-- > 0;)
+      {
+        const CfgBlock &block = graph.blocks[b];
+        if (!block.reachable)
+        {
+          continue;
+        }
+        RegisterMask out = 0;
+        block.forEachSuccessor([&](uint32_t successor)
+                               { out |= successor == CfgBlock::kExit ? exitLive
+                                                                     : live_[graph.blocks[successor].begin - range.begin]; });
+        liveOut_[b] = out;
+
+        for (size_t i = block.end; i-- > block.begin;)
+        {
+          InstructionView inst = table_[i];
+          OperandSpan operands = inst.operands();
+          RegisterMask live = 0;
+          switch (inst.type())
+          {
+          case InstructionType::RET:
+            live = operands.empty() ? exitLive : operandUses(operands[0]) | (exitLive & ~retDefs);
+            break;
+          case InstructionType::CALL:
+          {
+            // ラベル以外への呼び出しはリフトできないので、レジスタに影響しないものとして扱う
+            const uint32_t target = callTarget(inst);
+            const CallingConvention unknown;
+            const CallingConvention &callee = target != SymbolTable::kNone ? conventions_[target] : unknown;
+            live = (liveAfter(block, i) & ~callee.clobbers) | callee.params;
+            break;
+          }
+          default:
+          {
+            // ジャンプの後続はブロックの出口の辺に含まれる
+            const RegisterEffect effect = effectOf(inst);
+            live = effect.uses | (liveAfter(block, i) & ~effect.defs);
+            break;
+          }
+          }
+          RegisterMask &slot = live_[i - range.begin];
+          if (live != slot)
+          {
+            slot = live;
+            changed = true;
+          }
+        }
+      }
+    }
+
+    // 呼び出し後に生きているレジスタを呼び出し先へ要求する
+    for (const CfgBlock &block : graph.blocks)
+    {
+      for (size_t i = block.begin; i < block.end && block.reachable; ++i)
+      {
+        const uint32_t callee = callTarget(table_[i]);
+        if (callee == SymbolTable::kNone || callee == mainSymbol_)
+        {
+          continue;
+        }
+        const RegisterMask after = liveAfter(block, i);
+        if ((after & ~demanded_[callee]) == 0)
+        {
+          continue;
+        }
+        demanded_[callee] |= after;
+        const RegisterMask results = conventions_[callee].clobbers & demanded_[callee];
+        if (results != conventions_[callee].results)
+        {
+          conventions_[callee].results = results;
+          changedCallees.push_back(callee);
+        }
+      }
+    }
+
+    return live_.front();
+  }
+
+  CallingConventionAnalysis::RegisterEffect CallingConventionAnalysis::effectOf(InstructionView inst)
+  {
+    RegisterEffect effect;
+    OperandSpan operands = inst.operands();
+    switch (inst.type())
+    {
+    case InstructionType::ADD:
+    case InstructionType::SUB:
+    case InstructionType::MUL:
+    case InstructionType::DIV:
+      if (operands.size() >= 2)
+      {
+        effect.uses = operandUses(operands[0]) | operandUses(operands[1]);
+        if (operands[0].type == OperandType::REGISTER)
+        {
+          effect.defs = registerBit(operands[0].reg);
+        }
+      }
+      break;
+    case InstructionType::MOV:
+      if (operands.size() == 2)
+      {
+        // MOV dst, src: メモリへの転送はアドレスのレジスタとソースを読むだけ
+        effect.uses = operandUses(operands[0]) | operandUses(operands[1]);
+        if (operands[0].type == OperandType::REGISTER)
+        {
+          effect.uses = operandUses(operands[1]) | partialWriteUses(operands[0].reg);
+          effect.defs = registerBit(operands[0].reg);
+        }
+      }
+      break;
+    case InstructionType::CMP:
+      for (const Operand &operand : operands)
+      {
+        effect.uses |= operandUses(operand);
+      }
+      break;
+    case InstructionType::PUSH:
+      if (operands.size() == 1)
+      {
+        effect.uses = operandUses(operands[0]);
+      }
+      break;
+    case InstructionType::POP:
+      if (operands.size() == 1 && operands[0].type == OperandType::REGISTER)
+      {
+        effect.uses = partialWriteUses(operands[0].reg);
+        effect.defs = registerBit(operands[0].reg);
+      }
+      break;
+    case InstructionType::RET:
+      if (!operands.empty())
+      {
+        effect.uses = operandUses(operands[0]);
+      }
+      break;
+    default:
+      break;
+    }
+    effect.uses &= ~kStackPointerRegister;
+    effect.defs &= ~kStackPointerRegister;
+    return effect;
+  }
+
+  RegisterMask CallingConventionAnalysis::operandUses(const Operand &operand)
+  {
+    switch (operand.type)
+    {
+    case OperandType::REGISTER:
+      return registerBit(operand.reg) & ~kStackPointerRegister;
+    case OperandType::MEMORY:
+      return (registerBit(operand.memory.base) | registerBit(operand.memory.index)) & ~kStackPointerRegister;
+    default:
+      return 0;
+    }
+  }
+
+  uint32_t CallingConventionAnalysis::callTarget(InstructionView inst)
+  {
+    OperandSpan operands = inst.operands();
+    if (inst.type() != InstructionType::CALL || operands.size() != 1 || operands[0].type != OperandType::LABEL)
+    {
+      return SymbolTable::kNone;
+    }
+    return operands[0].symbol;
+  }
+
+} // namespace asmtowasm
@@ -0,0 +1,124 @@
+#include "control_flow.h"
+
+namespace asmtowasm
+{
+
+  std::vector<FunctionCfg> ControlFlowAnalysis::run(const std::vector<FunctionRange> &ranges)
+  {
+    std::vector<FunctionCfg> graphs;
+    graphs.reserve(ranges.size());
+    for (const FunctionRange &range : ranges)
+    {
+      graphs.push_back(build(range));
+    }
+    return graphs;
+  }
+
+  FunctionCfg ControlFlowAnalysis::build(const FunctionRange &range)
+  {
+    FunctionCfg graph;
+    const size_t length = range.end - range.begin;
+    blockOf_.assign(length + 1, CfgBlock::kNone);
+
+    // リーダーに印を付ける（範囲の終わりは番兵）
+    std::vector<bool> leader(length + 1, false);
+    leader[0] = true;
+    leader[length] = true;
+    for (size_t i = range.begin; i < range.end; ++i)
+    {
+      InstructionView inst = table_[i];
+      // ラベルの再定義は後勝ちなので、範囲内の後ろにもう一度定義されていれば重複（関数ラベル自身は除く）
+      if (inst.hasLabel() && !(i == range.begin && inst.labelId() == range.symbol) &&
+          graph.duplicateLabel == SymbolTable::kNone)
+      {
+        const size_t defined = labels_.find(inst.labelId());
+        if (defined != i && defined >= range.begin && defined < range.end)
+        {
+          graph.duplicateLabel = inst.labelId();
+        }
+      }
+      if (!endsBlock(inst.type()))
+      {
+        continue;
+      }
+      leader[i + 1 - range.begin] = true;
+      if (inst.type() != InstructionType::RET)
+      {
+        leader[jumpTarget(range, inst) - range.begin] = true;
+      }
+    }
+
+    // ブロックを切り出す
+    for (size_t offset = 0; offset < length; ++offset)
+    {
+      if (leader[offset])
+      {
+        blockOf_[offset] = static_cast<uint32_t>(graph.blocks.size());
+        CfgBlock block;
+        block.begin = range.begin + offset;
+        graph.blocks.push_back(block);
+      }
+      graph.blocks.back().end = range.begin + offset + 1;
+    }
+    blockOf_[length] = CfgBlock::kExit;
+
+    // 辺を張る（ブロックの末尾の命令で決まる）
+    for (CfgBlock &block : graph.blocks)
+    {
+      InstructionView last = table_[block.end - 1];
+      if (last.type() == InstructionType::RET)
+      {
+        continue;
+      }
+      if (endsBlock(last.type()))
+      {
+        block.taken = blockOf_[jumpTarget(range, last) - range.begin];
+      }
+      if (last.type() != InstructionType::JMP)
+      {
+        block.fallthrough = blockOf_[block.end - range.begin];
+      }
+    }
+
+    // 入口から到達するブロックに印を付け、到達するブロックからの辺だけを数える
+    std::vector<uint32_t> worklist{0};
+    graph.blocks[0].reachable = true;
+    while (!worklist.empty())
+    {
+      const CfgBlock &block = graph.blocks[worklist.back()];
+      worklist.pop_back();
+      block.forEachSuccessor([&](uint32_t successor)
+                             {
+                               if (successor == CfgBlock::kExit)
+                               {
+                                 return;
+                               }
+                               CfgBlock &target = graph.blocks[successor];
+                               ++target.predecessors;
+                               if (!target.reachable)
+                               {
+                                 target.reachable = true;
+                                 worklist.push_back(successor);
+                               }
+                             });
+    }
+    return graph;
+  }
+
+  size_t ControlFlowAnalysis::jumpTarget(const FunctionRange &range, InstructionView inst) const
+  {
+    OperandSpan operands = inst.operands();
+    if (operands.size() != 1 || operands[0].type != OperandType::LABEL)
+    {
+      return range.end;
+    }
+    const size_t target = labels_.find(operands[0].symbol);
+    if (target == LabelTable::kUndefined || target < range.begin || target >= range.end ||
+        (target == range.begin && operands[0].symbol == range.symbol))
+    {
+      return range.end;
+    }
+    return target;
+  }
+
+} // namespace asmtowasm
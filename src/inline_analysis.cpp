@@ -0,0 +1,94 @@
+#include "inline_analysis.h"
+
+namespace asmtowasm
+{
+
+  std::vector<InlineBody> InlineAnalysis::run(const std::vector<FunctionRange> &ranges,
+                                              const std::vector<FunctionCfg> &graphs, uint32_t mainSymbol)
+  {
+    const size_t functionCount = table_.symbols().size() + 1;
+    std::vector<InlineBody> bodies(functionCount);
+    std::vector<uint32_t> rangeCount(functionCount, 0);
+    std::vector<bool> leaf(functionCount, false);
+
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+      const uint32_t symbol = ranges[r].symbol;
+      ++rangeCount[symbol];
+      leaf[symbol] = extractBody(ranges[r], graphs[r], bodies[symbol]);
+
+      // 呼び出し回数は到達するブロックのCALLだけを数える
+      for (const CfgBlock &block : graphs[r].blocks)
+      {
+        for (size_t i = block.begin; i < block.end && block.reachable; ++i)
+        {
+          InstructionView inst = table_[i];
+          if (inst.type() == InstructionType::CALL && inst.operands().size() == 1 &&
+              inst.operands()[0].type == OperandType::LABEL)
+          {
+            ++bodies[inst.operands()[0].symbol].callSites;
+          }
+        }
+      }
+    }
+
+    for (size_t symbol = 0; symbol < functionCount; ++symbol)
+    {
+      InlineBody &body = bodies[symbol];
+      if (!leaf[symbol] || rangeCount[symbol] != 1 || symbol == mainSymbol || body.callSites == 0)
+      {
+        continue;
+      }
+      body.inlined = body.size <= kAlwaysInlineSize || body.size * body.callSites <= kGrowthBudget;
+    }
+    return bodies;
+  }
+
+  bool InlineAnalysis::extractBody(const FunctionRange &range, const FunctionCfg &graph, InlineBody &body) const
+  {
+    if (graph.duplicateLabel != SymbolTable::kNone)
+    {
+      return false;
+    }
+    for (size_t b = 1; b < graph.blocks.size(); ++b)
+    {
+      if (graph.blocks[b].reachable)
+      {
+        return false;
+      }
+    }
+
+    // 入口のブロックはオペランドのないRETで戻るか、範囲の終わりへ落ちる
+    const CfgBlock &entry = graph.blocks.front();
+    InstructionView last = table_[entry.end - 1];
+    body.begin = range.begin;
+    body.end = entry.end;
+    if (last.type() == InstructionType::RET && last.operands().empty())
+    {
+      --body.end;
+    }
+    else if (endsBlock(last.type()) || entry.fallthrough != CfgBlock::kExit)
+    {
+      return false;
+    }
+
+    body.size = 0;
+    for (size_t i = body.begin; i < body.end; ++i)
+    {
+      switch (table_[i].type())
+      {
+      case InstructionType::CALL:
+      case InstructionType::PUSH:
+      case InstructionType::POP:
+        return false;
+      case InstructionType::LABEL:
+        break;
+      default:
+        ++body.size;
+        break;
+      }
+    }
+    return true;
+  }
+
+} // namespace asmtowasm
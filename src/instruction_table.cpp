@@ -0,0 +1,170 @@
+#include "instruction_table.h"
+
+namespace asmtowasm
+{
+
+  void InstructionTable::append(InstructionType type, uint32_t labelId, const Operand *operands, size_t operandCount)
+  {
+    types_.push_back(type);
+    labelIds_.push_back(labelId);
+    operands_.insert(operands_.end(), operands, operands + operandCount);
+    operandBegin_.push_back(static_cast<uint32_t>(operands_.size()));
+  }
+
+  std::vector<uint32_t> InstructionTable::appendTable(const InstructionTable &other)
+  {
+    return replaceRange(size(), 0, other);
+  }
+
+  std::vector<uint32_t> InstructionTable::replaceRange(size_t first, size_t count, const InstructionTable &other)
+  {
+    // 相手の記号IDをこのテーブルの記号IDへ変換する表
+    std::vector<uint32_t> remap(other.symbols_.size());
+    for (uint32_t id = 0; id < remap.size(); ++id)
+    {
+      remap[id] = symbols_.intern(other.symbols_.name(id));
+    }
+
+    const size_t last = first + count;
+    const uint32_t operandFirst = operandBegin_[first];
+    const uint32_t operandLast = operandBegin_[last];
+
+    // 命令の列
+    types_.erase(types_.begin() + first, types_.begin() + last);
+    types_.insert(types_.begin() + first, other.types_.begin(), other.types_.end());
+    labelIds_.erase(labelIds_.begin() + first, labelIds_.begin() + last);
+    labelIds_.insert(labelIds_.begin() + first, other.labelIds_.size(), SymbolTable::kNone);
+    for (size_t i = 0; i < other.labelIds_.size(); ++i)
+    {
+      const uint32_t labelId = other.labelIds_[i];
+      labelIds_[first + i] = labelId == SymbolTable::kNone ? labelId : remap[labelId];
+    }
+
+    // オペランド
+    operands_.erase(operands_.begin() + operandFirst, operands_.begin() + operandLast);
+    operands_.insert(operands_.begin() + operandFirst, other.operands_.begin(), other.operands_.end());
+    for (size_t i = 0; i < other.operands_.size(); ++i)
+    {
+      Operand &operand = operands_[operandFirst + i];
+      if (operand.symbol != SymbolTable::kNone)
+      {
+        operand.symbol = remap[operand.symbol];
+      }
+    }
+
+    // オペランド範囲: 置き換えた命令は相手の範囲を、後続の命令は増減分をずらす
+    operandBegin_.erase(operandBegin_.begin() + first + 1, operandBegin_.begin() + last + 1);
+    operandBegin_.insert(operandBegin_.begin() + first + 1, other.operandBegin_.begin() + 1, other.operandBegin_.end());
+    const size_t inserted = other.size();
+    for (size_t i = first + 1; i <= first + inserted; ++i)
+    {
+      operandBegin_[i] += operandFirst;
+    }
+    const int64_t operandDelta = static_cast<int64_t>(other.operands_.size()) - (operandLast - operandFirst);
+    if (operandDelta != 0)
+    {
+      for (size_t i = first + inserted + 1; i < operandBegin_.size(); ++i)
+      {
+        operandBegin_[i] = static_cast<uint32_t>(operandBegin_[i] + operandDelta);
+      }
+    }
+    return remap;
+  }
+
+  bool InstructionTable::rangeEquals(size_t first, const InstructionTable &other) const
+  {
+    if (first + other.size() > size())
+    {
+      return false;
+    }
+
+    auto sameSymbol = [&](uint32_t lhs, uint32_t rhs)
+    {
+      if (lhs == SymbolTable::kNone || rhs == SymbolTable::kNone)
+      {
+        return lhs == rhs;
+      }
+      return symbolName(lhs) == other.symbolName(rhs);
+    };
+
+    for (size_t i = 0; i < other.size(); ++i)
+    {
+      InstructionView lhs = (*this)[first + i];
+      InstructionView rhs = other[i];
+      if (lhs.type() != rhs.type() || !sameSymbol(lhs.labelId(), rhs.labelId()) ||
+          lhs.operands().size() != rhs.operands().size())
+      {
+        return false;
+      }
+      for (size_t k = 0; k < lhs.operands().size(); ++k)
+      {
+        const Operand &a = lhs.operands()[k];
+        const Operand &b = rhs.operands()[k];
+        if (a.type != b.type || a.reg != b.reg || a.immediate != b.immediate ||
+            a.memory.base != b.memory.base || a.memory.index != b.memory.index ||
+            a.memory.scale != b.memory.scale || a.memory.displacement != b.memory.displacement ||
+            !sameSymbol(a.symbol, b.symbol))
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void InstructionTable::clearInstructions()
+  {
+    types_.clear();
+    labelIds_.clear();
+    operands_.clear();
+    operandBegin_.assign(1, 0);
+  }
+
+  void InstructionTable::clear()
+  {
+    clearInstructions();
+    symbols_.clear();
+  }
+
+  std::string InstructionTable::formatOperand(const Operand &operand) const
+  {
+    switch (operand.type)
+    {
+    case OperandType::REGISTER:
+      return registerName(operand.reg);
+    case OperandType::IMMEDIATE:
+      return std::to_string(operand.immediate);
+    case OperandType::MEMORY:
+    {
+      const MemoryOperand &mem = operand.memory;
+      std::string text = "(";
+      if (mem.base != RegisterId::NONE)
+      {
+        text += registerName(mem.base);
+      }
+      if (mem.index != RegisterId::NONE)
+      {
+        if (text.size() > 1)
+        {
+          text += "+";
+        }
+        text += registerName(mem.index);
+        text += "*" + std::to_string(mem.scale);
+      }
+      if (mem.displacement != 0 || text.size() == 1)
+      {
+        if (text.size() > 1 && mem.displacement >= 0)
+        {
+          text += "+";
+        }
+        text += std::to_string(mem.displacement);
+      }
+      return text + ")";
+    }
+    case OperandType::LABEL:
+      return operand.symbol != SymbolTable::kNone ? std::string(symbolName(operand.symbol)) : std::string();
+    }
+    return std::string();
+  }
+
+} // namespace asmtowasm
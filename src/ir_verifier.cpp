@@ -0,0 +1,110 @@
+#include "ir_verifier.h"
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  namespace
+  {
+    // 上限を超える文字列は行の切れ目で切り、省略したバイト数を添える
+    void truncate(std::string &text)
+    {
+      if (text.size() <= IrVerifier::kDumpLimit)
+      {
+        return;
+      }
+      size_t cut = text.rfind('\n', IrVerifier::kDumpLimit);
+      cut = cut == std::string::npos ? IrVerifier::kDumpLimit : cut + 1;
+      const size_t omitted = text.size() - cut;
+      text.resize(cut);
+      text += "... (残り " + std::to_string(omitted) + " バイトを省略)\n";
+    }
+  } // namespace
+
+  bool IrVerifier::run(const llvm::Module &module)
+  {
+    std::vector<const llvm::Function *> functions;
+    size_t instructionCount = 0;
+    for (const llvm::Function &func : module)
+    {
+      if (!func.isDeclaration())
+      {
+        functions.push_back(&func);
+        instructionCount += func.getInstructionCount();
+      }
+    }
+
+    // 関数ごとの診断（妥当な関数は空）
+    std::vector<std::string> messages(functions.size());
+    std::vector<char> broken(functions.size(), 0);
+    std::atomic<size_t> nextFunction{0};
+    auto worker = [&]()
+    {
+      for (size_t i = nextFunction++; i < functions.size(); i = nextFunction++)
+      {
+        llvm::raw_string_ostream stream(messages[i]);
+        broken[i] = llvm::verifyFunction(*functions[i], &stream);
+      }
+    };
+
+    unsigned threadCount = threadCount_ != 0 ? threadCount_ : std::thread::hardware_concurrency();
+    if (instructionCount < kParallelThreshold)
+    {
+      threadCount = 1;
+    }
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threadCount && t < functions.size(); ++t)
+    {
+      workers.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : workers)
+    {
+      thread.join();
+    }
+
+    const auto first = std::find(broken.begin(), broken.end(), 1);
+    if (first == broken.end())
+    {
+      return true;
+    }
+    const size_t index = static_cast<size_t>(first - broken.begin());
+    recordFailure(*functions[index], std::move(messages[index]));
+    return false;
+  }
+
+  bool IrVerifier::run(const llvm::Function &func)
+  {
+    if (func.isDeclaration())
+    {
+      return true;
+    }
+    std::string message;
+    llvm::raw_string_ostream stream(message);
+    if (!llvm::verifyFunction(func, &stream))
+    {
+      return true;
+    }
+    stream.flush();
+    recordFailure(func, std::move(message));
+    return false;
+  }
+
+  void IrVerifier::recordFailure(const llvm::Function &func, std::string message)
+  {
+    failure_.function = func.getName().str();
+    failure_.message = std::move(message);
+    truncate(failure_.message);
+    failure_.dump.clear();
+    llvm::raw_string_ostream stream(failure_.dump);
+    func.print(stream);
+    stream.flush();
+    truncate(failure_.dump);
+  }
+
+} // namespace asmtowasm
@@ -0,0 +1,423 @@
+#include "line_scanner.h"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define ASMTOWASM_X86_SIMD 1
+#endif
+
+namespace asmtowasm
+{
+
+  namespace
+  {
+    enum ByteClass : uint8_t
+    {
+      kNewline = 1 << 0,
+      kComment = 1 << 1,
+      kBlank = 1 << 2,
+      kComma = 1 << 3,
+      kParen = 1 << 4,
+      kQuote = 1 << 5
+    };
+
+    constexpr std::array<uint8_t, 256> makeClassTable()
+    {
+      std::array<uint8_t, 256> table{};
+      table['\n'] = kNewline;
+      table['#'] = kComment;
+      table[' '] = kBlank;
+      table['\t'] = kBlank;
+      table['\r'] = kBlank;
+      table['\v'] = kBlank;
+      table['\f'] = kBlank;
+      table[','] = kComma;
+      table['('] = kParen;
+      table[')'] = kParen;
+      table['\''] = kQuote;
+      return table;
+    }
+
+    constexpr std::array<uint8_t, 256> kClassTable = makeClassTable();
+
+    // スカラー版（SIMDが使えない環境用。ベンチマークではSIMD版と比べる）
+    void classifyScalar(const char *block, BlockMasks &masks)
+    {
+      masks = BlockMasks();
+      for (size_t i = 0; i < LineScanner::kBlockSize; ++i)
+      {
+        const uint8_t cls = kClassTable[static_cast<unsigned char>(block[i])];
+        if (cls == 0)
+        {
+          continue;
+        }
+        const uint64_t bit = uint64_t(1) << i;
+        masks.newline |= (cls & kNewline) ? bit : 0;
+        masks.comment |= (cls & kComment) ? bit : 0;
+        masks.blank |= (cls & kBlank) ? bit : 0;
+        masks.comma |= (cls & kComma) ? bit : 0;
+        masks.paren |= (cls & kParen) ? bit : 0;
+        masks.quote |= (cls & kQuote) ? bit : 0;
+      }
+    }
+
+#ifdef ASMTOWASM_X86_SIMD
+    // SSE2版: 16バイトずつ比較して4回で64ビットのマスクを作る
+    void classifySse2(const char *block, BlockMasks &masks)
+    {
+      masks = BlockMasks();
+      const __m128i newline = _mm_set1_epi8('\n');
+      const __m128i comment = _mm_set1_epi8('#');
+      const __m128i space = _mm_set1_epi8(' ');
+      const __m128i tab = _mm_set1_epi8('\t');
+      const __m128i cr = _mm_set1_epi8('\r');
+      const __m128i vt = _mm_set1_epi8('\v');
+      const __m128i ff = _mm_set1_epi8('\f');
+      const __m128i comma = _mm_set1_epi8(',');
+      const __m128i open = _mm_set1_epi8('(');
+      const __m128i close = _mm_set1_epi8(')');
+      const __m128i quote = _mm_set1_epi8('\'');
+
+      for (int part = 0; part < 4; ++part)
+      {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + part * 16));
+        const __m128i blank = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, vt)), _mm_cmpeq_epi8(v, ff)));
+        const __m128i paren = _mm_or_si128(_mm_cmpeq_epi8(v, open), _mm_cmpeq_epi8(v, close));
+        const int shift = part * 16;
+        masks.newline |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)))) << shift;
+        masks.comment |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, comment)))) << shift;
+        masks.blank |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(blank))) << shift;
+        masks.comma |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)))) << shift;
+        masks.paren |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(paren))) << shift;
+        masks.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+      }
+    }
+
+    // AVX2版: 32バイトずつ比較して2回で64ビットのマスクを作る
+    __attribute__((target("avx2"))) void classifyAvx2(const char *block, BlockMasks &masks)
+    {
+      masks = BlockMasks();
+      const __m256i newline = _mm256_set1_epi8('\n');
+      const __m256i comment = _mm256_set1_epi8('#');
+      const __m256i space = _mm256_set1_epi8(' ');
+      const __m256i tab = _mm256_set1_epi8('\t');
+      const __m256i cr = _mm256_set1_epi8('\r');
+      const __m256i vt = _mm256_set1_epi8('\v');
+      const __m256i ff = _mm256_set1_epi8('\f');
+      const __m256i comma = _mm256_set1_epi8(',');
+      const __m256i open = _mm256_set1_epi8('(');
+      const __m256i close = _mm256_set1_epi8(')');
+      const __m256i quote = _mm256_set1_epi8('\'');
+
+      for (int part = 0; part < 2; ++part)
+      {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + part * 32));
+        const __m256i blank = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, vt)), _mm256_cmpeq_epi8(v, ff)));
+        const __m256i paren = _mm256_or_si256(_mm256_cmpeq_epi8(v, open), _mm256_cmpeq_epi8(v, close));
+        const int shift = part * 32;
+        masks.newline |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)))) << shift;
+        masks.comment |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, comment)))) << shift;
+        masks.blank |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(blank))) << shift;
+        masks.comma |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, comma)))) << shift;
+        masks.paren |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(paren))) << shift;
+        masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+      }
+    }
+#endif
+
+    using ClassifyFunction = void (*)(const char *, BlockMasks &);
+
+    struct Kernel
+    {
+      ClassifyFunction classify;
+      const char *name;
+    };
+
+    // CPUの対応状況を見て一度だけ選択
+    Kernel selectKernel()
+    {
+#ifdef ASMTOWASM_X86_SIMD
+#if defined(__GNUC__)
+      if (__builtin_cpu_supports("avx2"))
+      {
+        return {classifyAvx2, "avx2"};
+      }
+#endif
+      return {classifySse2, "sse2"};
+#else
+      return {classifyScalar, "scalar"};
+#endif
+    }
+
+    Kernel &kernel()
+    {
+      static Kernel selected = selectKernel();
+      return selected;
+    }
+
+    // iビット目以上が立ったマスク（i >= 64なら0）
+    uint64_t bitsFrom(size_t i)
+    {
+      return i >= LineScanner::kBlockSize ? 0 : ~uint64_t(0) << i;
+    }
+
+    size_t countTrailingZeros(uint64_t value)
+    {
+#if defined(__GNUC__)
+      return static_cast<size_t>(__builtin_ctzll(value));
+#else
+      size_t count = 0;
+      while ((value & 1) == 0)
+      {
+        value >>= 1;
+        ++count;
+      }
+      return count;
+#endif
+    }
+  }
+
+  LineScanner::LineScanner(const char *data, size_t size) : data_(data), size_(size)
+  {
+  }
+
+  const char *LineScanner::kernelName()
+  {
+    return kernel().name;
+  }
+
+  bool LineScanner::useKernel(std::string_view name)
+  {
+    if (name == "scalar")
+    {
+      kernel() = {classifyScalar, "scalar"};
+      return true;
+    }
+#ifdef ASMTOWASM_X86_SIMD
+    if (name == "sse2")
+    {
+      kernel() = {classifySse2, "sse2"};
+      return true;
+    }
+#if defined(__GNUC__)
+    if (name == "avx2" && __builtin_cpu_supports("avx2"))
+    {
+      kernel() = {classifyAvx2, "avx2"};
+      return true;
+    }
+#endif
+#endif
+    return false;
+  }
+
+  void LineScanner::classifyBlock(const char *block, BlockMasks &masks)
+  {
+    kernel().classify(block, masks);
+  }
+
+  void LineScanner::scanBlock(size_t block)
+  {
+    const size_t offset = block * kBlockSize;
+    BlockMasks masks;
+    uint64_t valid = ~uint64_t(0);
+    if (offset + kBlockSize <= size_)
+    {
+      classifyBlock(data_ + offset, masks);
+    }
+    else
+    {
+      // 末尾の端数ブロックはゼロ埋めしてから分類し、範囲外は区切り扱い
+      char tail[kBlockSize] = {};
+      std::memcpy(tail, data_ + offset, size_ - offset);
+      classifyBlock(tail, masks);
+      valid = bitsFrom(0) & ~bitsFrom(size_ - offset);
+    }
+
+    const uint64_t newline = masks.newline & valid;
+    uint64_t separator = masks.blank | masks.comma;
+
+    // 前ブロックから続く文字リテラルの残り
+    uint64_t literal = ~bitsFrom(literalCarry_);
+    size_t first = literalCarry_;
+    literalCarry_ = 0;
+
+    // コメント（'#'から改行の手前まで）と文字リテラルを先頭から順に決める
+    // （コメント内の'\''はリテラルを始めず、リテラル内の'#'はコメントを始めない）
+    uint64_t comment = 0;
+    const uint64_t quote = masks.quote & valid;
+    if (inComment_ || ((masks.comment & valid) | quote) != 0)
+    {
+      size_t i = first;
+      while (i < kBlockSize)
+      {
+        if (inComment_)
+        {
+          const uint64_t next = newline & bitsFrom(i);
+          const size_t end = next != 0 ? countTrailingZeros(next) : kBlockSize;
+          comment |= bitsFrom(i) & ~bitsFrom(end);
+          if (next == 0)
+          {
+            break;
+          }
+          inComment_ = false;
+          i = end;
+        }
+        else
+        {
+          const uint64_t next = ((masks.comment & valid) | quote) & bitsFrom(i);
+          if (next == 0)
+          {
+            break;
+          }
+          i = countTrailingZeros(next);
+          if (((quote >> i) & 1) == 0)
+          {
+            inComment_ = true;
+            continue;
+          }
+          const size_t length = literalLength(offset + i);
+          if (length == 0)
+          {
+            ++i;
+            continue;
+          }
+          const size_t end = i + length;
+          literal |= bitsFrom(i) & ~bitsFrom(end);
+          if (end > kBlockSize)
+          {
+            literalCarry_ = end - kBlockSize;
+          }
+          i = end;
+        }
+      }
+    }
+    separator &= ~literal;
+
+    // 括弧内の区切りを消す（括弧はまれなので、ある場合だけビットを順に辿る）
+    const uint64_t paren = masks.paren & valid & ~comment & ~literal;
+    if (depth_ > 0 || paren != 0)
+    {
+      size_t nestStart = 0;
+      uint64_t events = paren | newline;
+      while (events != 0)
+      {
+        const size_t i = countTrailingZeros(events);
+        events &= events - 1;
+        if ((newline >> i) & 1)
+        {
+          if (depth_ > 0)
+          {
+            separator &= ~(bitsFrom(nestStart) & ~bitsFrom(i));
+          }
+          depth_ = 0;
+        }
+        else if (data_[offset + i] == '(')
+        {
+          if (depth_++ == 0)
+          {
+            nestStart = i;
+          }
+        }
+        else if (depth_ > 0 && --depth_ == 0)
+        {
+          separator &= ~(bitsFrom(nestStart) & ~bitsFrom(i));
+        }
+      }
+      if (depth_ > 0)
+      {
+        // 括弧が次のブロックへ続く
+        separator &= ~bitsFrom(nestStart);
+      }
+    }
+
+    // トークンを構成するバイトの立ち上がり・立ち下がりが開始・終了
+    const uint64_t token = ~(separator | newline | comment) & valid;
+    const uint64_t shifted = (token << 1) | (prevTokenByte_ ? 1 : 0);
+    starts_ = token & ~shifted;
+    ends_ = ~token & shifted;
+    newline_ = newline;
+    prevTokenByte_ = (token >> 63) != 0;
+    block_ = block;
+  }
+
+  size_t LineScanner::literalLength(size_t pos) const
+  {
+    // 'x'（x は改行と'\\'以外）か '\x'（x は改行以外）
+    if (pos + 2 < size_ && data_[pos + 1] != '\\' && data_[pos + 1] != '\n' && data_[pos + 2] == '\'')
+    {
+      return 3;
+    }
+    if (pos + 3 < size_ && data_[pos + 1] == '\\' && data_[pos + 2] != '\n' && data_[pos + 3] == '\'')
+    {
+      return 4;
+    }
+    return 0;
+  }
+
+  bool LineScanner::nextLine(std::vector<std::string_view> &tokens)
+  {
+    tokens.clear();
+    if (pos_ >= size_)
+    {
+      return false;
+    }
+
+    while (pos_ < size_)
+    {
+      const size_t block = pos_ / kBlockSize;
+      if (block != block_)
+      {
+        scanBlock(block);
+      }
+
+      // このブロック内の行の範囲（改行位置のトークン終了も含める）
+      const size_t base = block * kBlockSize;
+      const uint64_t lineEnd = newline_ & bitsFrom(pos_ - base);
+      const size_t limit = lineEnd != 0 ? countTrailingZeros(lineEnd) + 1 : kBlockSize;
+      uint64_t events = (starts_ | ends_) & bitsFrom(pos_ - base) & ~bitsFrom(limit);
+
+      // 開始と終了は交互に並ぶので、2ビットずつ取り出してトークンにする
+      if (tokenOpen_ && events != 0)
+      {
+        const size_t end = base + countTrailingZeros(events);
+        events &= events - 1;
+        tokens.emplace_back(data_ + tokenStart_, end - tokenStart_);
+        tokenOpen_ = false;
+      }
+      while (events != 0)
+      {
+        const size_t start = base + countTrailingZeros(events);
+        events &= events - 1;
+        if (events == 0)
+        {
+          tokenStart_ = start;
+          tokenOpen_ = true;
+          break;
+        }
+        const size_t end = base + countTrailingZeros(events);
+        events &= events - 1;
+        tokens.emplace_back(data_ + start, end - start);
+      }
+
+      pos_ = base + limit;
+      if (lineEnd != 0)
+      {
+        return true;
+      }
+    }
+
+    // 改行で終わらない最終行
+    if (tokenOpen_)
+    {
+      tokens.emplace_back(data_ + tokenStart_, size_ - tokenStart_);
+      tokenOpen_ = false;
+    }
+    return true;
+  }
+
+} // namespace asmtowasm
@@ -2,26 +2,86 @@
 #include "assembly_parser.h"
 #include "wasm_generator.h"
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <string_view>
 
 namespace
 {
   void printUsage(const char *programName)
   {
-    std::cout << "使用方法: " << programName << " [--wasm ファイル] [--wast ファイル] <入力ファイル>\n";
+    std::cout << "使用方法: " << programName << " [--wasm ファイル] [--wast ファイル] [オプション] <入力ファイル>\n";
     std::cout << "  --wasm <ファイル>  WebAssemblyバイナリを出力\n";
     std::cout << "  --wast <ファイル>  WebAssemblyテキストを出力\n";
+    std::cout << "  --parse-threads <N> 大きな入力のパースに使うスレッド数（0は自動、1は逐次）\n";
+    std::cout << "  --parse-cache <ディレクトリ> パース結果をキャッシュし、同じ内容の入力では再利用\n";
+    std::cout << "  --lift-threads <N> 関数の多い入力のリフトに使うスレッド数（0は自動、1は逐次）\n";
+    std::cout << "  -O0, -O1, -O2, -O3, -Os  LLVM IRの最適化レベル（既定は -O0）\n";
+    std::cout << "  --no-inline       小さな葉関数をCALLの位置へインライン展開しない\n";
+    std::cout << "  --verify=<none|final|each-pass> LLVM IRの検証（既定は final: Wasm生成の直前に一度）\n";
+    std::cout << "  --enable-tail-call 末尾呼び出しをreturn_callで出力（無効時は自己再帰の末尾呼び出しをループにする）\n";
     std::cout << "  -h, --help        このヘルプを表示\n";
     std::cout << "出力ファイルを指定しない場合、入力ファイル名から .wasm/.wat を自動生成します。\n";
+    std::cout << "入力ファイルに - を指定すると標準入力から読み込みます。\n";
+  }
+
+  // 入力ストリームをチャンク単位でパーサーへ流し込む
+  bool parseStream(std::istream &input, asmtowasm::AssemblyParser &parser)
+  {
+    char buffer[64 * 1024];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
+    {
+      if (!parser.feed(std::string_view(buffer, static_cast<size_t>(input.gcount()))))
+      {
+        return false;
+      }
+    }
+    return parser.finish();
   }
 
   std::string deriveOutputName(const std::string &inputFile, const std::string &extension)
   {
+    if (inputFile == "-")
+    {
+      return "stdin" + extension;
+    }
     const std::size_t dotPos = inputFile.find_last_of('.');
     const std::string base = (dotPos == std::string::npos) ? inputFile : inputFile.substr(0, dotPos);
     return base + extension;
   }
+
+  // -O0 … -O3、-Os を最適化レベルへ
+  bool parseOptimizationLevel(const std::string &arg, asmtowasm::OptimizationLevel &level)
+  {
+    if (arg == "-O0")
+      level = asmtowasm::OptimizationLevel::O0;
+    else if (arg == "-O1")
+      level = asmtowasm::OptimizationLevel::O1;
+    else if (arg == "-O2")
+      level = asmtowasm::OptimizationLevel::O2;
+    else if (arg == "-O3")
+      level = asmtowasm::OptimizationLevel::O3;
+    else if (arg == "-Os")
+      level = asmtowasm::OptimizationLevel::Os;
+    else
+      return false;
+    return true;
+  }
+
+  // --verify= の値を検証のタイミングへ
+  bool parseVerifyMode(const std::string &value, asmtowasm::VerifyMode &mode)
+  {
+    if (value == "none")
+      mode = asmtowasm::VerifyMode::None;
+    else if (value == "final")
+      mode = asmtowasm::VerifyMode::Final;
+    else if (value == "each-pass")
+      mode = asmtowasm::VerifyMode::EachPass;
+    else
+      return false;
+    return true;
+  }
 }
 
 int main(int argc, char *argv[])
@@ -35,6 +95,13 @@ int main(int argc, char *argv[])
   std::string inputFile;
   std::string wasmFile;
   std::string wastFile;
+  unsigned parseThreads = 0;
+  unsigned liftThreads = 0;
+  std::string parseCacheDir;
+  asmtowasm::OptimizationLevel optimizationLevel = asmtowasm::OptimizationLevel::O0;
+  bool tailCallEnabled = false;
+  bool inliningEnabled = true;
+  asmtowasm::VerifyMode verifyMode = asmtowasm::VerifyMode::Final;
 
   for (int i = 1; i < argc; ++i)
   {
@@ -62,7 +129,54 @@ int main(int argc, char *argv[])
       }
       wastFile = argv[++i];
     }
-    else if (!arg.empty() && arg[0] == '-')
+    else if (arg == "--parse-threads")
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << "エラー: --parse-threads オプションにはスレッド数が必要です\n";
+        return 1;
+      }
+      parseThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (arg == "--lift-threads")
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << "エラー: --lift-threads オプションにはスレッド数が必要です\n";
+        return 1;
+      }
+      liftThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (arg == "--parse-cache")
+    {
+      if (i + 1 >= argc)
+      {
+        std::cerr << "エラー: --parse-cache オプションにはディレクトリが必要です\n";
+        return 1;
+      }
+      parseCacheDir = argv[++i];
+    }
+    else if (arg == "--enable-tail-call")
+    {
+      tailCallEnabled = true;
+    }
+    else if (arg == "--no-inline")
+    {
+      inliningEnabled = false;
+    }
+    else if (arg.rfind("--verify=", 0) == 0)
+    {
+      if (!parseVerifyMode(arg.substr(9), verifyMode))
+      {
+        std::cerr << "エラー: --verify には none、final、each-pass のいずれかを指定してください\n";
+        return 1;
+      }
+    }
+    else if (parseOptimizationLevel(arg, optimizationLevel))
+    {
+      continue;
+    }
+    else if (arg.size() > 1 && arg[0] == '-')
     {
       std::cerr << "エラー: 不明なオプション: " << arg << "\n";
       printUsage(argv[0]);
@@ -88,21 +202,47 @@ int main(int argc, char *argv[])
     std::cout << "出力ファイルが指定されていないため、" << wasmFile << " と " << wastFile << " を使用します。\n";
   }
 
-  std::cout << "Assemblyファイルを解析中: " << inputFile << "\n";
-
   asmtowasm::AssemblyParser parser;
-  if (!parser.parseFile(inputFile))
+  parser.setThreadCount(parseThreads);
+  parser.setCacheDirectory(parseCacheDir);
+  if (inputFile == "-")
   {
-    std::cerr << "パースエラー: " << parser.getErrorMessage() << "\n";
-    return 1;
+    std::cout << "標準入力からAssemblyを解析中\n";
+    if (!parseStream(std::cin, parser))
+    {
+      std::cerr << "パースエラー: " << parser.getErrorMessage() << "\n";
+      return 1;
+    }
+  }
+  else
+  {
+    std::cout << "Assemblyファイルを解析中: " << inputFile << "\n";
+    if (!parser.parseFile(inputFile))
+    {
+      std::cerr << "パースエラー: " << parser.getErrorMessage() << "\n";
+      return 1;
+    }
   }
 
   asmtowasm::AssemblyLifter lifter;
+  lifter.setOptimizationLevel(optimizationLevel);
+  lifter.setThreadCount(liftThreads);
+  lifter.setTailCallEnabled(tailCallEnabled);
+  lifter.setInliningEnabled(inliningEnabled);
+  lifter.setVerifyMode(verifyMode);
   if (!lifter.liftToLLVM(parser.getInstructions(), parser.getLabels()))
   {
     std::cerr << "Assemblyリフターエラー: " << lifter.getErrorMessage() << "\n";
     return 1;
   }
+  if (!lifter.getInlinedFunctions().empty())
+  {
+    std::cout << "インライン展開した関数: " << lifter.getInlinedFunctions().size() << " 個\n";
+    for (const asmtowasm::InlinedFunction &inlined : lifter.getInlinedFunctions())
+    {
+      std::cout << "  " << inlined.name << " (命令 " << inlined.size << " 個, " << inlined.callSites << " 箇所)\n";
+    }
+  }
 
   llvm::Module *module = lifter.getModule();
   if (!module)
@@ -112,7 +252,8 @@ int main(int argc, char *argv[])
   }
 
   asmtowasm::WasmGenerator wasmGenerator;
-  if (!wasmGenerator.generateWasm(module))
+  wasmGenerator.setTailCallEnabled(tailCallEnabled);
+  if (!wasmGenerator.generateWasm(module, &parser.getInstructions().symbols()))
   {
     std::cerr << "WebAssembly生成エラー: " << wasmGenerator.getErrorMessage() << "\n";
     return 1;
@@ -0,0 +1,89 @@
+#include "mapped_file.h"
+#include <fstream>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace asmtowasm
+{
+
+  MappedFile::~MappedFile()
+  {
+    close();
+  }
+
+  bool MappedFile::open(const std::string &filename, std::string &errorMessage)
+  {
+    close();
+
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      errorMessage = "ファイルを開けませんでした: " + filename;
+      return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+      ::close(fd);
+      errorMessage = "ファイル情報を取得できませんでした: " + filename;
+      return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0)
+    {
+      // 空ファイルはマップできないので空バッファとして扱う
+      ::close(fd);
+      data_ = fallback_.data();
+      return true;
+    }
+
+    void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr != MAP_FAILED)
+    {
+      data_ = static_cast<const char *>(addr);
+      mapped_ = true;
+      return true;
+    }
+    size_ = 0;
+#endif
+
+    // mmapできない場合は通常の読み込みにフォールバック
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+      errorMessage = "ファイルを開けませんでした: " + filename;
+      return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    fallback_ = contents.str();
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+  }
+
+  void MappedFile::close()
+  {
+#if !defined(_WIN32)
+    if (mapped_)
+    {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+  }
+
+} // namespace asmtowasm
@@ -0,0 +1,362 @@
+#include "parse_cache.h"
+#include "mapped_file.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  namespace
+  {
+    // イメージの先頭
+    struct ImageHeader
+    {
+      char magic[4];
+      uint32_t version;
+      uint64_t sourceHash;
+      uint64_t sourceSize;
+      uint32_t instructionCount;
+      uint32_t operandCount;
+      uint32_t symbolCount;
+      uint32_t symbolBytes;
+      uint32_t labelCount;
+      uint32_t byteOrder; // 書き込んだホストのバイト順の確認用
+    };
+
+    // オペランド1件の固定長表現
+    struct PackedOperand
+    {
+      uint8_t type;
+      uint8_t reg;
+      uint8_t base;
+      uint8_t index;
+      uint8_t scale;
+      uint8_t reserved[3];
+      uint32_t symbol;
+      uint32_t reserved2;
+      int64_t immediate;
+      int64_t displacement;
+    };
+
+    struct PackedLabel
+    {
+      uint32_t symbol;
+      uint32_t reserved;
+      uint64_t index;
+    };
+
+    // path.tmp.<乱数> を排他的に作成する（同じキャッシュを書く他のプロセスやスレッドと名前が衝突しない）
+    std::FILE *createTempFile(const std::string &path, std::string &tempPath)
+    {
+      static std::atomic<uint64_t> counter{0};
+      std::random_device random;
+      for (int attempt = 0; attempt < 16; ++attempt)
+      {
+        const uint64_t suffix = (static_cast<uint64_t>(random()) << 32 | random()) ^
+                                static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                                (counter++ * 0x9e3779b97f4a7c15ull);
+        char name[24];
+        std::snprintf(name, sizeof(name), ".tmp.%016llx", static_cast<unsigned long long>(suffix));
+        tempPath = path + name;
+        // "x" は既存のファイルがあれば失敗する（C11の排他的作成）
+        if (std::FILE *file = std::fopen(tempPath.c_str(), "wbx"))
+        {
+          return file;
+        }
+      }
+      return nullptr;
+    }
+
+    constexpr char kMagic[4] = {'A', '2', 'W', 'C'};
+    constexpr uint32_t kByteOrderMark = 0x01020304;
+
+    size_t alignUp(size_t offset)
+    {
+      return (offset + 7) & ~static_cast<size_t>(7);
+    }
+
+    // 各セクションのオフセット
+    struct ImageLayout
+    {
+      size_t types;
+      size_t labelIds;
+      size_t operandBegin;
+      size_t operands;
+      size_t symbolOffsets;
+      size_t symbolChars;
+      size_t labels;
+      size_t total;
+
+      explicit ImageLayout(const ImageHeader &h)
+      {
+        types = sizeof(ImageHeader);
+        labelIds = alignUp(types + h.instructionCount);
+        operandBegin = alignUp(labelIds + sizeof(uint32_t) * h.instructionCount);
+        operands = alignUp(operandBegin + sizeof(uint32_t) * (static_cast<size_t>(h.instructionCount) + 1));
+        symbolOffsets = operands + sizeof(PackedOperand) * h.operandCount;
+        symbolChars = alignUp(symbolOffsets + sizeof(uint32_t) * (static_cast<size_t>(h.symbolCount) + 1));
+        labels = alignUp(symbolChars + h.symbolBytes);
+        total = labels + sizeof(PackedLabel) * h.labelCount;
+      }
+    };
+  }
+
+  uint64_t ParseCache::hashSource(const char *data, size_t size)
+  {
+    // FNV-1a（形式バージョンも混ぜて、形式変更時に別キーになるようにする）
+    uint64_t h = 1469598103934665603ull ^ kFormatVersion;
+    for (size_t i = 0; i < size; ++i)
+    {
+      h ^= static_cast<unsigned char>(data[i]);
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+  std::string ParseCache::imagePath(uint64_t sourceHash) const
+  {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.a2wc", static_cast<unsigned long long>(sourceHash));
+    return (std::filesystem::path(directory_) / name).string();
+  }
+
+  bool ParseCache::load(uint64_t sourceHash, size_t sourceSize, InstructionTable &table,
+                        LabelTable &labels) const
+  {
+    const std::string path = imagePath(sourceHash);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec))
+    {
+      return false;
+    }
+
+    MappedFile image;
+    std::string error;
+    if (!image.open(path, error))
+    {
+      return false;
+    }
+    return decode(image.data(), image.size(), sourceHash, sourceSize, table, labels);
+  }
+
+  bool ParseCache::decode(const char *data, size_t size, uint64_t sourceHash, size_t sourceSize,
+                          InstructionTable &table, LabelTable &labels)
+  {
+    ImageHeader header;
+    if (size < sizeof(header))
+    {
+      return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+        header.byteOrder != kByteOrderMark || header.sourceHash != sourceHash || header.sourceSize != sourceSize)
+    {
+      return false;
+    }
+
+    const ImageLayout layout(header);
+    if (layout.total > size)
+    {
+      return false;
+    }
+
+    const uint32_t n = header.instructionCount;
+    table.clear();
+
+    // 命令の列: 要素ごとの確保はせず、列ごとに一括でコピー
+    table.types_.resize(n);
+    const uint8_t *types = reinterpret_cast<const uint8_t *>(data + layout.types);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      if (types[i] > static_cast<uint8_t>(InstructionType::UNKNOWN))
+      {
+        table.clear();
+        return false;
+      }
+      table.types_[i] = static_cast<InstructionType>(types[i]);
+    }
+    table.labelIds_.resize(n);
+    std::memcpy(table.labelIds_.data(), data + layout.labelIds, sizeof(uint32_t) * n);
+    table.operandBegin_.resize(static_cast<size_t>(n) + 1);
+    std::memcpy(table.operandBegin_.data(), data + layout.operandBegin, sizeof(uint32_t) * (static_cast<size_t>(n) + 1));
+    if (table.operandBegin_.front() != 0 || table.operandBegin_.back() != header.operandCount)
+    {
+      table.clear();
+      return false;
+    }
+
+    table.operands_.resize(header.operandCount);
+    for (uint32_t i = 0; i < header.operandCount; ++i)
+    {
+      PackedOperand packed;
+      std::memcpy(&packed, data + layout.operands + sizeof(PackedOperand) * i, sizeof(packed));
+      Operand &operand = table.operands_[i];
+      operand.type = static_cast<OperandType>(packed.type);
+      operand.reg = static_cast<RegisterId>(packed.reg);
+      operand.memory.base = static_cast<RegisterId>(packed.base);
+      operand.memory.index = static_cast<RegisterId>(packed.index);
+      operand.memory.scale = packed.scale;
+      operand.memory.displacement = packed.displacement;
+      operand.immediate = packed.immediate;
+      operand.symbol = packed.symbol;
+    }
+
+    // 記号表: 書き込み時と同じ順に登録するのでIDはそのまま使える
+    std::vector<uint32_t> offsets(static_cast<size_t>(header.symbolCount) + 1);
+    std::memcpy(offsets.data(), data + layout.symbolOffsets, sizeof(uint32_t) * offsets.size());
+    const char *chars = data + layout.symbolChars;
+    for (uint32_t id = 0; id < header.symbolCount; ++id)
+    {
+      if (offsets[id] > offsets[id + 1] || offsets[id + 1] > header.symbolBytes)
+      {
+        table.clear();
+        return false;
+      }
+      table.symbols_.intern(std::string_view(chars + offsets[id], offsets[id + 1] - offsets[id]));
+    }
+    if (table.symbols_.size() != header.symbolCount)
+    {
+      table.clear();
+      return false;
+    }
+
+    // 参照の整合性を確認
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      const uint32_t labelId = table.labelIds_[i];
+      if ((labelId != SymbolTable::kNone && labelId >= header.symbolCount) ||
+          table.operandBegin_[i] > table.operandBegin_[i + 1])
+      {
+        table.clear();
+        return false;
+      }
+    }
+    for (const Operand &operand : table.operands_)
+    {
+      const uint8_t scale = operand.memory.scale;
+      if (operand.type > OperandType::LABEL || operand.reg >= RegisterId::COUNT ||
+          operand.memory.base >= RegisterId::COUNT || operand.memory.index >= RegisterId::COUNT ||
+          (scale != 1 && scale != 2 && scale != 4 && scale != 8) ||
+          (operand.type == OperandType::LABEL && operand.symbol >= header.symbolCount))
+      {
+        table.clear();
+        return false;
+      }
+    }
+
+    for (uint32_t i = 0; i < header.labelCount; ++i)
+    {
+      PackedLabel packed;
+      std::memcpy(&packed, data + layout.labels + sizeof(PackedLabel) * i, sizeof(packed));
+      // ラベルは命令の位置か末尾（最後の命令の後ろ）を指す
+      if (packed.symbol >= header.symbolCount || packed.index > n)
+      {
+        table.clear();
+        labels.clear();
+        return false;
+      }
+      labels.define(packed.symbol, static_cast<size_t>(packed.index));
+    }
+
+    return true;
+  }
+
+  bool ParseCache::store(uint64_t sourceHash, size_t sourceSize, const InstructionTable &table,
+                         const LabelTable &labels, std::string &errorMessage) const
+  {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+
+    // ラベルは命令テーブルと同じ記号IDで保存する
+    const SymbolTable &symbols = table.symbols_;
+    std::vector<PackedLabel> packedLabels;
+    packedLabels.reserve(labels.size());
+    labels.forEach([&](uint32_t symbol, size_t index)
+                   {
+                     PackedLabel packed{};
+                     packed.symbol = symbol;
+                     packed.index = index;
+                     packedLabels.push_back(packed);
+                   });
+
+    ImageHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.instructionCount = static_cast<uint32_t>(table.size());
+    header.operandCount = static_cast<uint32_t>(table.operands_.size());
+    header.symbolCount = static_cast<uint32_t>(symbols.size());
+    header.labelCount = static_cast<uint32_t>(packedLabels.size());
+    header.byteOrder = kByteOrderMark;
+
+    std::vector<uint32_t> offsets;
+    std::string chars;
+    offsets.reserve(symbols.size() + 1);
+    for (uint32_t id = 0; id < symbols.size(); ++id)
+    {
+      offsets.push_back(static_cast<uint32_t>(chars.size()));
+      chars.append(symbols.name(id));
+    }
+    offsets.push_back(static_cast<uint32_t>(chars.size()));
+    header.symbolBytes = static_cast<uint32_t>(chars.size());
+
+    const ImageLayout layout(header);
+    std::vector<char> image(layout.total, 0);
+    std::memcpy(image.data(), &header, sizeof(header));
+    for (size_t i = 0; i < table.types_.size(); ++i)
+    {
+      image[layout.types + i] = static_cast<char>(table.types_[i]);
+    }
+    std::memcpy(image.data() + layout.labelIds, table.labelIds_.data(), sizeof(uint32_t) * table.labelIds_.size());
+    std::memcpy(image.data() + layout.operandBegin, table.operandBegin_.data(), sizeof(uint32_t) * table.operandBegin_.size());
+    for (size_t i = 0; i < table.operands_.size(); ++i)
+    {
+      const Operand &operand = table.operands_[i];
+      PackedOperand packed{};
+      packed.type = static_cast<uint8_t>(operand.type);
+      packed.reg = static_cast<uint8_t>(operand.reg);
+      packed.base = static_cast<uint8_t>(operand.memory.base);
+      packed.index = static_cast<uint8_t>(operand.memory.index);
+      packed.scale = operand.memory.scale;
+      packed.symbol = operand.symbol;
+      packed.immediate = operand.immediate;
+      packed.displacement = operand.memory.displacement;
+      std::memcpy(image.data() + layout.operands + sizeof(PackedOperand) * i, &packed, sizeof(packed));
+    }
+    std::memcpy(image.data() + layout.symbolOffsets, offsets.data(), sizeof(uint32_t) * offsets.size());
+    std::memcpy(image.data() + layout.symbolChars, chars.data(), chars.size());
+    std::memcpy(image.data() + layout.labels, packedLabels.data(), sizeof(PackedLabel) * packedLabels.size());
+
+    // 書き込みごとに別名の一時ファイルへ書いてから置き換え、途中状態や他の書き込みと混ざったイメージを読まないようにする
+    const std::string path = imagePath(sourceHash);
+    std::string tempPath;
+    std::FILE *file = createTempFile(path, tempPath);
+    if (!file)
+    {
+      errorMessage = "キャッシュを書き込めませんでした: " + path + ".tmp.*";
+      return false;
+    }
+    const bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+    if (std::fclose(file) != 0 || !written)
+    {
+      errorMessage = "キャッシュを書き込めませんでした: " + tempPath;
+      std::filesystem::remove(tempPath, ec);
+      return false;
+    }
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+      errorMessage = "キャッシュを保存できませんでした: " + path;
+      std::filesystem::remove(tempPath, ec);
+      return false;
+    }
+    return true;
+  }
+
+} // namespace asmtowasm
@@ -0,0 +1,166 @@
+#include "stack_frame.h"
+#include <algorithm>
+
+namespace asmtowasm
+{
+
+  namespace
+  {
+    // オペランドが%esp（%rsp、%sp、%splを含む）を読み書きするか
+    bool referencesStackPointer(const Operand &operand)
+    {
+      auto isStackPointer = [](RegisterId reg) { return registerAlias(reg).full == RegisterId::RSP; };
+      switch (operand.type)
+      {
+      case OperandType::REGISTER:
+        return isStackPointer(operand.reg);
+      case OperandType::MEMORY:
+        return isStackPointer(operand.memory.base) || isStackPointer(operand.memory.index);
+      default:
+        return false;
+      }
+    }
+  }
+
+  StackLayout StackFrameAnalysis::run(const std::vector<FunctionRange> &ranges, const std::vector<FunctionCfg> &graphs)
+  {
+    const size_t functionCount = table_.symbols().size() + 1;
+    StackLayout layout;
+    layout.frames.assign(functionCount, StackFrame());
+    layout.slots.assign(table_.size(), StackLayout::kNoSlot);
+
+    // 範囲ごとに深さを流す（同じ関数の範囲が複数あればすべて釣り合う必要がある）
+    std::vector<bool> balanced(functionCount, true);
+    std::vector<std::vector<uint32_t>> callers(functionCount);
+    std::vector<uint32_t> callees;
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+      const uint32_t symbol = ranges[r].symbol;
+      callees.clear();
+      // %espを直接使う関数のスロットはシャドウスタック上のアドレスで読み書きされる
+      if (!analyzeRange(graphs[r], layout, layout.frames[symbol], callees) || layout.frames[symbol].usesStackPointer)
+      {
+        balanced[symbol] = false;
+      }
+      for (uint32_t callee : callees)
+      {
+        callers[callee].push_back(symbol);
+      }
+    }
+
+    // 釣り合わない関数の呼び出し元も、呼び出しをまたいでスタックの深さが変わるので昇格しない
+    std::vector<uint32_t> worklist;
+    for (size_t symbol = 0; symbol < functionCount; ++symbol)
+    {
+      if (!balanced[symbol])
+      {
+        worklist.push_back(static_cast<uint32_t>(symbol));
+      }
+    }
+    while (!worklist.empty())
+    {
+      const uint32_t symbol = worklist.back();
+      worklist.pop_back();
+      for (uint32_t caller : callers[symbol])
+      {
+        if (balanced[caller])
+        {
+          balanced[caller] = false;
+          worklist.push_back(caller);
+        }
+      }
+    }
+
+    for (size_t symbol = 0; symbol < functionCount; ++symbol)
+    {
+      StackFrame &frame = layout.frames[symbol];
+      frame.promoted = balanced[symbol] && frame.usesStack;
+      if (!frame.promoted)
+      {
+        frame.slotCount = 0;
+      }
+    }
+    return layout;
+  }
+
+  bool StackFrameAnalysis::analyzeRange(const FunctionCfg &graph, StackLayout &layout, StackFrame &frame,
+                                        std::vector<uint32_t> &callees)
+  {
+    depths_.assign(graph.blocks.size(), kUnknown);
+    std::vector<uint32_t> worklist;
+
+    // 後続ブロックへ深さを流す（関数から戻る辺では積み残しがあってはならない）
+    auto reach = [&](uint32_t successor, uint32_t depth)
+    {
+      if (successor == CfgBlock::kExit)
+      {
+        return depth == 0;
+      }
+      uint32_t &known = depths_[successor];
+      if (known == kUnknown)
+      {
+        known = depth;
+        worklist.push_back(successor);
+        return true;
+      }
+      return known == depth;
+    };
+
+    bool ok = reach(0, 0);
+    while (ok && !worklist.empty())
+    {
+      const CfgBlock &block = graph.blocks[worklist.back()];
+      uint32_t depth = depths_[worklist.back()];
+      worklist.pop_back();
+      for (size_t i = block.begin; ok && i < block.end; ++i)
+      {
+        InstructionView inst = table_[i];
+        switch (inst.type())
+        {
+        case InstructionType::PUSH:
+          layout.slots[i] = depth;
+          frame.slotCount = std::max(frame.slotCount, depth + 1);
+          ++depth;
+          break;
+        case InstructionType::POP:
+          // 入口より下のスロットは呼び出し元のもの
+          if (depth == 0)
+          {
+            ok = false;
+            break;
+          }
+          layout.slots[i] = --depth;
+          break;
+        case InstructionType::RET:
+          ok = depth == 0;
+          break;
+        case InstructionType::CALL:
+          if (inst.operands().size() == 1 && inst.operands()[0].type == OperandType::LABEL)
+          {
+            callees.push_back(inst.operands()[0].symbol);
+          }
+          break;
+        default:
+          break;
+        }
+      }
+      block.forEachSuccessor([&](uint32_t successor) { ok = ok && reach(successor, depth); });
+    }
+
+    // 到達しないブロックはリフトしないので、そのPUSH/POPはスロットを持たない
+    for (const CfgBlock &block : graph.blocks)
+    {
+      for (size_t i = block.begin; i < block.end && block.reachable; ++i)
+      {
+        InstructionView inst = table_[i];
+        frame.usesStack = frame.usesStack || inst.type() == InstructionType::PUSH || inst.type() == InstructionType::POP;
+        for (const Operand &operand : inst.operands())
+        {
+          frame.usesStackPointer = frame.usesStackPointer || referencesStackPointer(operand);
+        }
+      }
+    }
+    return ok;
+  }
+
+} // namespace asmtowasm
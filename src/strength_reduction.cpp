@@ -0,0 +1,203 @@
+#include "strength_reduction.h"
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/DivisionByConstantInfo.h>
+#include <vector>
+
+namespace asmtowasm
+{
+
+  StrengthReductionStats StrengthReduction::run(llvm::Module &module)
+  {
+    StrengthReductionStats stats;
+    llvm::IRBuilder<> builder(module.getContext());
+    std::vector<llvm::BinaryOperator *> candidates;
+    for (llvm::Function &func : module)
+    {
+      // 置き換えで命令列が変わるので、先に候補を集める
+      candidates.clear();
+      for (llvm::BasicBlock &block : func)
+      {
+        for (llvm::Instruction &inst : block)
+        {
+          auto *binOp = llvm::dyn_cast<llvm::BinaryOperator>(&inst);
+          if (!binOp || !binOp->getType()->isIntegerTy())
+          {
+            continue;
+          }
+          const llvm::Instruction::BinaryOps opcode = binOp->getOpcode();
+          if (opcode == llvm::Instruction::Mul ||
+              ((opcode == llvm::Instruction::SDiv || opcode == llvm::Instruction::UDiv) &&
+               binOp->getType()->isIntegerTy(32)))
+          {
+            candidates.push_back(binOp);
+          }
+        }
+      }
+
+      for (llvm::BinaryOperator *binOp : candidates)
+      {
+        // 乗算は可換なので、定数はどちら側でもよい
+        llvm::Value *x = binOp->getOperand(0);
+        auto *constant = llvm::dyn_cast<llvm::ConstantInt>(binOp->getOperand(1));
+        if (!constant && binOp->getOpcode() == llvm::Instruction::Mul)
+        {
+          x = binOp->getOperand(1);
+          constant = llvm::dyn_cast<llvm::ConstantInt>(binOp->getOperand(0));
+        }
+        if (!constant)
+        {
+          continue;
+        }
+
+        builder.SetInsertPoint(binOp);
+        llvm::Value *replacement = nullptr;
+        switch (binOp->getOpcode())
+        {
+        case llvm::Instruction::Mul:
+          replacement = reduceMultiply(builder, x, constant->getValue());
+          stats.multiplies += replacement != nullptr;
+          break;
+        case llvm::Instruction::SDiv:
+          replacement = reduceSignedDivide(builder, x, constant->getValue());
+          stats.signedDivides += replacement != nullptr;
+          break;
+        default:
+          replacement = reduceUnsignedDivide(builder, x, constant->getValue());
+          stats.unsignedDivides += replacement != nullptr;
+          break;
+        }
+        if (replacement)
+        {
+          binOp->replaceAllUsesWith(replacement);
+          binOp->eraseFromParent();
+        }
+      }
+    }
+    return stats;
+  }
+
+  llvm::Value *StrengthReduction::reduceMultiply(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &c)
+  {
+    if (c.isZero())
+    {
+      return nullptr;
+    }
+    // 符号ビットだけの定数は2^(n-1)を掛けるのと同じ
+    if (c.isPowerOf2())
+    {
+      return c.isOne() ? x : builder.CreateShl(x, c.logBase2(), "mul_shl");
+    }
+
+    const bool negate = c.isNegative();
+    const llvm::APInt magnitude = negate ? -c : c;
+    llvm::Value *product = nullptr;
+    if (magnitude.isPowerOf2())
+    {
+      product = magnitude.isOne() ? x : builder.CreateShl(x, magnitude.logBase2(), "mul_shl");
+    }
+    else if ((magnitude - 1).isPowerOf2())
+    {
+      product = builder.CreateAdd(builder.CreateShl(x, (magnitude - 1).logBase2(), "mul_shl"), x, "mul_add");
+    }
+    else if ((magnitude + 1).isPowerOf2())
+    {
+      product = builder.CreateSub(builder.CreateShl(x, (magnitude + 1).logBase2(), "mul_shl"), x, "mul_sub");
+    }
+    else
+    {
+      return nullptr;
+    }
+    return negate ? builder.CreateNeg(product, "mul_neg") : product;
+  }
+
+  llvm::Value *StrengthReduction::reduceSignedDivide(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &d)
+  {
+    // 0での除算と、INT_MIN / -1 のトラップはi32.div_sに任せる
+    if (d.isZero() || d.isAllOnes())
+    {
+      return nullptr;
+    }
+    if (d.isOne())
+    {
+      return x;
+    }
+    const unsigned bits = d.getBitWidth();
+
+    // 2^k: 負の被除数には 2^k-1 を足してから算術シフトし、0方向へ丸める
+    const llvm::APInt magnitude = d.abs();
+    if (magnitude.isPowerOf2())
+    {
+      const unsigned k = magnitude.logBase2();
+      llvm::Value *sign = builder.CreateAShr(x, bits - 1, "div_sign");
+      llvm::Value *bias = builder.CreateLShr(sign, bits - k, "div_bias");
+      llvm::Value *quotient = builder.CreateAShr(builder.CreateAdd(x, bias, "div_biased"), k, "div_q");
+      return d.isNegative() ? builder.CreateNeg(quotient, "div_neg") : quotient;
+    }
+
+    // 上位ビットの乗算で商の近似を求め、定数の符号とマジックナンバーの符号が異なる分を補正
+    const llvm::SignedDivisionByConstantInfo magics = llvm::SignedDivisionByConstantInfo::get(d);
+    llvm::Value *quotient = multiplyHigh(builder, x, magics.Magic, /*isSigned*/ true);
+    if (d.isStrictlyPositive() && magics.Magic.isNegative())
+    {
+      quotient = builder.CreateAdd(quotient, x, "div_q");
+    }
+    else if (d.isNegative() && magics.Magic.isStrictlyPositive())
+    {
+      quotient = builder.CreateSub(quotient, x, "div_q");
+    }
+    if (magics.ShiftAmount != 0)
+    {
+      quotient = builder.CreateAShr(quotient, magics.ShiftAmount, "div_q");
+    }
+    // 商が負なら1を足して0方向へ丸める
+    return builder.CreateAdd(quotient, builder.CreateLShr(quotient, bits - 1, "div_sign"), "div_q");
+  }
+
+  llvm::Value *StrengthReduction::reduceUnsignedDivide(llvm::IRBuilder<> &builder, llvm::Value *x,
+                                                       const llvm::APInt &d)
+  {
+    if (d.isZero())
+    {
+      return nullptr;
+    }
+    if (d.isPowerOf2())
+    {
+      return d.isOne() ? x : builder.CreateLShr(x, d.logBase2(), "div_q");
+    }
+
+    // マジックナンバーが33ビットになる偶数の定数は、先に2の冪で割っておくと32ビットに収まる
+    llvm::UnsignedDivisonByConstantInfo magics = llvm::UnsignedDivisonByConstantInfo::get(d);
+    unsigned preShift = 0;
+    if (magics.IsAdd && !d[0])
+    {
+      preShift = d.countTrailingZeros();
+      magics = llvm::UnsignedDivisonByConstantInfo::get(d.lshr(preShift), preShift);
+    }
+    llvm::Value *dividend = preShift != 0 ? builder.CreateLShr(x, preShift, "div_pre") : x;
+    llvm::Value *quotient = multiplyHigh(builder, dividend, magics.Magic, /*isSigned*/ false);
+    unsigned postShift = magics.ShiftAmount;
+    if (magics.IsAdd)
+    {
+      // 33ビット目の分は (x - q) / 2 + q で桁あふれさせずに足す
+      llvm::Value *half = builder.CreateLShr(builder.CreateSub(x, quotient, "div_npq"), 1, "div_npq");
+      quotient = builder.CreateAdd(half, quotient, "div_q");
+      --postShift;
+    }
+    return postShift != 0 ? builder.CreateLShr(quotient, postShift, "div_q") : quotient;
+  }
+
+  llvm::Value *StrengthReduction::multiplyHigh(llvm::IRBuilder<> &builder, llvm::Value *x, const llvm::APInt &magic,
+                                               bool isSigned)
+  {
+    llvm::Type *narrow = x->getType();
+    const unsigned bits = narrow->getIntegerBitWidth();
+    llvm::Type *wide = builder.getIntNTy(bits * 2);
+    llvm::Value *extended = isSigned ? builder.CreateSExt(x, wide, "mulh_x") : builder.CreateZExt(x, wide, "mulh_x");
+    llvm::Value *factor = llvm::ConstantInt::get(wide, isSigned ? magic.sext(bits * 2) : magic.zext(bits * 2));
+    llvm::Value *product = builder.CreateMul(extended, factor, "mulh");
+    return builder.CreateTrunc(builder.CreateLShr(product, bits, "mulh"), narrow, "mulh");
+  }
+
+} // namespace asmtowasm
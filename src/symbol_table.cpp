@@ -0,0 +1,74 @@
+#include "symbol_table.h"
+
+namespace asmtowasm
+{
+
+  uint32_t SymbolTable::intern(std::string_view name)
+  {
+    // 負荷率を1/2以下に保つ
+    if ((names_.size() + 1) * 2 > slots_.size())
+    {
+      rehash(slots_.empty() ? 64 : slots_.size() * 2);
+    }
+
+    size_t slot = findSlot(name, hash(name));
+    if (slots_[slot] != kNone)
+    {
+      return slots_[slot];
+    }
+
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name);
+    slots_[slot] = id;
+    return id;
+  }
+
+  uint32_t SymbolTable::find(std::string_view name) const
+  {
+    if (slots_.empty())
+    {
+      return kNone;
+    }
+    return slots_[findSlot(name, hash(name))];
+  }
+
+  void SymbolTable::clear()
+  {
+    names_.clear();
+    slots_.clear();
+  }
+
+  uint64_t SymbolTable::hash(std::string_view name)
+  {
+    // FNV-1a
+    uint64_t h = 1469598103934665603ull;
+    for (char c : name)
+    {
+      h ^= static_cast<unsigned char>(c);
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+  size_t SymbolTable::findSlot(std::string_view name, uint64_t h) const
+  {
+    // 線形探索: 同名のIDか空きスロットの位置を返す
+    const size_t mask = slots_.size() - 1;
+    size_t slot = static_cast<size_t>(h) & mask;
+    while (slots_[slot] != kNone && names_[slots_[slot]] != name)
+    {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void SymbolTable::rehash(size_t slotCount)
+  {
+    slots_.assign(slotCount, kNone);
+    for (uint32_t id = 0; id < names_.size(); ++id)
+    {
+      slots_[findSlot(names_[id], hash(names_[id]))] = id;
+    }
+  }
+
+} // namespace asmtowasm
@@ -1,6 +1,8 @@
 #include "wasm_generator.h"
+#include "stack_frame.h"
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/Operator.h>
 #include <llvm/Support/raw_ostream.h>
 #include <fstream>
 #include <sstream>
@@ -18,7 +20,37 @@ namespace asmtowasm
     errorMessage_.clear();
   }
 
-  bool WasmGenerator::generateWasm(llvm::Module *module)
+  void WasmGenerator::reset()
+  {
+    for (WasmFunction &func : wasmModule_.functions)
+    {
+      func.name.clear();
+      func.params.clear();
+      func.locals.clear();
+      func.results.clear();
+      func.instructions.clear();
+      spareFunctions_.push_back(std::move(func));
+    }
+    wasmModule_.functions.clear();
+    wasmModule_.globals.clear();
+    wasmModule_.symbols.clear();
+    wasmModule_.functionIndices.clear();
+    wasmModule_.memorySize = WasmModule().memorySize;
+    wasmModule_.memoryMaxSize = WasmModule().memoryMaxSize;
+    functionMap_.clear();
+    localMap_.clear();
+    globalMap_.clear();
+    phiCopies_.clear();
+    errorMessage_.clear();
+  }
+
+  bool WasmGenerator::compile(llvm::Module *module, const SymbolTable *symbols)
+  {
+    reset();
+    return generateWasm(module, symbols);
+  }
+
+  bool WasmGenerator::generateWasm(llvm::Module *module, const SymbolTable *symbols)
   {
     if (!module)
     {
@@ -29,6 +61,18 @@ namespace asmtowasm
     // 関数マップを初期化
     functionMap_.clear();
     localMap_.clear();
+    globalMap_.clear();
+    wasmModule_.symbols = symbols ? *symbols : SymbolTable();
+    wasmModule_.functionIndices.clear();
+
+    // グローバル変数（シャドウスタックのスタックポインタ）
+    for (auto &global : module->globals())
+    {
+      if (!convertGlobal(&global))
+      {
+        return false;
+      }
+    }
 
     uint32_t funcIndex = 0;
     for (auto &func : *module)
@@ -95,13 +139,10 @@ namespace asmtowasm
 
   WasmType WasmGenerator::convertLLVMType(llvm::Type *type)
   {
-    if (type->isIntegerTy(32))
-    {
-      return WasmType::I32;
-    }
-    else if (type->isIntegerTy(64))
+    // 最適化後のi1やi33などの整数は、それを収めるi32/i64で保持する
+    if (type->isIntegerTy())
     {
-      return WasmType::I64;
+      return isWide(type) ? WasmType::I64 : WasmType::I32;
     }
     else if (type->isFloatTy())
     {
@@ -120,63 +161,106 @@ namespace asmtowasm
     return WasmType::I32;
   }
 
+  void WasmGenerator::appendWasmTypes(llvm::Type *type, std::vector<WasmType> &types)
+  {
+    if (type->isVoidTy())
+    {
+      return;
+    }
+    if (auto *structType = llvm::dyn_cast<llvm::StructType>(type))
+    {
+      for (llvm::Type *element : structType->elements())
+      {
+        types.push_back(convertLLVMType(element));
+      }
+      return;
+    }
+    types.push_back(convertLLVMType(type));
+  }
+
+  bool WasmGenerator::convertGlobal(llvm::GlobalVariable *global)
+  {
+    auto *initializer = llvm::dyn_cast_or_null<llvm::ConstantInt>(
+        global->hasInitializer() ? global->getInitializer() : nullptr);
+    if (!initializer || initializer->getBitWidth() > 64)
+    {
+      errorMessage_ = "未対応のグローバル変数: " + global->getName().str();
+      return false;
+    }
+
+    WasmGlobal wasmGlobal;
+    wasmGlobal.name = global->getName().str();
+    wasmGlobal.type = convertLLVMType(initializer->getType());
+    wasmGlobal.isMutable = !global->isConstant();
+    wasmGlobal.initialValue = initializer->getZExtValue();
+    globalMap_[global] = static_cast<uint32_t>(wasmModule_.globals.size());
+    wasmModule_.globals.push_back(wasmGlobal);
+
+    // シャドウスタックの予約領域（スタックポインタの初期値まで）をメモリに含める
+    if (wasmGlobal.name == kStackPointerName)
+    {
+      const uint64_t pages = (wasmGlobal.initialValue + 65535) / 65536;
+      wasmModule_.memorySize = std::max<uint32_t>(wasmModule_.memorySize, static_cast<uint32_t>(pages));
+    }
+    return true;
+  }
+
   bool WasmGenerator::convertFunction(llvm::Function *func)
   {
     localMap_.clear();
 
-    WasmFunction wasmFunc(func->getName().str());
+    // 前のジョブの関数があればそのバッファを使う
+    WasmFunction wasmFunc("");
+    if (!spareFunctions_.empty())
+    {
+      wasmFunc = std::move(spareFunctions_.back());
+      spareFunctions_.pop_back();
+    }
+    wasmFunc.name = func->getName().str();
 
     // 関数ごとにローカルマップを初期化
     localMap_.clear();
 
-    // ローカル変数のインデックスを初期化
-    uint32_t localIndex = 0;
-
     // パラメータを変換
     for (auto &arg : func->args())
     {
       wasmFunc.params.push_back(convertLLVMType(arg.getType()));
     }
 
-    // 戻り値の型を設定
-    wasmFunc.returnType = convertLLVMType(func->getReturnType());
+    // 戻り値の型を設定（構造体の戻り値は複数の値）
+    appendWasmTypes(func->getReturnType(), wasmFunc.results);
 
-    // ローカル変数を収集
+    // ローカル変数を収集（allocaと、値を持つ命令ごとに1つ。Wasmで何もしない型変換は元の値を使う）
     for (auto &block : *func)
     {
       for (auto &inst : block)
       {
-        if (llvm::isa<llvm::AllocaInst>(inst))
+        if (inst.getType()->isVoidTy() || isFoldedCast(&inst) || isAllocaLoad(&inst) ||
+            isBranchCondition(&inst) || (llvm::isa<llvm::CallInst>(inst) && inst.use_empty()) ||
+            llvm::isa<llvm::ExtractValueInst>(inst) || isFoldedInsertValue(&inst) || isFoldedOffset(&inst) ||
+            isReturnCall(&inst))
+        {
+          continue;
+        }
+        if (inst.getType()->isStructTy())
         {
-          assignLocalIndex(&inst, WasmType::I32, wasmFunc);
+          assignLocalIndices(&inst, wasmFunc);
+          continue;
         }
+        WasmType localType = llvm::isa<llvm::AllocaInst>(inst) ? WasmType::I32 : convertLLVMType(inst.getType());
+        assignLocalIndex(&inst, localType, wasmFunc);
       }
     }
 
-    // SSA値に対応するローカルを事前確保
+    // phiへの値を先行ブロックごとにまとめる（合流の多いphiでも先行ブロックごとに走査しない）
+    phiCopies_.clear();
     for (auto &block : *func)
     {
-      for (auto &inst : block)
+      for (llvm::PHINode &phi : block.phis())
       {
-        if (llvm::isa<llvm::BinaryOperator>(inst) ||
-            llvm::isa<llvm::CmpInst>(inst) ||
-            llvm::isa<llvm::ZExtInst>(inst) ||
-            llvm::isa<llvm::IntToPtrInst>(inst) ||
-            llvm::isa<llvm::PtrToIntInst>(inst) ||
-            llvm::isa<llvm::BitCastInst>(inst))
+        for (unsigned i = 0; i < phi.getNumIncomingValues(); ++i)
         {
-          WasmType resultType = convertLLVMType(inst.getType());
-          assignLocalIndex(&inst, resultType, wasmFunc);
-        }
-        else if (!inst.getType()->isVoidTy())
-        {
-          // SSA値をローカルに割り当て、後続で再利用できるようにする
-          WasmType localType = convertLLVMType(inst.getType());
-          if (localType != WasmType::VOID)
-          {
-            wasmFunc.locals.push_back(localType);
-            localMap_[&inst] = localIndex++;
-          }
+          phiCopies_[phi.getIncomingBlock(i)].emplace_back(phi.getIncomingValue(i), &phi);
         }
       }
     }
@@ -190,8 +274,14 @@ namespace asmtowasm
       }
     }
 
-    wasmModule_.functions.push_back(wasmFunc);
-    wasmModule_.functionIndices[func->getName().str()] = wasmModule_.functions.size() - 1;
+    wasmModule_.functions.push_back(std::move(wasmFunc));
+    const llvm::StringRef funcName = func->getName();
+    const uint32_t symbol = wasmModule_.symbols.intern(std::string_view(funcName.data(), funcName.size()));
+    if (symbol >= wasmModule_.functionIndices.size())
+    {
+      wasmModule_.functionIndices.resize(static_cast<size_t>(symbol) + 1, WasmModule::kNoFunction);
+    }
+    wasmModule_.functionIndices[symbol] = static_cast<uint32_t>(wasmModule_.functions.size() - 1);
 
     return true;
   }
@@ -200,177 +290,495 @@ namespace asmtowasm
   {
     for (auto &inst : *block)
     {
+      // 後続ブロックのphiへの値は、このブロックを出る直前にローカルへ渡す
+      if (inst.isTerminator() && !emitPhiCopies(block, wasmFunc))
+      {
+        return false;
+      }
       if (!convertInstruction(&inst, wasmFunc))
       {
         return false;
       }
+      // return_callで戻るので、続くretや分岐（とphiへの値渡し）は出力しない
+      if (isReturnCall(&inst))
+      {
+        break;
+      }
     }
     return true;
   }
 
-  bool WasmGenerator::convertInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  bool WasmGenerator::emitPhiCopies(llvm::BasicBlock *block, WasmFunction &wasmFunc)
   {
-    auto &instructions = wasmFunc.instructions;
+    auto it = phiCopies_.find(block);
+    if (it == phiCopies_.end())
+    {
+      return true;
+    }
 
-    if (llvm::isa<llvm::BinaryOperator>(inst))
+    // phi同士が互いを参照しても壊れないよう、全部の値を積んでから逆順にlocal.setする
+    for (const auto &copy : it->second)
     {
-      return convertArithmeticInstruction(inst, wasmFunc);
+      if (!pushValue(copy.first, wasmFunc))
+      {
+        return false;
+      }
     }
-    else if (llvm::isa<llvm::CmpInst>(inst))
+    for (auto copy = it->second.rbegin(); copy != it->second.rend(); ++copy)
     {
-      return convertCompareInstruction(inst, wasmFunc);
+      emitSetLocals(copy->second, wasmFunc);
     }
-    else if (llvm::isa<llvm::BranchInst>(inst))
+    return true;
+  }
+
+  bool WasmGenerator::isReturnCall(const llvm::Instruction *inst) const
+  {
+    const auto *call = llvm::dyn_cast_or_null<llvm::CallInst>(inst);
+    if (!tailCallEnabled_ || !call || !call->isTailCall() || !call->getCalledFunction() ||
+        call->getCalledFunction()->isIntrinsic())
     {
-      return convertBranchInstruction(inst, wasmFunc);
+      return false;
     }
-    else if (llvm::isa<llvm::CallInst>(inst))
+    // return_callは呼び出し先の戻り値をそのまま返すので、直後のretが呼び出しの値（voidなら両方void）を返すときだけ
+    // 戻りを1つにまとめた最適化後のIRでは、retだけのブロックへの分岐とphiを通る
+    const llvm::Instruction *next = call->getNextNode();
+    const llvm::Value *returned = call;
+    if (const auto *br = llvm::dyn_cast_or_null<llvm::BranchInst>(next); br && br->isUnconditional())
     {
-      return convertCallInstruction(inst, wasmFunc);
+      const llvm::BasicBlock *target = br->getSuccessor(0);
+      next = target->getFirstNonPHI();
+      if (const auto *phi = llvm::dyn_cast<llvm::PHINode>(&target->front()))
+      {
+        if (phi->getNextNode() != next || phi->getIncomingValueForBlock(call->getParent()) != call)
+        {
+          return false;
+        }
+        returned = phi;
+      }
     }
-    else if (llvm::isa<llvm::ReturnInst>(inst))
+    const auto *ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(next);
+    if (!ret)
     {
-      return convertReturnInstruction(inst, wasmFunc);
+      return false;
     }
-    else if (llvm::isa<llvm::LoadInst>(inst) || llvm::isa<llvm::StoreInst>(inst))
+    return ret->getNumOperands() == 0 ? call->getType()->isVoidTy() : ret->getOperand(0) == returned;
+  }
+
+  bool WasmGenerator::isFoldedCast(const llvm::Value *value)
+  {
+    // ポインタとi32の変換、同じi32/i64に収まるゼロ拡張はWasmではそのままの値（定数式も同様）
+    // 狭い整数は常にゼロ拡張で保持しているので、i1からi32へのzextも何もしない
+    switch (llvm::Operator::getOpcode(value))
+    {
+    case llvm::Instruction::IntToPtr:
+    case llvm::Instruction::PtrToInt:
+    case llvm::Instruction::BitCast:
+    case llvm::Instruction::Freeze:
+      return true;
+    case llvm::Instruction::ZExt:
+      return isWide(llvm::cast<llvm::User>(value)->getOperand(0)->getType()) == isWide(value->getType());
+    default:
+      return false;
+    }
+  }
+
+  bool WasmGenerator::isWide(const llvm::Type *type)
+  {
+    return type->isIntegerTy() && type->getIntegerBitWidth() > 32;
+  }
+
+  WasmOpcode WasmGenerator::selectOpcode(const llvm::Type *type, WasmOpcode op32, WasmOpcode op64)
+  {
+    return isWide(type) ? op64 : op32;
+  }
+
+  bool WasmGenerator::pushSignExtended(llvm::Value *value, WasmFunction &wasmFunc)
+  {
+    if (!pushValue(value, wasmFunc))
     {
-      return convertMemoryInstruction(inst, wasmFunc);
+      return false;
     }
-    else if (llvm::isa<llvm::AllocaInst>(inst))
+
+    // 上位ビットへ寄せてから算術右シフトで戻す
+    llvm::Type *type = value->getType();
+    const unsigned containerBits = isWide(type) ? 64 : 32;
+    const unsigned bits = type->isIntegerTy() ? type->getIntegerBitWidth() : containerBits;
+    if (bits == containerBits)
     {
-      // Allocaは既にローカル変数として処理済み
       return true;
     }
-    else if (llvm::isa<llvm::IntToPtrInst>(inst))
+    auto &instructions = wasmFunc.instructions;
+    const WasmOpcode constOp = selectOpcode(type, WasmOpcode::I32_CONST, WasmOpcode::I64_CONST);
+    instructions.push_back(WasmInstruction(constOp, containerBits - bits));
+    instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SHL, WasmOpcode::I64_SHL)));
+    instructions.push_back(WasmInstruction(constOp, containerBits - bits));
+    instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SHR_S, WasmOpcode::I64_SHR_S)));
+    return true;
+  }
+
+  void WasmGenerator::emitWrap(llvm::Type *type, WasmFunction &wasmFunc)
+  {
+    const unsigned containerBits = isWide(type) ? 64 : 32;
+    const unsigned bits = type->getIntegerBitWidth();
+    if (bits == containerBits)
     {
-      return convertIntToPtrInstruction(inst, wasmFunc);
+      return;
     }
-    else if (llvm::isa<llvm::PtrToIntInst>(inst))
+    auto &instructions = wasmFunc.instructions;
+    instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_CONST, WasmOpcode::I64_CONST),
+                                           (uint64_t(1) << bits) - 1));
+    instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_AND, WasmOpcode::I64_AND)));
+  }
+
+  bool WasmGenerator::isBranchCondition(const llvm::Instruction *inst)
+  {
+    // 直後の条件分岐だけが使う比較は、結果をスタックに残したままbr_ifへ渡す
+    // （間に入るphiへのコピーはスタックを元の高さに戻す）
+    if (!llvm::isa<llvm::CmpInst>(inst) || !inst->hasOneUse())
     {
-      return convertPtrToIntInstruction(inst, wasmFunc);
+      return false;
     }
-    else if (llvm::isa<llvm::BitCastInst>(inst))
+    const auto *branch = llvm::dyn_cast<llvm::BranchInst>(*inst->user_begin());
+    return branch && branch == inst->getNextNode();
+  }
+
+  bool WasmGenerator::isFoldedInsertValue(const llvm::Value *value)
+  {
+    // 組み立て途中の構造体はローカルに置かず、使う側で要素を直接積む
+    // （同じブロック内ならphiのローカルが途中で書き換わらない）
+    const auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(value);
+    if (!insert || !insert->hasOneUse() || insert->getNumIndices() != 1)
     {
-      return convertBitCastInstruction(inst, wasmFunc);
+      return false;
     }
-    else if (llvm::isa<llvm::ZExtInst>(inst))
-    {
-      // ゼロ拡張（例: i1 -> i32）を変換
-      llvm::ZExtInst *zext = llvm::cast<llvm::ZExtInst>(inst);
-      llvm::Value *op = zext->getOperand(0);
+    const auto *user = llvm::dyn_cast<llvm::Instruction>(*insert->user_begin());
+    return user && user->getParent() == insert->getParent() && !llvm::isa<llvm::PHINode>(user);
+  }
 
-      // 代表的ケース: 比較結果(i1)のゼロ拡張
-      if (llvm::isa<llvm::CmpInst>(op))
+  bool WasmGenerator::isAllocaLoad(const llvm::Value *value)
+  {
+    const auto *load = llvm::dyn_cast<llvm::LoadInst>(value);
+    return load && llvm::isa<llvm::AllocaInst>(load->getPointerOperand());
+  }
+
+  bool WasmGenerator::isFoldedOffset(const llvm::Value *value)
+  {
+    // アドレス計算の最後の nuw な定数の加算で、結果をロード/ストアのアドレスにだけ使うもの
+    // （Wasmの offset= は符号なしで、ベースとの和が折り返さないときだけ同じ意味になる）
+    const auto *add = llvm::dyn_cast<llvm::BinaryOperator>(value);
+    if (!add || add->getOpcode() != llvm::Instruction::Add || !add->hasNoUnsignedWrap() || add->use_empty())
+    {
+      return false;
+    }
+    const auto *offset = llvm::dyn_cast<llvm::ConstantInt>(add->getOperand(1));
+    if (!offset || offset->getBitWidth() > 32)
+    {
+      return false;
+    }
+    for (const llvm::User *user : add->users())
+    {
+      if (llvm::Operator::getOpcode(user) != llvm::Instruction::IntToPtr || user->use_empty())
+      {
+        return false;
+      }
+      for (const llvm::User *access : user->users())
       {
-        // 比較をWasmに変換（結果がスタックにi32で積まれる）
-        if (!convertCompareInstruction(llvm::cast<llvm::Instruction>(op), wasmFunc))
+        const auto *load = llvm::dyn_cast<llvm::LoadInst>(access);
+        const auto *store = llvm::dyn_cast<llvm::StoreInst>(access);
+        if (!(load && load->getPointerOperand() == user) &&
+            !(store && store->getPointerOperand() == user && store->getValueOperand() != user))
         {
           return false;
         }
       }
-      else if (llvm::isa<llvm::ConstantInt>(op))
-      {
-        auto *constInt = llvm::cast<llvm::ConstantInt>(op);
-        instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-      }
-      else if (llvm::isa<llvm::LoadInst>(op))
+    }
+    return true;
+  }
+
+  bool WasmGenerator::pushAddress(llvm::Value *pointer, uint64_t &offset, WasmFunction &wasmFunc)
+  {
+    offset = 0;
+    llvm::Value *address = isFoldedCast(pointer) ? llvm::cast<llvm::User>(pointer)->getOperand(0) : pointer;
+    if (isFoldedOffset(address))
+    {
+      auto *add = llvm::cast<llvm::BinaryOperator>(address);
+      offset = llvm::cast<llvm::ConstantInt>(add->getOperand(1))->getZExtValue();
+      address = add->getOperand(0);
+    }
+    return pushValue(address, wasmFunc);
+  }
+
+  bool WasmGenerator::pushValue(llvm::Value *value, WasmFunction &wasmFunc)
+  {
+    auto &instructions = wasmFunc.instructions;
+
+    if (auto *structType = llvm::dyn_cast<llvm::StructType>(value->getType()))
+    {
+      for (unsigned i = 0; i < structType->getNumElements(); ++i)
       {
-        auto *load = llvm::cast<llvm::LoadInst>(op);
-        uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+        if (!pushField(value, i, wasmFunc))
+        {
+          return false;
+        }
       }
-      else
+      return true;
+    }
+    if (auto *extract = llvm::dyn_cast<llvm::ExtractValueInst>(value))
+    {
+      if (extract->getNumIndices() != 1)
       {
-        // 最低限の対応: その他は未対応として扱う
-        errorMessage_ = "未対応のZExtオペランド";
+        errorMessage_ = "未対応のextractvalue: 入れ子の構造体";
         return false;
       }
+      return pushField(extract->getAggregateOperand(), extract->getIndices()[0], wasmFunc);
+    }
 
-      // zextの結果をローカルに保存
-      uint32_t resultIdx = assignLocalIndex(inst, convertLLVMType(inst->getType()), wasmFunc);
-      instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, resultIdx));
+    if (auto *constInt = llvm::dyn_cast<llvm::ConstantInt>(value))
+    {
+      instructions.push_back(WasmInstruction(selectOpcode(value->getType(), WasmOpcode::I32_CONST, WasmOpcode::I64_CONST),
+                                             constInt->getZExtValue()));
+      return true;
+    }
+    if (llvm::isa<llvm::UndefValue>(value) || llvm::isa<llvm::ConstantPointerNull>(value))
+    {
+      // 未定義のレジスタはWasmのローカルの初期値と同じ0として扱う
+      instructions.push_back(WasmInstruction(selectOpcode(value->getType(), WasmOpcode::I32_CONST, WasmOpcode::I64_CONST), 0));
+      return true;
+    }
+    if (auto *arg = llvm::dyn_cast<llvm::Argument>(value))
+    {
+      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, arg->getArgNo()));
+      return true;
+    }
+    if (isFoldedCast(value))
+    {
+      return pushValue(llvm::cast<llvm::User>(value)->getOperand(0), wasmFunc);
+    }
+    if (isAllocaLoad(value))
+    {
+      // allocaはローカルそのもの
+      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL,
+                                             getLocalIndex(llvm::cast<llvm::LoadInst>(value)->getPointerOperand())));
+      return true;
+    }
+    if (llvm::isa<llvm::Instruction>(value))
+    {
+      // 以前にローカルへ保存したSSA値を再利用
+      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, getLocalIndex(value)));
       return true;
     }
 
-    // 未対応の命令
-    errorMessage_ = "未対応のLLVM命令: " + std::string(inst->getOpcodeName());
+    errorMessage_ = "未対応のLLVM値: " + value->getName().str();
     return false;
   }
 
-  bool WasmGenerator::convertArithmeticInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  bool WasmGenerator::pushField(llvm::Value *aggregate, unsigned index, WasmFunction &wasmFunc)
   {
-    auto &instructions = wasmFunc.instructions;
+    if (auto *constant = llvm::dyn_cast<llvm::Constant>(aggregate))
+    {
+      llvm::Constant *element = constant->getAggregateElement(index);
+      if (!element)
+      {
+        errorMessage_ = "構造体の定数の要素を取得できません";
+        return false;
+      }
+      return pushValue(element, wasmFunc);
+    }
+    if (isFoldedInsertValue(aggregate))
+    {
+      auto *insert = llvm::cast<llvm::InsertValueInst>(aggregate);
+      if (insert->getIndices()[0] == index)
+      {
+        return pushValue(insert->getInsertedValueOperand(), wasmFunc);
+      }
+      return pushField(insert->getAggregateOperand(), index, wasmFunc);
+    }
+    if (llvm::isa<llvm::Instruction>(aggregate))
+    {
+      wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, getLocalIndex(aggregate) + index));
+      return true;
+    }
 
-    llvm::BinaryOperator *binOp = llvm::cast<llvm::BinaryOperator>(inst);
+    errorMessage_ = "未対応の構造体の値: " + aggregate->getName().str();
+    return false;
+  }
 
-    // オペランドを取得
-    llvm::Value *lhs = binOp->getOperand(0);
-    llvm::Value *rhs = binOp->getOperand(1);
+  void WasmGenerator::emitSetLocals(llvm::Value *value, WasmFunction &wasmFunc)
+  {
+    const uint32_t base = getLocalIndex(value);
+    if (auto *structType = llvm::dyn_cast<llvm::StructType>(value->getType()))
+    {
+      for (unsigned i = structType->getNumElements(); i-- > 0;)
+      {
+        wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, base + i));
+      }
+      return;
+    }
+    wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, base));
+  }
 
-    // 左オペランドをスタックにプッシュ
-    if (llvm::isa<llvm::ConstantInt>(lhs))
+  bool WasmGenerator::convertInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  {
+    if (inst->getType()->isIntegerTy() && inst->getType()->getIntegerBitWidth() > 64)
     {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(lhs);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
+      errorMessage_ = "未対応の整数幅: i" + std::to_string(inst->getType()->getIntegerBitWidth());
+      return false;
     }
-    else if (llvm::isa<llvm::LoadInst>(lhs))
+
+    if (isFoldedOffset(inst))
     {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(lhs);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+      // ロード/ストアのoffset=になる
+      return true;
     }
-    else if (llvm::isa<llvm::Instruction>(lhs))
+    else if (llvm::isa<llvm::BinaryOperator>(inst))
     {
-      // 以前にローカルへ保存したSSA値を再利用
-      uint32_t localIdx = getLocalIndex(lhs);
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+      return convertArithmeticInstruction(inst, wasmFunc);
     }
-
-    // 右オペランドをスタックにプッシュ
-    if (llvm::isa<llvm::ConstantInt>(rhs))
+    else if (llvm::isa<llvm::CmpInst>(inst))
     {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(rhs);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
+      return convertCompareInstruction(inst, wasmFunc);
     }
-    else if (llvm::isa<llvm::LoadInst>(rhs))
+    else if (llvm::isa<llvm::BranchInst>(inst))
     {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(rhs);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+      return convertBranchInstruction(inst, wasmFunc);
     }
-    else if (llvm::isa<llvm::Instruction>(rhs))
+    else if (llvm::isa<llvm::SwitchInst>(inst))
     {
-      // 以前にローカルへ保存したSSA値を再利用
-      uint32_t localIdx = getLocalIndex(rhs);
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+      return convertSwitchInstruction(inst, wasmFunc);
+    }
+    else if (llvm::isa<llvm::SelectInst>(inst))
+    {
+      return convertSelectInstruction(inst, wasmFunc);
+    }
+    else if (llvm::isa<llvm::CallInst>(inst))
+    {
+      return convertCallInstruction(inst, wasmFunc);
+    }
+    else if (llvm::isa<llvm::ReturnInst>(inst))
+    {
+      return convertReturnInstruction(inst, wasmFunc);
+    }
+    else if (llvm::isa<llvm::LoadInst>(inst) || llvm::isa<llvm::StoreInst>(inst))
+    {
+      return convertMemoryInstruction(inst, wasmFunc);
+    }
+    else if (llvm::isa<llvm::AllocaInst>(inst))
+    {
+      // Allocaは既にローカル変数として処理済み
+      return true;
+    }
+    else if (llvm::isa<llvm::PHINode>(inst))
+    {
+      // phiの値は先行ブロックの末尾でローカルに設定済み
+      return true;
+    }
+    else if (isFoldedCast(inst))
+    {
+      // 使う側で元の値を積む
+      return true;
+    }
+    else if (llvm::isa<llvm::ZExtInst>(inst) || llvm::isa<llvm::SExtInst>(inst) || llvm::isa<llvm::TruncInst>(inst))
+    {
+      return convertCastInstruction(inst, wasmFunc);
     }
+    else if (llvm::isa<llvm::ExtractValueInst>(inst) || isFoldedInsertValue(inst))
+    {
+      // 使う側で構造体の要素を積む
+      return true;
+    }
+    else if (llvm::isa<llvm::InsertValueInst>(inst))
+    {
+      return convertInsertValueInstruction(inst, wasmFunc);
+    }
+    else if (llvm::isa<llvm::UnreachableInst>(inst))
+    {
+      wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::UNREACHABLE));
+      return true;
+    }
+
+    // 未対応の命令
+    errorMessage_ = "未対応のLLVM命令: " + std::string(inst->getOpcodeName());
+    return false;
+  }
+
+  bool WasmGenerator::convertArithmeticInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  {
+    auto &instructions = wasmFunc.instructions;
 
-    // 演算命令を追加
-    switch (binOp->getOpcode())
+    llvm::BinaryOperator *binOp = llvm::cast<llvm::BinaryOperator>(inst);
+    llvm::Type *type = binOp->getType();
+
+    // 符号付きの演算は狭い整数の左オペランド（除算は両方）を符号拡張して積む
+    const llvm::Instruction::BinaryOps opcode = binOp->getOpcode();
+    const bool signedLeft = opcode == llvm::Instruction::SDiv || opcode == llvm::Instruction::SRem ||
+                            opcode == llvm::Instruction::AShr;
+    const bool signedRight = opcode == llvm::Instruction::SDiv || opcode == llvm::Instruction::SRem;
+    if (!(signedLeft ? pushSignExtended(binOp->getOperand(0), wasmFunc) : pushValue(binOp->getOperand(0), wasmFunc)) ||
+        !(signedRight ? pushSignExtended(binOp->getOperand(1), wasmFunc) : pushValue(binOp->getOperand(1), wasmFunc)))
+    {
+      return false;
+    }
+
+    // 演算命令を追加（上位ビットに桁あふれや符号が残る演算は、狭い整数なら落とす）
+    bool wraps = true;
+    switch (opcode)
     {
     case llvm::Instruction::Add:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_ADD));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_ADD, WasmOpcode::I64_ADD)));
+      break;
+    case llvm::Instruction::Sub:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SUB, WasmOpcode::I64_SUB)));
+      break;
+    case llvm::Instruction::Mul:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_MUL, WasmOpcode::I64_MUL)));
+      break;
+    case llvm::Instruction::SDiv:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_DIV_S, WasmOpcode::I64_DIV_S)));
+      break;
+    case llvm::Instruction::SRem:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_REM_S, WasmOpcode::I64_REM_S)));
+      break;
+    case llvm::Instruction::Shl:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SHL, WasmOpcode::I64_SHL)));
+      break;
+    case llvm::Instruction::AShr:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SHR_S, WasmOpcode::I64_SHR_S)));
+      break;
+    case llvm::Instruction::UDiv:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_DIV_U, WasmOpcode::I64_DIV_U)));
+      wraps = false;
       break;
-    case llvm::Instruction::Sub:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_SUB));
+    case llvm::Instruction::URem:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_REM_U, WasmOpcode::I64_REM_U)));
+      wraps = false;
       break;
-    case llvm::Instruction::Mul:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_MUL));
+    case llvm::Instruction::LShr:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SHR_U, WasmOpcode::I64_SHR_U)));
+      wraps = false;
       break;
-    case llvm::Instruction::SDiv:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_DIV_S));
+    case llvm::Instruction::And:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_AND, WasmOpcode::I64_AND)));
+      wraps = false;
       break;
-    case llvm::Instruction::UDiv:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_DIV_U));
+    case llvm::Instruction::Or:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_OR, WasmOpcode::I64_OR)));
+      wraps = false;
+      break;
+    case llvm::Instruction::Xor:
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_XOR, WasmOpcode::I64_XOR)));
+      wraps = false;
       break;
     default:
       errorMessage_ = "未対応の算術演算: " + std::string(binOp->getOpcodeName());
       return false;
     }
+    if (wraps)
+    {
+      emitWrap(type, wasmFunc);
+    }
 
     // 結果をローカル変数に格納（後で使用されるため）
-    uint32_t resultIdx = assignLocalIndex(inst, convertLLVMType(inst->getType()), wasmFunc);
-    instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, resultIdx));
+    instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(inst)));
 
     return true;
   }
@@ -380,75 +788,60 @@ namespace asmtowasm
     auto &instructions = wasmFunc.instructions;
 
     llvm::CmpInst *cmpInst = llvm::cast<llvm::CmpInst>(inst);
+    llvm::Type *type = cmpInst->getOperand(0)->getType();
 
-    // オペランドを取得
-    llvm::Value *lhs = cmpInst->getOperand(0);
-    llvm::Value *rhs = cmpInst->getOperand(1);
-
-    // 左オペランドをスタックにプッシュ
-    if (llvm::isa<llvm::ConstantInt>(lhs))
-    {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(lhs);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-    }
-    else if (llvm::isa<llvm::LoadInst>(lhs))
-    {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(lhs);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
-    }
-
-    // 右オペランドをスタックにプッシュ
-    if (llvm::isa<llvm::ConstantInt>(rhs))
-    {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(rhs);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-    }
-    else if (llvm::isa<llvm::LoadInst>(rhs))
+    // オペランドをスタックにプッシュ（符号付き比較では狭い整数を符号拡張）
+    const bool isSigned = cmpInst->isSigned();
+    if (!(isSigned ? pushSignExtended(cmpInst->getOperand(0), wasmFunc) : pushValue(cmpInst->getOperand(0), wasmFunc)) ||
+        !(isSigned ? pushSignExtended(cmpInst->getOperand(1), wasmFunc) : pushValue(cmpInst->getOperand(1), wasmFunc)))
     {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(rhs);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+      return false;
     }
 
     // 比較命令を追加
     switch (cmpInst->getPredicate())
     {
     case llvm::CmpInst::ICMP_EQ:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_EQ));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_EQ, WasmOpcode::I64_EQ)));
       break;
     case llvm::CmpInst::ICMP_NE:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_NE));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_NE, WasmOpcode::I64_NE)));
       break;
     case llvm::CmpInst::ICMP_SLT:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_LT_S));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_LT_S, WasmOpcode::I64_LT_S)));
       break;
     case llvm::CmpInst::ICMP_ULT:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_LT_U));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_LT_U, WasmOpcode::I64_LT_U)));
       break;
     case llvm::CmpInst::ICMP_SGT:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_GT_S));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_GT_S, WasmOpcode::I64_GT_S)));
       break;
     case llvm::CmpInst::ICMP_UGT:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_GT_U));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_GT_U, WasmOpcode::I64_GT_U)));
       break;
     case llvm::CmpInst::ICMP_SLE:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_LE_S));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_LE_S, WasmOpcode::I64_LE_S)));
       break;
     case llvm::CmpInst::ICMP_ULE:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_LE_U));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_LE_U, WasmOpcode::I64_LE_U)));
       break;
     case llvm::CmpInst::ICMP_SGE:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_GE_S));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_GE_S, WasmOpcode::I64_GE_S)));
       break;
     case llvm::CmpInst::ICMP_UGE:
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_GE_U));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_GE_U, WasmOpcode::I64_GE_U)));
       break;
     default:
       errorMessage_ = "未対応の比較演算";
       return false;
     }
 
+    // 比較結果（i32の0/1）をローカルに格納（分岐条件ならスタックに残す）
+    if (!isBranchCondition(inst))
+    {
+      instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(inst)));
+    }
+
     return true;
   }
 
@@ -467,17 +860,12 @@ namespace asmtowasm
     }
     else
     {
-      // 条件分岐
+      // 条件をスタックにプッシュ（直前の比較の結果は積まれたまま）
       llvm::Value *condition = branchInst->getCondition();
-      llvm::BasicBlock *trueTarget = branchInst->getSuccessor(0);
-      llvm::BasicBlock *falseTarget = branchInst->getSuccessor(1);
-
-      // 条件をスタックにプッシュ
-      if (llvm::isa<llvm::LoadInst>(condition))
+      auto *conditionInst = llvm::dyn_cast<llvm::Instruction>(condition);
+      if ((!conditionInst || !isBranchCondition(conditionInst)) && !pushValue(condition, wasmFunc))
       {
-        llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(condition);
-        uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+        return false;
       }
 
       instructions.push_back(WasmInstruction(WasmOpcode::BR_IF, 0));
@@ -486,19 +874,115 @@ namespace asmtowasm
     return true;
   }
 
+  bool WasmGenerator::convertSwitchInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  {
+    auto &instructions = wasmFunc.instructions;
+
+    // 条件分岐と同じく、ケースごとに比較してbr_if（defaultへは無条件ブランチと同様にスキップ）
+    llvm::SwitchInst *switchInst = llvm::cast<llvm::SwitchInst>(inst);
+    llvm::Value *condition = switchInst->getCondition();
+    for (auto &switchCase : switchInst->cases())
+    {
+      if (!pushValue(condition, wasmFunc) || !pushValue(switchCase.getCaseValue(), wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(selectOpcode(condition->getType(), WasmOpcode::I32_EQ, WasmOpcode::I64_EQ)));
+      instructions.push_back(WasmInstruction(WasmOpcode::BR_IF, 0));
+    }
+    return true;
+  }
+
+  bool WasmGenerator::convertCastInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  {
+    auto &instructions = wasmFunc.instructions;
+
+    llvm::Value *source = inst->getOperand(0);
+    const bool wideSource = isWide(source->getType());
+    const bool wideResult = isWide(inst->getType());
+
+    if (llvm::isa<llvm::SExtInst>(inst))
+    {
+      if (!pushSignExtended(source, wasmFunc))
+      {
+        return false;
+      }
+      if (!wideSource && wideResult)
+      {
+        instructions.push_back(WasmInstruction(WasmOpcode::I64_EXTEND_I32_S));
+      }
+      emitWrap(inst->getType(), wasmFunc);
+    }
+    else
+    {
+      // zext（i32からi64）とtrunc。狭い整数はゼロ拡張で保持しているので、符号を気にせず幅だけ変える
+      if (!pushValue(source, wasmFunc))
+      {
+        return false;
+      }
+      if (!wideSource && wideResult)
+      {
+        instructions.push_back(WasmInstruction(WasmOpcode::I64_EXTEND_I32_U));
+      }
+      else if (wideSource && !wideResult)
+      {
+        instructions.push_back(WasmInstruction(WasmOpcode::I32_WRAP_I64));
+      }
+      if (llvm::isa<llvm::TruncInst>(inst))
+      {
+        emitWrap(inst->getType(), wasmFunc);
+      }
+    }
+
+    instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(inst)));
+    return true;
+  }
+
+  bool WasmGenerator::convertSelectInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  {
+    // Wasmのselectは「真の値→偽の値→条件」の順に積む
+    llvm::SelectInst *selectInst = llvm::cast<llvm::SelectInst>(inst);
+    if (auto *structType = llvm::dyn_cast<llvm::StructType>(inst->getType()))
+    {
+      // 構造体は要素ごとに選ぶ
+      for (unsigned i = 0; i < structType->getNumElements(); ++i)
+      {
+        if (!pushField(selectInst->getTrueValue(), i, wasmFunc) || !pushField(selectInst->getFalseValue(), i, wasmFunc) ||
+            !pushValue(selectInst->getCondition(), wasmFunc))
+        {
+          return false;
+        }
+        wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::SELECT));
+      }
+      emitSetLocals(inst, wasmFunc);
+      return true;
+    }
+    if (!pushValue(selectInst->getTrueValue(), wasmFunc) || !pushValue(selectInst->getFalseValue(), wasmFunc) ||
+        !pushValue(selectInst->getCondition(), wasmFunc))
+    {
+      return false;
+    }
+    wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::SELECT));
+    wasmFunc.instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(inst)));
+    return true;
+  }
+
   bool WasmGenerator::convertCallInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
   {
     auto &instructions = wasmFunc.instructions;
 
     llvm::CallInst *callInst = llvm::cast<llvm::CallInst>(inst);
+    if (callInst->getCalledFunction() && callInst->getCalledFunction()->isIntrinsic())
+    {
+      return convertIntrinsicCall(callInst, wasmFunc);
+    }
 
     // 引数をスタックにプッシュ
     for (auto &arg : callInst->args())
     {
-      if (llvm::isa<llvm::ConstantInt>(arg))
+      if (!pushValue(arg, wasmFunc))
       {
-        llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(arg);
-        instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
+        return false;
       }
     }
 
@@ -507,12 +991,180 @@ namespace asmtowasm
     if (calledFunc)
     {
       auto it = functionMap_.find(calledFunc);
+      if (it != functionMap_.end() && isReturnCall(inst))
+      {
+        // 呼び出し先の戻り値がそのまま戻り値になる
+        instructions.push_back(WasmInstruction(WasmOpcode::RETURN_CALL, it->second));
+        return true;
+      }
       if (it != functionMap_.end())
       {
         instructions.push_back(WasmInstruction(WasmOpcode::CALL, it->second));
+
+        // 戻り値はローカルへ（使われなければ捨てる。複数の戻り値は要素ごと）
+        if (callInst->use_empty())
+        {
+          std::vector<WasmType> results;
+          appendWasmTypes(callInst->getType(), results);
+          for (size_t i = 0; i < results.size(); ++i)
+          {
+            instructions.push_back(WasmInstruction(WasmOpcode::DROP));
+          }
+        }
+        else
+        {
+          emitSetLocals(inst, wasmFunc);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool WasmGenerator::convertIntrinsicCall(llvm::CallInst *call, WasmFunction &wasmFunc)
+  {
+    auto &instructions = wasmFunc.instructions;
+    llvm::Type *type = call->getType();
+    const llvm::Intrinsic::ID id = call->getCalledFunction()->getIntrinsicID();
+    const bool fullWidth = type->isIntegerTy(32) || type->isIntegerTy(64);
+
+    switch (id)
+    {
+    case llvm::Intrinsic::smax:
+    case llvm::Intrinsic::smin:
+    case llvm::Intrinsic::umax:
+    case llvm::Intrinsic::umin:
+    {
+      // select(a, b, a > b) の形に展開
+      llvm::Value *left = call->getArgOperand(0);
+      llvm::Value *right = call->getArgOperand(1);
+      const bool isSigned = id == llvm::Intrinsic::smax || id == llvm::Intrinsic::smin;
+      const bool isMax = id == llvm::Intrinsic::smax || id == llvm::Intrinsic::umax;
+      if (!pushValue(left, wasmFunc) || !pushValue(right, wasmFunc) ||
+          !(isSigned ? pushSignExtended(left, wasmFunc) : pushValue(left, wasmFunc)) ||
+          !(isSigned ? pushSignExtended(right, wasmFunc) : pushValue(right, wasmFunc)))
+      {
+        return false;
+      }
+      if (isSigned)
+      {
+        instructions.push_back(WasmInstruction(isMax ? selectOpcode(type, WasmOpcode::I32_GT_S, WasmOpcode::I64_GT_S)
+                                                     : selectOpcode(type, WasmOpcode::I32_LT_S, WasmOpcode::I64_LT_S)));
+      }
+      else
+      {
+        instructions.push_back(WasmInstruction(isMax ? selectOpcode(type, WasmOpcode::I32_GT_U, WasmOpcode::I64_GT_U)
+                                                     : selectOpcode(type, WasmOpcode::I32_LT_U, WasmOpcode::I64_LT_U)));
+      }
+      instructions.push_back(WasmInstruction(WasmOpcode::SELECT));
+      break;
+    }
+    case llvm::Intrinsic::abs:
+    {
+      // select(x, 0 - x, x >= 0)
+      llvm::Value *operand = call->getArgOperand(0);
+      const WasmOpcode constOp = selectOpcode(type, WasmOpcode::I32_CONST, WasmOpcode::I64_CONST);
+      if (!pushValue(operand, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(constOp, 0));
+      if (!pushValue(operand, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_SUB, WasmOpcode::I64_SUB)));
+      emitWrap(type, wasmFunc);
+      if (!pushSignExtended(operand, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(constOp, 0));
+      instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_GE_S, WasmOpcode::I64_GE_S)));
+      instructions.push_back(WasmInstruction(WasmOpcode::SELECT));
+      break;
+    }
+    case llvm::Intrinsic::ctpop:
+    case llvm::Intrinsic::ctlz:
+    case llvm::Intrinsic::cttz:
+    {
+      if (!fullWidth)
+      {
+        errorMessage_ = "未対応の組み込み関数の整数幅: " + call->getCalledFunction()->getName().str();
+        return false;
+      }
+      if (!pushValue(call->getArgOperand(0), wasmFunc))
+      {
+        return false;
+      }
+      if (id == llvm::Intrinsic::ctpop)
+        instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_POPCNT, WasmOpcode::I64_POPCNT)));
+      else if (id == llvm::Intrinsic::ctlz)
+        instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_CLZ, WasmOpcode::I64_CLZ)));
+      else
+        instructions.push_back(WasmInstruction(selectOpcode(type, WasmOpcode::I32_CTZ, WasmOpcode::I64_CTZ)));
+      break;
+    }
+    case llvm::Intrinsic::fshl:
+    case llvm::Intrinsic::fshr:
+    {
+      // 同じ値同士のファネルシフトは回転
+      llvm::Value *high = call->getArgOperand(0);
+      llvm::Value *low = call->getArgOperand(1);
+      llvm::Value *amount = call->getArgOperand(2);
+      if (fullWidth && high == low)
+      {
+        if (!pushValue(high, wasmFunc) || !pushValue(amount, wasmFunc))
+        {
+          return false;
+        }
+        instructions.push_back(WasmInstruction(id == llvm::Intrinsic::fshl
+                                                   ? selectOpcode(type, WasmOpcode::I32_ROTL, WasmOpcode::I64_ROTL)
+                                                   : selectOpcode(type, WasmOpcode::I32_ROTR, WasmOpcode::I64_ROTR)));
+        break;
+      }
+      if (!type->isIntegerTy(32))
+      {
+        errorMessage_ = "未対応のファネルシフト: " + call->getCalledFunction()->getName().str();
+        return false;
+      }
+
+      // i32同士はi64に連結してシフトし、結果の32ビットを取り出す
+      if (!pushValue(high, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_EXTEND_I32_U));
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_CONST, 32));
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_SHL));
+      if (!pushValue(low, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_EXTEND_I32_U));
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_OR));
+      if (!pushValue(amount, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_EXTEND_I32_U));
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_CONST, 31));
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_AND));
+      if (id == llvm::Intrinsic::fshl)
+      {
+        instructions.push_back(WasmInstruction(WasmOpcode::I64_SHL));
+        instructions.push_back(WasmInstruction(WasmOpcode::I64_CONST, 32));
       }
+      instructions.push_back(WasmInstruction(WasmOpcode::I64_SHR_U));
+      instructions.push_back(WasmInstruction(WasmOpcode::I32_WRAP_I64));
+      break;
+    }
+    default:
+      errorMessage_ = "未対応の組み込み関数: " + call->getCalledFunction()->getName().str();
+      return false;
     }
 
+    instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(call)));
     return true;
   }
 
@@ -522,20 +1174,40 @@ namespace asmtowasm
 
     llvm::ReturnInst *retInst = llvm::cast<llvm::ReturnInst>(inst);
 
-    if (retInst->getNumOperands() > 0)
+    if (retInst->getNumOperands() > 0 && !pushValue(retInst->getOperand(0), wasmFunc))
     {
-      llvm::Value *retValue = retInst->getOperand(0);
-      if (llvm::isa<llvm::ConstantInt>(retValue))
-      {
-        llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(retValue);
-        instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-      }
+      return false;
     }
 
     instructions.push_back(WasmInstruction(WasmOpcode::RETURN));
     return true;
   }
 
+  bool WasmGenerator::convertInsertValueInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
+  {
+    llvm::InsertValueInst *insert = llvm::cast<llvm::InsertValueInst>(inst);
+    if (insert->getNumIndices() != 1)
+    {
+      errorMessage_ = "未対応のinsertvalue: 入れ子の構造体";
+      return false;
+    }
+
+    // 置き換える要素以外は元の構造体から写す
+    const unsigned replaced = insert->getIndices()[0];
+    const unsigned count = llvm::cast<llvm::StructType>(inst->getType())->getNumElements();
+    for (unsigned i = 0; i < count; ++i)
+    {
+      const bool ok = i == replaced ? pushValue(insert->getInsertedValueOperand(), wasmFunc)
+                                    : pushField(insert->getAggregateOperand(), i, wasmFunc);
+      if (!ok)
+      {
+        return false;
+      }
+    }
+    emitSetLocals(inst, wasmFunc);
+    return true;
+  }
+
   bool WasmGenerator::convertMemoryInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
   {
     auto &instructions = wasmFunc.instructions;
@@ -543,110 +1215,101 @@ namespace asmtowasm
     if (llvm::isa<llvm::LoadInst>(inst))
     {
       llvm::LoadInst *loadInst = llvm::cast<llvm::LoadInst>(inst);
-
-      // ポインタオペランドを処理
-      llvm::Value *ptrOperand = loadInst->getPointerOperand();
-
-      if (llvm::isa<llvm::IntToPtrInst>(ptrOperand))
+      if (isAllocaLoad(loadInst))
       {
-        // inttoptr命令の場合は、そのオペランドを処理
-        llvm::IntToPtrInst *intToPtr = llvm::cast<llvm::IntToPtrInst>(ptrOperand);
-        llvm::Value *addrOperand = intToPtr->getOperand(0);
-
-        if (llvm::isa<llvm::BinaryOperator>(addrOperand))
-        {
-          // 算術演算の結果を処理（配列アクセス）
-          llvm::BinaryOperator *binOp = llvm::cast<llvm::BinaryOperator>(addrOperand);
-          convertArithmeticInstruction(binOp, wasmFunc);
-        }
-        else if (llvm::isa<llvm::ConstantInt>(addrOperand))
-        {
-          llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(addrOperand);
-          instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-        }
-        else if (llvm::isa<llvm::LoadInst>(addrOperand))
-        {
-          llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(addrOperand);
-          uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-          instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
-        }
+        // allocaからの読み出しは使う側でlocal.getする
+        return true;
       }
-      else
+      if (auto *global = llvm::dyn_cast<llvm::GlobalVariable>(loadInst->getPointerOperand()))
       {
-        // 通常のポインタアクセス
-        uint32_t localIdx = getLocalIndex(ptrOperand);
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+        instructions.push_back(WasmInstruction(WasmOpcode::GET_GLOBAL, globalMap_.at(global)));
+        instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(inst)));
+        return true;
       }
 
-      // WebAssemblyメモリロード命令（アライメント考慮）
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_LOAD));
+      // アドレスを積んでWebAssemblyメモリロード命令、結果はローカルへ
+      // （最適化で幅の変わったアクセスは、ゼロ拡張で読むload8/load16やi64.loadにする）
+      WasmOpcode loadOp;
+      switch (loadInst->getType()->getPrimitiveSizeInBits())
+      {
+      case 8:
+        loadOp = WasmOpcode::I32_LOAD8_U;
+        break;
+      case 16:
+        loadOp = WasmOpcode::I32_LOAD16_U;
+        break;
+      case 32:
+        loadOp = WasmOpcode::I32_LOAD;
+        break;
+      case 64:
+        loadOp = WasmOpcode::I64_LOAD;
+        break;
+      default:
+        errorMessage_ = "未対応のロード幅";
+        return false;
+      }
+      uint64_t offset = 0;
+      if (!pushAddress(loadInst->getPointerOperand(), offset, wasmFunc))
+      {
+        return false;
+      }
+      instructions.push_back(WasmInstruction(loadOp, offset));
+      instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(inst)));
     }
     else if (llvm::isa<llvm::StoreInst>(inst))
     {
       llvm::StoreInst *storeInst = llvm::cast<llvm::StoreInst>(inst);
-
-      // ポインタオペランドを先にスタックへ（Wasm storeは「アドレス→値」の順）
       llvm::Value *ptrOperand = storeInst->getPointerOperand();
 
-      if (llvm::isa<llvm::IntToPtrInst>(ptrOperand))
+      if (llvm::isa<llvm::AllocaInst>(ptrOperand))
       {
-        // inttoptr命令の場合は、そのオペランドを処理
-        llvm::IntToPtrInst *intToPtr = llvm::cast<llvm::IntToPtrInst>(ptrOperand);
-        llvm::Value *addrOperand = intToPtr->getOperand(0);
-
-        if (llvm::isa<llvm::BinaryOperator>(addrOperand))
-        {
-          // 算術演算の結果を処理（配列アクセス）
-          llvm::BinaryOperator *binOp = llvm::cast<llvm::BinaryOperator>(addrOperand);
-          convertArithmeticInstruction(binOp, wasmFunc);
-        }
-        else if (llvm::isa<llvm::ConstantInt>(addrOperand))
+        // allocaへの書き込みはローカルへの代入
+        if (!pushValue(storeInst->getValueOperand(), wasmFunc))
         {
-          llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(addrOperand);
-          instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-        }
-        else if (llvm::isa<llvm::LoadInst>(addrOperand))
-        {
-          llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(addrOperand);
-          uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-          instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+          return false;
         }
+        instructions.push_back(WasmInstruction(WasmOpcode::SET_LOCAL, getLocalIndex(ptrOperand)));
+        return true;
       }
-      else
+      if (auto *global = llvm::dyn_cast<llvm::GlobalVariable>(ptrOperand))
       {
-        // 通常のポインタアクセス
-        uint32_t localIdx = getLocalIndex(ptrOperand);
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
+        if (!pushValue(storeInst->getValueOperand(), wasmFunc))
+        {
+          return false;
+        }
+        instructions.push_back(WasmInstruction(WasmOpcode::SET_GLOBAL, globalMap_.at(global)));
+        return true;
       }
 
-      // 値を後からスタックにプッシュ
-      llvm::Value *value = storeInst->getValueOperand();
-      if (llvm::isa<llvm::ConstantInt>(value))
-      {
-        llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(value);
-        instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-      }
-      else if (llvm::isa<llvm::LoadInst>(value))
-      {
-        llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(value);
-        uint32_t valLocalIdx = getLocalIndex(load->getPointerOperand());
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, valLocalIdx));
-      }
-      else if (llvm::isa<llvm::ZExtInst>(value))
+      WasmOpcode storeOp;
+      switch (storeInst->getValueOperand()->getType()->getPrimitiveSizeInBits())
       {
-        // 直前にzextをローカルに保存している前提で取り出す
-        uint32_t valLocalIdx = getLocalIndex(value);
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, valLocalIdx));
+      case 8:
+        storeOp = WasmOpcode::I32_STORE8;
+        break;
+      case 16:
+        storeOp = WasmOpcode::I32_STORE16;
+        break;
+      case 32:
+        storeOp = WasmOpcode::I32_STORE;
+        break;
+      case 64:
+        storeOp = WasmOpcode::I64_STORE;
+        break;
+      default:
+        errorMessage_ = "未対応のストア幅";
+        return false;
       }
-      else if (llvm::isa<llvm::Instruction>(value))
+
+      // Wasm storeは「アドレス→値」の順
+      uint64_t offset = 0;
+      if (!pushAddress(ptrOperand, offset, wasmFunc) || !pushValue(storeInst->getValueOperand(), wasmFunc))
       {
-        // 算術命令などで生成したSSA値を再利用
-        uint32_t valLocalIdx = getLocalIndex(value);
-        instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, valLocalIdx));
+        return false;
       }
 
-      // WebAssemblyメモリストア命令（アライメント考慮）
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_STORE));
+      // WebAssemblyメモリストア命令（定数の変位はoffset=）
+      instructions.push_back(WasmInstruction(storeOp, offset));
     }
 
     return true;
@@ -672,6 +1335,16 @@ namespace asmtowasm
     return index;
   }
 
+  uint32_t WasmGenerator::assignLocalIndices(llvm::Value *value, WasmFunction &wasmFunc)
+  {
+    std::vector<WasmType> types;
+    appendWasmTypes(value->getType(), types);
+    const uint32_t base = static_cast<uint32_t>(wasmFunc.params.size() + wasmFunc.locals.size());
+    wasmFunc.locals.insert(wasmFunc.locals.end(), types.begin(), types.end());
+    localMap_[value] = base;
+    return base;
+  }
+
   uint32_t WasmGenerator::getLocalIndex(llvm::Value *value)
   {
     auto it = localMap_.find(value);
@@ -738,6 +1411,15 @@ namespace asmtowasm
     }
     wast << ")\n";
 
+    // グローバルを出力
+    for (const auto &global : wasmModule_.globals)
+    {
+      const std::string type = getWasmTypeString(global.type);
+      wast << "  (global $" << global.name << " ";
+      wast << (global.isMutable ? "(mut " + type + ")" : type);
+      wast << " (" << type << ".const " << global.initialValue << "))\n";
+    }
+
     // 関数を出力
     for (const auto &func : wasmModule_.functions)
     {
@@ -761,10 +1443,15 @@ namespace asmtowasm
       wast << " (param $" << i << " " << getWasmTypeString(func.params[i]) << ")";
     }
 
-    // 戻り値
-    if (func.returnType != WasmType::VOID)
+    // 戻り値（複数の値はmulti-value）
+    if (!func.results.empty())
     {
-      wast << " (result " << getWasmTypeString(func.returnType) << ")";
+      wast << " (result";
+      for (WasmType type : func.results)
+      {
+        wast << " " << getWasmTypeString(type);
+      }
+      wast << ")";
     }
 
     // ローカル変数
@@ -792,6 +1479,16 @@ namespace asmtowasm
 
     wast << getWasmOpcodeString(inst.opcode);
 
+    // ロード/ストアのオペランドは offset=（0は省略）
+    if (inst.opcode >= WasmOpcode::I32_LOAD && inst.opcode <= WasmOpcode::I64_STORE32)
+    {
+      if (!inst.operands.empty() && inst.operands[0] != 0)
+      {
+        wast << " offset=" << inst.operands[0];
+      }
+      return wast.str();
+    }
+
     for (uint64_t operand : inst.operands)
     {
       wast << " " << operand;
@@ -859,10 +1556,18 @@ namespace asmtowasm
       return "local.get";
     case WasmOpcode::SET_LOCAL:
       return "local.set";
+    case WasmOpcode::GET_GLOBAL:
+      return "global.get";
+    case WasmOpcode::SET_GLOBAL:
+      return "global.set";
     case WasmOpcode::CALL:
       return "call";
+    case WasmOpcode::RETURN_CALL:
+      return "return_call";
     case WasmOpcode::RETURN:
       return "return";
+    case WasmOpcode::DROP:
+      return "drop";
     case WasmOpcode::BR:
       return "br";
     case WasmOpcode::BR_IF:
@@ -871,88 +1576,115 @@ namespace asmtowasm
       return "i32.load";
     case WasmOpcode::I32_STORE:
       return "i32.store";
+    case WasmOpcode::I32_LOAD8_U:
+      return "i32.load8_u";
+    case WasmOpcode::I32_LOAD16_U:
+      return "i32.load16_u";
+    case WasmOpcode::I64_LOAD:
+      return "i64.load";
+    case WasmOpcode::I32_STORE8:
+      return "i32.store8";
+    case WasmOpcode::I32_STORE16:
+      return "i32.store16";
+    case WasmOpcode::I64_STORE:
+      return "i64.store";
+    case WasmOpcode::SELECT:
+      return "select";
+    case WasmOpcode::UNREACHABLE:
+      return "unreachable";
+    case WasmOpcode::I32_REM_S:
+      return "i32.rem_s";
+    case WasmOpcode::I32_REM_U:
+      return "i32.rem_u";
+    case WasmOpcode::I32_AND:
+      return "i32.and";
+    case WasmOpcode::I32_OR:
+      return "i32.or";
+    case WasmOpcode::I32_XOR:
+      return "i32.xor";
+    case WasmOpcode::I32_SHL:
+      return "i32.shl";
+    case WasmOpcode::I32_SHR_S:
+      return "i32.shr_s";
+    case WasmOpcode::I32_SHR_U:
+      return "i32.shr_u";
+    case WasmOpcode::I32_ROTL:
+      return "i32.rotl";
+    case WasmOpcode::I32_ROTR:
+      return "i32.rotr";
+    case WasmOpcode::I32_CLZ:
+      return "i32.clz";
+    case WasmOpcode::I32_CTZ:
+      return "i32.ctz";
+    case WasmOpcode::I32_POPCNT:
+      return "i32.popcnt";
+    case WasmOpcode::I32_WRAP_I64:
+      return "i32.wrap_i64";
+    case WasmOpcode::I64_EXTEND_I32_S:
+      return "i64.extend_i32_s";
+    case WasmOpcode::I64_EXTEND_I32_U:
+      return "i64.extend_i32_u";
+    case WasmOpcode::I64_CONST:
+      return "i64.const";
+    case WasmOpcode::I64_ADD:
+      return "i64.add";
+    case WasmOpcode::I64_SUB:
+      return "i64.sub";
+    case WasmOpcode::I64_MUL:
+      return "i64.mul";
+    case WasmOpcode::I64_DIV_S:
+      return "i64.div_s";
+    case WasmOpcode::I64_DIV_U:
+      return "i64.div_u";
+    case WasmOpcode::I64_REM_S:
+      return "i64.rem_s";
+    case WasmOpcode::I64_REM_U:
+      return "i64.rem_u";
+    case WasmOpcode::I64_AND:
+      return "i64.and";
+    case WasmOpcode::I64_OR:
+      return "i64.or";
+    case WasmOpcode::I64_XOR:
+      return "i64.xor";
+    case WasmOpcode::I64_SHL:
+      return "i64.shl";
+    case WasmOpcode::I64_SHR_S:
+      return "i64.shr_s";
+    case WasmOpcode::I64_SHR_U:
+      return "i64.shr_u";
+    case WasmOpcode::I64_ROTL:
+      return "i64.rotl";
+    case WasmOpcode::I64_ROTR:
+      return "i64.rotr";
+    case WasmOpcode::I64_CLZ:
+      return "i64.clz";
+    case WasmOpcode::I64_CTZ:
+      return "i64.ctz";
+    case WasmOpcode::I64_POPCNT:
+      return "i64.popcnt";
+    case WasmOpcode::I64_EQ:
+      return "i64.eq";
+    case WasmOpcode::I64_NE:
+      return "i64.ne";
+    case WasmOpcode::I64_LT_S:
+      return "i64.lt_s";
+    case WasmOpcode::I64_LT_U:
+      return "i64.lt_u";
+    case WasmOpcode::I64_GT_S:
+      return "i64.gt_s";
+    case WasmOpcode::I64_GT_U:
+      return "i64.gt_u";
+    case WasmOpcode::I64_LE_S:
+      return "i64.le_s";
+    case WasmOpcode::I64_LE_U:
+      return "i64.le_u";
+    case WasmOpcode::I64_GE_S:
+      return "i64.ge_s";
+    case WasmOpcode::I64_GE_U:
+      return "i64.ge_u";
     default:
       return "unknown";
     }
   }
 
-  bool WasmGenerator::convertIntToPtrInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
-  {
-    auto &instructions = wasmFunc.instructions;
-
-    llvm::IntToPtrInst *intToPtr = llvm::cast<llvm::IntToPtrInst>(inst);
-
-    // WebAssemblyでは、inttoptrは単純に値をそのまま使用
-    // メモリアドレスとして扱う
-    llvm::Value *operand = intToPtr->getOperand(0);
-
-    if (llvm::isa<llvm::ConstantInt>(operand))
-    {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(operand);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-    }
-    else if (llvm::isa<llvm::LoadInst>(operand))
-    {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(operand);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
-    }
-    else if (llvm::isa<llvm::BinaryOperator>(operand))
-    {
-      // 算術演算の結果を処理
-      llvm::BinaryOperator *binOp = llvm::cast<llvm::BinaryOperator>(operand);
-      convertArithmeticInstruction(binOp, wasmFunc);
-    }
-
-    return true;
-  }
-
-  bool WasmGenerator::convertPtrToIntInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
-  {
-    auto &instructions = wasmFunc.instructions;
-
-    llvm::PtrToIntInst *ptrToInt = llvm::cast<llvm::PtrToIntInst>(inst);
-
-    // WebAssemblyでは、ptrtointは単純に値をそのまま使用
-    llvm::Value *operand = ptrToInt->getOperand(0);
-
-    if (llvm::isa<llvm::ConstantInt>(operand))
-    {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(operand);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-    }
-    else if (llvm::isa<llvm::LoadInst>(operand))
-    {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(operand);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
-    }
-
-    return true;
-  }
-
-  bool WasmGenerator::convertBitCastInstruction(llvm::Instruction *inst, WasmFunction &wasmFunc)
-  {
-    auto &instructions = wasmFunc.instructions;
-
-    llvm::BitCastInst *bitCast = llvm::cast<llvm::BitCastInst>(inst);
-
-    // WebAssemblyでは、bitcastは単純に値をそのまま使用
-    llvm::Value *operand = bitCast->getOperand(0);
-
-    if (llvm::isa<llvm::ConstantInt>(operand))
-    {
-      llvm::ConstantInt *constInt = llvm::cast<llvm::ConstantInt>(operand);
-      instructions.push_back(WasmInstruction(WasmOpcode::I32_CONST, constInt->getZExtValue()));
-    }
-    else if (llvm::isa<llvm::LoadInst>(operand))
-    {
-      llvm::LoadInst *load = llvm::cast<llvm::LoadInst>(operand);
-      uint32_t localIdx = getLocalIndex(load->getPointerOperand());
-      instructions.push_back(WasmInstruction(WasmOpcode::GET_LOCAL, localIdx));
-    }
-
-    return true;
-  }
-
 } // namespace asmtowasm
@@ -0,0 +1,124 @@
+// 行スキャナの検査
+// - 使えるすべての分類カーネルで同じトークンになる（ブロック境界の位置をずらして確かめる）
+// - 文字リテラル内のカンマ・空白・括弧・'#'は区切りやコメントにならない
+
+#include "assembly_parser.h"
+#include "line_scanner.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+  using namespace asmtowasm;
+
+  int failures = 0;
+
+  void check(bool condition, const std::string &what)
+  {
+    if (!condition)
+    {
+      std::cerr << "失敗: " << what << "\n";
+      ++failures;
+    }
+  }
+
+  struct Case
+  {
+    const char *line;
+    std::vector<std::string> tokens;
+  };
+
+  const std::vector<Case> kCases = {
+      {"mov %eax, ','", {"mov", "%eax", "','"}},
+      {"mov %eax, '('", {"mov", "%eax", "'('"}},
+      {"mov %eax, ')'", {"mov", "%eax", "')'"}},
+      {"mov %eax, '#'  # コメント", {"mov", "%eax", "'#'"}},
+      {"mov %eax, ' '", {"mov", "%eax", "' '"}},
+      {"mov %eax, '\\''", {"mov", "%eax", "'\\''"}},
+      {"mov %eax, '\\n',", {"mov", "%eax", "'\\n'"}},
+      {"add (%esi,%ebx,4), ','", {"add", "(%esi,%ebx,4)", "','"}},
+      {"mov %eax, 1  # it's ','", {"mov", "%eax", "1"}},
+      {"loop:", {"loop:"}},
+      {"", {}},
+  };
+
+  // 行の前に空白を置いてブロック境界の位置をずらした入力と、期待するトークン列
+  std::string buildInput(size_t padding, std::vector<std::vector<std::string>> &expected)
+  {
+    std::string text;
+    for (const Case &c : kCases)
+    {
+      text += std::string(padding, ' ') + c.line + "\n";
+      expected.push_back(c.tokens);
+    }
+    return text;
+  }
+
+  std::vector<std::vector<std::string>> scan(const std::string &text)
+  {
+    std::vector<std::vector<std::string>> lines;
+    std::vector<std::string_view> tokens;
+    LineScanner scanner(text.data(), text.size());
+    while (scanner.nextLine(tokens))
+    {
+      lines.emplace_back(tokens.begin(), tokens.end());
+    }
+    return lines;
+  }
+}
+
+int main()
+{
+  std::vector<std::string> kernels;
+  for (const char *name : {"scalar", "sse2", "avx2"})
+  {
+    if (LineScanner::useKernel(name))
+    {
+      kernels.push_back(name);
+    }
+  }
+
+  // 分類カーネルの一致と期待するトークン
+  for (size_t padding = 0; padding < 2 * LineScanner::kBlockSize; ++padding)
+  {
+    std::vector<std::vector<std::string>> expected;
+    const std::string text = buildInput(padding, expected);
+    for (const std::string &name : kernels)
+    {
+      LineScanner::useKernel(name);
+      check(scan(text) == expected, name + " カーネル, 字下げ " + std::to_string(padding) + " のトークン");
+    }
+  }
+
+  // 文字リテラルのオペランドをパースできる
+  for (const std::string &name : kernels)
+  {
+    LineScanner::useKernel(name);
+    std::ostringstream log;
+    std::streambuf *output = std::cout.rdbuf(log.rdbuf());
+    AssemblyParser parser;
+    const bool parsed = parser.parseString("main:\n    mov %eax, ','\n    mov %ebx, '('\n    ret %eax\n");
+    std::cout.rdbuf(output);
+    check(parsed, name + " カーネルで文字リテラルをパースできる: " + parser.getErrorMessage());
+    if (parsed)
+    {
+      const InstructionTable &table = parser.getInstructions();
+      // 単独のラベル、mov、mov、ret
+      check(table.size() == 4 && table[1].operands().size() == 2 && table[1].operands()[1].immediate == ',' &&
+                table[2].operands().size() == 2 && table[2].operands()[1].immediate == '(',
+            name + " カーネルで文字リテラルの値");
+    }
+  }
+
+  if (failures != 0)
+  {
+    std::cerr << failures << " 件の検査に失敗しました\n";
+    return 1;
+  }
+  std::cout << "行スキャナの検査: すべて成功（" << kernels.size() << " カーネル）\n";
+  return 0;
+}
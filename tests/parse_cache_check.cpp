@@ -0,0 +1,168 @@
+// パースキャッシュの検査
+// - 範囲外のラベル位置や不正なスケールを持つイメージは読み込まず、テキストをパースし直す
+// - 同じソースのイメージを並行して書いても、読み込めるイメージだけが残り一時ファイルは残らない
+
+#include "assembly_parser.h"
+#include "parse_cache.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace asmtowasm;
+
+  const char *const kSource = "main:\n"
+                              "    mov %eax, (%esi,%ebx,4)\n"
+                              "loop:\n"
+                              "    add %eax, 1\n"
+                              "    cmp %eax, 10\n"
+                              "    jl loop\n"
+                              "    ret %eax\n";
+
+  std::atomic<int> failures{0};
+
+  void check(bool condition, const char *what)
+  {
+    if (!condition)
+    {
+      std::cerr << "失敗: " << what << "\n";
+      ++failures;
+    }
+  }
+
+  // キャッシュを使ってパースし、パーサーのログを返す
+  std::string parseWithCache(const std::string &file, const std::string &directory, AssemblyParser &parser)
+  {
+    std::ostringstream log;
+    std::streambuf *output = std::cout.rdbuf(log.rdbuf());
+    parser.setCacheDirectory(directory);
+    const bool parsed = parser.parseFile(file);
+    std::cout.rdbuf(output);
+    check(parsed, "パースに成功する");
+    return log.str();
+  }
+
+  // 記号IDをそろえた命令テーブルの複製（メモリオペランドのスケールを置き換える）
+  InstructionTable copyWithScale(const InstructionTable &table, uint8_t scale)
+  {
+    InstructionTable copy;
+    for (uint32_t id = 0; id < table.symbols().size(); ++id)
+    {
+      copy.symbols().intern(table.symbolName(id));
+    }
+    std::vector<Operand> operands;
+    for (InstructionView view : table)
+    {
+      operands.assign(view.operands().begin(), view.operands().end());
+      for (Operand &operand : operands)
+      {
+        if (operand.type == OperandType::MEMORY)
+        {
+          operand.memory.scale = scale;
+        }
+      }
+      copy.append(view.type(), view.labelId(), operands.data(), operands.size());
+    }
+    return copy;
+  }
+
+  size_t countTempFiles(const std::string &directory)
+  {
+    size_t count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(directory))
+    {
+      count += entry.path().filename().string().find(".tmp") != std::string::npos;
+    }
+    return count;
+  }
+}
+
+int main()
+{
+  const std::filesystem::path root =
+      std::filesystem::temp_directory_path() / ("asmtowasm_parse_cache_check_" + std::to_string(std::random_device()()));
+  const std::string directory = (root / "cache").string();
+  const std::string file = (root / "input.asm").string();
+  std::filesystem::create_directories(root);
+  std::ofstream(file, std::ios::binary) << kSource;
+
+  const std::string source = kSource;
+  const uint64_t hash = ParseCache::hashSource(source.data(), source.size());
+  ParseCache cache(directory);
+
+  // 1回目はパースしてイメージを保存
+  AssemblyParser first;
+  check(parseWithCache(file, directory, first).find("パースキャッシュを保存") != std::string::npos,
+        "1回目はイメージを保存する");
+  const InstructionTable &table = first.getInstructions();
+  const uint32_t loop = table.symbols().find("loop");
+  const size_t loopIndex = first.getLabels().find(loop);
+  check(loop != SymbolTable::kNone && loopIndex != LabelTable::kUndefined, "ラベル loop がある");
+
+  // ラベルが命令テーブルの外を指すイメージ
+  LabelTable badLabels = first.getLabels();
+  badLabels.define(loop, table.size() + 5);
+  std::string error;
+  check(cache.store(hash, source.size(), table, badLabels, error), "範囲外のラベルのイメージを書ける");
+  {
+    InstructionTable loaded;
+    LabelTable loadedLabels;
+    check(!cache.load(hash, source.size(), loaded, loadedLabels), "範囲外のラベルのイメージは読み込まない");
+  }
+  AssemblyParser reparsed;
+  check(parseWithCache(file, directory, reparsed).find("パースキャッシュを使用") == std::string::npos,
+        "範囲外のラベルのイメージではパースし直す");
+  check(reparsed.getLabels().find(loop) == loopIndex && reparsed.getInstructions().size() == table.size(),
+        "パースし直した結果が元と同じ");
+
+  // スケールが1/2/4/8以外のイメージ
+  check(cache.store(hash, source.size(), copyWithScale(table, 3), first.getLabels(), error),
+        "不正なスケールのイメージを書ける");
+  {
+    InstructionTable loaded;
+    LabelTable loadedLabels;
+    check(!cache.load(hash, source.size(), loaded, loadedLabels), "不正なスケールのイメージは読み込まない");
+  }
+
+  // 正しいイメージを並行して書く
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 8; ++t)
+  {
+    writers.emplace_back([&]()
+                         {
+                           std::string writeError;
+                           for (int i = 0; i < 20; ++i)
+                           {
+                             check(cache.store(hash, source.size(), table, first.getLabels(), writeError),
+                                   "並行してイメージを書ける");
+                           }
+                         });
+  }
+  for (auto &writer : writers)
+  {
+    writer.join();
+  }
+  check(countTempFiles(directory) == 0, "一時ファイルが残らない");
+  AssemblyParser cached;
+  check(parseWithCache(file, directory, cached).find("パースキャッシュを使用") != std::string::npos,
+        "並行して書いたイメージを読み込む");
+  check(cached.getLabels().find(loop) == loopIndex && cached.getInstructions().size() == table.size(),
+        "読み込んだ結果が元と同じ");
+
+  std::filesystem::remove_all(root);
+  if (failures != 0)
+  {
+    std::cerr << failures.load() << " 件の検査に失敗しました\n";
+    return 1;
+  }
+  std::cout << "パースキャッシュの検査: すべて成功\n";
+  return 0;
+}